@@ -0,0 +1,46 @@
+#include "Boot.h"
+#include "Scheduler.h"
+#include "Debug.h"
+
+static const char* const bootPhaseNames[BOOT_PHASE_COUNT] = {
+    "wifi", "ntp", "mqtt", "portal", "sensor", "control"
+};
+
+static uint64_t bootStartMs = 0;
+static uint32_t bootDurations[BOOT_PHASE_COUNT] = {0};
+static bool bootDone[BOOT_PHASE_COUNT] = {false};
+
+void bootStart() {
+    bootStartMs = millis64();
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        bootDurations[i] = 0;
+        bootDone[i] = false;
+    }
+}
+
+void bootPhaseDone(BootPhase phase) {
+    if (phase >= BOOT_PHASE_COUNT || bootDone[phase]) return;
+
+    bootDurations[phase] = (uint32_t)(millis64() - bootStartMs);
+    bootDone[phase] = true;
+    logPrintf(LOG_INFO, LOG_SYSTEM, "Opstartfase %s klaar na %u ms", bootPhaseNames[phase], (unsigned)bootDurations[phase]);
+}
+
+bool bootPhaseCompleted(BootPhase phase) {
+    return phase < BOOT_PHASE_COUNT && bootDone[phase];
+}
+
+bool bootCompleted() {
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if (!bootDone[i]) return false;
+    }
+    return true;
+}
+
+uint32_t bootPhaseDuration(BootPhase phase) {
+    return phase < BOOT_PHASE_COUNT ? bootDurations[phase] : 0;
+}
+
+const char* bootPhaseName(BootPhase phase) {
+    return phase < BOOT_PHASE_COUNT ? bootPhaseNames[phase] : "?";
+}
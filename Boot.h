@@ -0,0 +1,31 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <Arduino.h>
+
+// Fasen van de opstart. Ze starten tegelijk en worden los van elkaar afgerond.
+enum BootPhase {
+    BOOT_WIFI,      // WiFi verbonden
+    BOOT_NTP,       // Tijd gesynchroniseerd
+    BOOT_MQTT,      // Broker verbonden
+    BOOT_PORTAL,    // mDNS en webserver gestart
+    BOOT_SENSOR,    // Eerste geldige buffertemperatuur
+    BOOT_CONTROL,   // Eerste regelactie van PumpMaster
+    BOOT_PHASE_COUNT
+};
+
+// Alle fasen laten starten op het huidige moment
+void bootStart();
+
+// Fase afronden; een tweede aanroep wordt genegeerd
+void bootPhaseDone(BootPhase phase);
+
+bool bootPhaseCompleted(BootPhase phase);
+bool bootCompleted();
+
+// Duur van een fase in ms vanaf bootStart(), 0 als de fase nog loopt
+uint32_t bootPhaseDuration(BootPhase phase);
+
+const char* bootPhaseName(BootPhase phase);
+
+#endif // BOOT_H
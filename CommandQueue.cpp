@@ -0,0 +1,28 @@
+#include "CommandQueue.h"
+#include <atomic>
+
+const uint32_t COMMAND_QUEUE_SIZE = 16; // Macht van 2
+
+static Command commands[COMMAND_QUEUE_SIZE];
+static std::atomic<uint32_t> commandHead(0); // Alleen geschreven door de lezer
+static std::atomic<uint32_t> commandTail(0); // Alleen geschreven door de schrijver
+
+bool pushCommand(const Command& command) {
+    uint32_t tail = commandTail.load(std::memory_order_relaxed);
+    if (tail - commandHead.load(std::memory_order_acquire) >= COMMAND_QUEUE_SIZE) {
+        return false;
+    }
+    commands[tail % COMMAND_QUEUE_SIZE] = command;
+    commandTail.store(tail + 1, std::memory_order_release); // Opdracht zichtbaar maken na het wegschrijven
+    return true;
+}
+
+bool popCommand(Command& command) {
+    uint32_t head = commandHead.load(std::memory_order_relaxed);
+    if (head == commandTail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    command = commands[head % COMMAND_QUEUE_SIZE];
+    commandHead.store(head + 1, std::memory_order_release); // Plaats pas vrijgeven na het lezen
+    return true;
+}
@@ -0,0 +1,25 @@
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <Arduino.h>
+
+// Opdrachten van de portal (netwerktaak) aan de regeltaak
+enum CommandType : uint8_t {
+    CMD_TOGGLE_RELAY,   // index = relais
+    CMD_SET_MANUAL      // value = handmatig aan/uit
+};
+
+struct Command {
+    CommandType type;
+    uint8_t index;
+    bool value;
+};
+
+// Wachtrij zonder locks voor precies één schrijver (netwerktaak) en één lezer (regeltaak).
+// Geeft false als de wachtrij vol is.
+bool pushCommand(const Command& command);
+
+// Volgende opdracht ophalen; false als de wachtrij leeg is
+bool popCommand(Command& command);
+
+#endif // COMMANDQUEUE_H
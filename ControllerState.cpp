@@ -0,0 +1,102 @@
+#include "ControllerState.h"
+#include <ArduinoJson.h>
+#include <atomic>
+
+// Seqlock: de regeltaak is de enige schrijver. Een oneven volgnummer betekent dat er geschreven wordt;
+// lezers op de andere core kopiëren opnieuw als het volgnummer tijdens het kopiëren veranderde.
+static ControllerState currentState;
+static uint32_t stateVersion = 0;
+static std::atomic<uint32_t> stateSequence(0);
+
+// Temperaturen in stappen van 0,1 °C en draaitijden per minuut vergelijken,
+// zodat ruis en de doorlopende draaitijd niet elke seconde een nieuwe versie geven
+static bool temperatureDiffers(float a, bool aValid, float b, bool bValid) {
+    if (aValid != bValid) return true;
+    return aValid && lroundf(a * 10.0) != lroundf(b * 10.0);
+}
+
+static bool stateDiffers(const ControllerState& a, const ControllerState& b) {
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (a.relayStatus[i] != b.relayStatus[i] ||
+            a.lastOnTimes[i] != b.lastOnTimes[i] ||
+            a.lastOffTimes[i] != b.lastOffTimes[i]) {
+            return true;
+        }
+    }
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        if (a.runtimeSeconds[i] / 60 != b.runtimeSeconds[i] / 60) return true;
+    }
+    return temperatureDiffers(a.bufferTemperature, a.bufferValid, b.bufferTemperature, b.bufferValid) ||
+           temperatureDiffers(a.outdoorTemperature, a.outdoorValid, b.outdoorTemperature, b.outdoorValid) ||
+           a.cooling != b.cooling || a.manualMode != b.manualMode ||
+           a.wifiConnected != b.wifiConnected || a.mqttConnected != b.mqttConnected || a.alarm != b.alarm;
+}
+
+void setControllerState(const ControllerState& state) {
+    // Vergelijken mag zonder lock: alleen de schrijver verandert currentState
+    bool changed = stateVersion == 0 || stateDiffers(state, currentState);
+
+    uint32_t sequence = stateSequence.load(std::memory_order_relaxed);
+    stateSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    currentState = state;
+    if (changed) stateVersion++;
+
+    stateSequence.store(sequence + 2, std::memory_order_release);
+}
+
+uint32_t getControllerState(ControllerState& state) {
+    uint32_t version;
+    uint32_t before;
+    uint32_t after;
+    do {
+        before = stateSequence.load(std::memory_order_acquire);
+        state = currentState;
+        version = stateVersion;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = stateSequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    return version;
+}
+
+uint32_t getStateVersion() {
+    ControllerState state;
+    return getControllerState(state);
+}
+
+size_t serializeControllerState(const ControllerState& state, uint32_t version, char* buffer, size_t size) {
+    StaticJsonDocument<1024> doc;
+    doc["v"] = version;
+
+    JsonArray relays = doc.createNestedArray("relays");
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        JsonObject relay = relays.createNestedObject();
+        relay["on"] = state.relayStatus[i];
+        relay["last_on"] = state.lastOnTimes[i];
+        relay["last_off"] = state.lastOffTimes[i];
+    }
+
+    // Eén decimaal, gelijk aan de stapgrootte van het versienummer
+    if (state.bufferValid) doc["buffer"] = lroundf(state.bufferTemperature * 10.0) / 10.0;
+    else doc["buffer"] = nullptr;
+    if (state.outdoorValid) doc["outdoor"] = lroundf(state.outdoorTemperature * 10.0) / 10.0;
+    else doc["outdoor"] = nullptr;
+
+    doc["mode"] = state.cooling ? "Koelen" : "Verwarmen";
+    doc["manual"] = state.manualMode;
+
+    JsonArray runtimes = doc.createNestedArray("runtime_min");
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        runtimes.add(state.runtimeSeconds[i] / 60);
+    }
+
+    JsonObject health = doc.createNestedObject("health");
+    health["wifi"] = state.wifiConnected;
+    health["mqtt"] = state.mqttConnected;
+    health["sensor"] = state.bufferValid;
+    health["alarm"] = state.alarm;
+
+    if (measureJson(doc) >= size) return 0;
+    return serializeJson(doc, buffer, size);
+}
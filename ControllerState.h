@@ -0,0 +1,52 @@
+#ifndef CONTROLLERSTATE_H
+#define CONTROLLERSTATE_H
+
+#include <Arduino.h>
+#include "PumpConfig.h"
+#include "Outputs.h"
+
+// Kengetallen van de cascade
+struct StagingMetrics {
+    uint8_t demandPumps;           // Aantal pompen dat de regeling nu wil laten draaien
+    float bufferSlope;             // Helling van de buffertemperatuur in °C per minuut
+    float startsPerHour;           // Pompstarts in het laatste volle venster, omgerekend naar een uur
+    uint32_t totalStarts;          // Pompstarts sinds het opstarten
+    uint32_t recoveries;           // Afgeronde inhaalslagen
+    unsigned long lastRecoveryMs;  // Duur van de laatste inhaalslag: van buiten de band tot het doel
+    unsigned long maxRecoveryMs;   // Langste inhaalslag sinds het opstarten
+    bool recovering;               // Inhaalslag bezig
+};
+
+// Momentopname van alles wat de regelaar naar buiten meldt (MQTT, portal)
+struct ControllerState {
+    bool relayStatus[RELAY_COUNT];
+    unsigned long lastOnTimes[RELAY_COUNT];
+    unsigned long lastOffTimes[RELAY_COUNT];
+    float bufferTemperature;
+    bool bufferValid;
+    float outdoorTemperature;
+    bool outdoorValid;
+    bool cooling;                          // true = Koelen, false = Verwarmen
+    bool manualMode;                       // Relais handmatig geschakeld via de portal
+    unsigned long runtimeSeconds[PUMP_COUNT];
+    StagingMetrics staging;                // Telt niet mee voor het versienummer
+    OutputStats outputs;                   // Schakelingen per kanaal; telt niet mee voor het versienummer
+
+    // Gezondheid
+    bool wifiConnected;
+    bool mqttConnected;
+    bool alarm;                            // Buffertemperatuur te lang ongeldig
+};
+
+// Nieuwe toestand vastleggen. Het versienummer gaat alleen omhoog als er iets zichtbaars veranderd is.
+// Alleen aanroepen vanuit de regeltaak.
+void setControllerState(const ControllerState& state);
+
+// Laatst vastgelegde toestand en het bijbehorende versienummer. Veilig vanaf elke taak of core.
+uint32_t getControllerState(ControllerState& state);
+uint32_t getStateVersion();
+
+// Compacte JSON-weergave voor /api/state. Geeft de lengte terug, 0 als de buffer te klein is.
+size_t serializeControllerState(const ControllerState& state, uint32_t version, char* buffer, size_t size);
+
+#endif // CONTROLLERSTATE_H
@@ -1,14 +1,87 @@
 #include "Debug.h"
+#include <stdarg.h>
 
-String debugLog = "";
 String rebootReason = "";
 
-void debugPrint(const String& msg) {
-    Serial.println(msg); // optioneel, voor als USB ooit terugkomt
-    debugLog += msg + "<br>";
+static LogRecord logRecords[LOG_RECORD_COUNT];
+static uint32_t logNextSequence = 0;  // Volgnummer van de volgende regel
+static LogLevel logLevels[LOG_SUBSYSTEM_COUNT] = {LOG_INFO, LOG_INFO, LOG_INFO, LOG_INFO, LOG_INFO};
+static portMUX_TYPE logLock = portMUX_INITIALIZER_UNLOCKED;
 
-    // Beperk lengte
-    if (debugLog.length() > 1000) {
-        debugLog = debugLog.substring(debugLog.length() - 1000);
+static const char* const logLevelNames[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+static const char* const logSubsystemNames[LOG_SUBSYSTEM_COUNT] = {"system", "sensors", "pumps", "mqtt", "portal"};
+
+void logPrintf(LogLevel level, LogSubsystem subsystem, const char* format, ...) {
+    if (subsystem >= LOG_SUBSYSTEM_COUNT || level < logLevels[subsystem]) return;
+
+    // Opmaken buiten de lock, op de stack
+    char message[LOG_MESSAGE_LENGTH];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    uint32_t timestamp = millis();
+
+    portENTER_CRITICAL(&logLock);
+    LogRecord& record = logRecords[logNextSequence % LOG_RECORD_COUNT];
+    record.sequence = logNextSequence++;
+    record.timestampMs = timestamp;
+    record.level = level;
+    record.subsystem = subsystem;
+    memcpy(record.message, message, sizeof(message));
+    portEXIT_CRITICAL(&logLock);
+
+    // Optioneel, voor als USB ooit terugkomt. Zonder printf: dat gebruikt op de ESP32 de heap boven 64 bytes.
+    Serial.write('[');
+    Serial.write(logSubsystemNames[subsystem]);
+    Serial.write("] ");
+    Serial.write(reinterpret_cast<const uint8_t*>(message), strlen(message));
+    Serial.write('\n');
+}
+
+void setLogLevel(LogSubsystem subsystem, LogLevel level) {
+    if (subsystem < LOG_SUBSYSTEM_COUNT) {
+        logLevels[subsystem] = level;
+    }
+}
+
+LogIterator logBegin() {
+    portENTER_CRITICAL(&logLock);
+    uint32_t oldest = logNextSequence > LOG_RECORD_COUNT ? logNextSequence - LOG_RECORD_COUNT : 0;
+    portEXIT_CRITICAL(&logLock);
+
+    LogIterator iterator = {oldest};
+    return iterator;
+}
+
+LogIterator logFrom(uint32_t sequence) {
+    LogIterator iterator = {sequence};
+    return iterator;
+}
+
+bool logNext(LogIterator& iterator, LogRecord& record) {
+    portENTER_CRITICAL(&logLock);
+    if (iterator.nextSequence >= logNextSequence) {
+        portEXIT_CRITICAL(&logLock);
+        return false;
+    }
+
+    // Lezer te ver achter: doorgaan bij de oudste regel die er nog is
+    if (logNextSequence - iterator.nextSequence > LOG_RECORD_COUNT) {
+        iterator.nextSequence = logNextSequence - LOG_RECORD_COUNT;
     }
+    record = logRecords[iterator.nextSequence % LOG_RECORD_COUNT];
+    portEXIT_CRITICAL(&logLock);
+
+    iterator.nextSequence++;
+    return true;
+}
+
+const char* logLevelName(LogLevel level) {
+    return level <= LOG_ERROR ? logLevelNames[level] : "?";
+}
+
+const char* logSubsystemName(LogSubsystem subsystem) {
+    return subsystem < LOG_SUBSYSTEM_COUNT ? logSubsystemNames[subsystem] : "?";
 }
@@ -3,8 +3,55 @@
 
 #include <Arduino.h>
 extern String rebootReason;
-extern String debugLog;
 
-void debugPrint(const String& msg);
+// Ernst van een logregel
+enum LogLevel : uint8_t {
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_WARN,
+    LOG_ERROR
+};
+
+// Onderdeel waar een logregel vandaan komt; per onderdeel is het niveau in te stellen
+enum LogSubsystem : uint8_t {
+    LOG_SYSTEM,
+    LOG_SENSORS,
+    LOG_PUMPS,
+    LOG_MQTT,
+    LOG_PORTAL,
+    LOG_SUBSYSTEM_COUNT
+};
+
+#define LOG_MESSAGE_LENGTH 96
+#define LOG_RECORD_COUNT 64
+
+// Eén regel in de ringbuffer
+struct LogRecord {
+    uint32_t sequence;      // Oplopend volgnummer, ook na het overschrijven van oude regels
+    uint32_t timestampMs;   // millis() bij het loggen
+    LogLevel level;
+    LogSubsystem subsystem;
+    char message[LOG_MESSAGE_LENGTH];
+};
+
+// Positie van een lezer in de ringbuffer
+struct LogIterator {
+    uint32_t nextSequence;
+};
+
+// Regel loggen met printf-opmaak. Gebruikt geen heap en mag vanuit meerdere taken worden aangeroepen.
+void logPrintf(LogLevel level, LogSubsystem subsystem, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+// Minimaal niveau per onderdeel (standaard LOG_INFO)
+void setLogLevel(LogSubsystem subsystem, LogLevel level);
+
+// Lezen: logBegin() start bij de oudste regel die nog in de buffer staat, logFrom() bij een bekend volgnummer.
+// logNext() kopieert de volgende regel en geeft false als er geen nieuwe regels meer zijn.
+LogIterator logBegin();
+LogIterator logFrom(uint32_t sequence);
+bool logNext(LogIterator& iterator, LogRecord& record);
+
+const char* logLevelName(LogLevel level);
+const char* logSubsystemName(LogSubsystem subsystem);
 
 #endif
@@ -0,0 +1,209 @@
+#include "Events.h"
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include <lwip/sockets.h>
+#include "ControllerState.h"
+#include "Debug.h"
+
+const int EVENT_MAX_CLIENTS = 4;
+const int EVENT_QUEUE_LENGTH = 4;          // Berichten per kijker voordat die wordt afgekoppeld
+const size_t EVENT_FRAME_SIZE = 640;          // Ruim voor de volledige toestand
+const unsigned long EVENT_PING_INTERVAL = 15000;
+
+struct EventFrame {
+    uint16_t length;
+    char data[EVENT_FRAME_SIZE];
+};
+
+struct EventClient {
+    bool active;
+    WiFiClient client;
+    EventFrame queue[EVENT_QUEUE_LENGTH];
+    uint8_t head;          // Oudste bericht
+    uint8_t count;         // Berichten in de wachtrij
+    uint16_t sentOffset;   // Al verstuurde bytes van het oudste bericht
+};
+
+static EventClient eventClients[EVENT_MAX_CLIENTS];
+static EventStats eventStats = {0, 0, 0};
+static ControllerState lastSentState;
+static uint32_t lastSentVersion = 0;
+static unsigned long lastPing = 0;
+
+static void dropClient(EventClient& slot, const char* reason) {
+    slot.client.stop();
+    slot.active = false;
+    slot.count = 0;
+    eventStats.clients--;
+    logPrintf(LOG_INFO, LOG_PORTAL, "Events-kijker afgekoppeld: %s", reason);
+}
+
+// Bericht achteraan de wachtrij; een volle wachtrij betekent een te trage kijker
+static void enqueue(EventClient& slot, const char* data, size_t length) {
+    if (slot.count == EVENT_QUEUE_LENGTH) {
+        eventStats.clientsDropped++;
+        dropClient(slot, "wachtrij vol");
+        return;
+    }
+    EventFrame& frame = slot.queue[(slot.head + slot.count) % EVENT_QUEUE_LENGTH];
+    memcpy(frame.data, data, length);
+    frame.length = length;
+    slot.count++;
+}
+
+static void enqueueAll(const char* data, size_t length) {
+    for (int i = 0; i < EVENT_MAX_CLIENTS; i++) {
+        if (eventClients[i].active) enqueue(eventClients[i], data, length);
+    }
+}
+
+// SSE-bericht opbouwen rond een JSON-document
+static size_t formatFrame(char* frame, size_t size, const char* event, const char* json) {
+    int length = snprintf(frame, size, "event: %s\ndata: %s\n\n", event, json);
+    return (length > 0 && (size_t)length < size) ? length : 0;
+}
+
+// Alleen de velden die verschillen van de laatst verstuurde toestand
+static size_t serializeDelta(const ControllerState& state, uint32_t version, char* buffer, size_t size) {
+    StaticJsonDocument<1024> doc;
+    doc["v"] = version;
+
+    JsonObject relays;
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (state.relayStatus[i] == lastSentState.relayStatus[i] &&
+            state.lastOnTimes[i] == lastSentState.lastOnTimes[i] &&
+            state.lastOffTimes[i] == lastSentState.lastOffTimes[i]) {
+            continue;
+        }
+        if (relays.isNull()) relays = doc.createNestedObject("relays");
+        JsonObject relay = relays.createNestedObject(String(i));
+        relay["on"] = state.relayStatus[i];
+        relay["last_on"] = state.lastOnTimes[i];
+        relay["last_off"] = state.lastOffTimes[i];
+    }
+
+    if (state.bufferValid != lastSentState.bufferValid || lroundf(state.bufferTemperature * 10.0) != lroundf(lastSentState.bufferTemperature * 10.0)) {
+        if (state.bufferValid) doc["buffer"] = lroundf(state.bufferTemperature * 10.0) / 10.0;
+        else doc["buffer"] = nullptr;
+    }
+    if (state.outdoorValid != lastSentState.outdoorValid || lroundf(state.outdoorTemperature * 10.0) != lroundf(lastSentState.outdoorTemperature * 10.0)) {
+        if (state.outdoorValid) doc["outdoor"] = lroundf(state.outdoorTemperature * 10.0) / 10.0;
+        else doc["outdoor"] = nullptr;
+    }
+    if (state.cooling != lastSentState.cooling) doc["mode"] = state.cooling ? "Koelen" : "Verwarmen";
+    if (state.manualMode != lastSentState.manualMode) doc["manual"] = state.manualMode;
+
+    bool runtimesChanged = false;
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        runtimesChanged |= state.runtimeSeconds[i] / 60 != lastSentState.runtimeSeconds[i] / 60;
+    }
+    if (runtimesChanged) {
+        JsonArray runtimes = doc.createNestedArray("runtime_min");
+        for (int i = 0; i < PUMP_COUNT; i++) runtimes.add(state.runtimeSeconds[i] / 60);
+    }
+
+    if (state.wifiConnected != lastSentState.wifiConnected || state.mqttConnected != lastSentState.mqttConnected ||
+        state.bufferValid != lastSentState.bufferValid || state.alarm != lastSentState.alarm) {
+        JsonObject health = doc.createNestedObject("health");
+        health["wifi"] = state.wifiConnected;
+        health["mqtt"] = state.mqttConnected;
+        health["sensor"] = state.bufferValid;
+        health["alarm"] = state.alarm;
+    }
+
+    if (measureJson(doc) >= size) return 0;
+    return serializeJson(doc, buffer, size);
+}
+
+void handleEventsRequest(WebServer& server) {
+    int free = -1;
+    for (int i = 0; i < EVENT_MAX_CLIENTS; i++) {
+        if (!eventClients[i].active) {
+            free = i;
+            break;
+        }
+    }
+    if (free == -1) {
+        server.send(503, "text/plain", "Te veel kijkers");
+        return;
+    }
+
+    // Verbinding overnemen; de webserver stuurt zelf niets meer
+    EventClient& slot = eventClients[free];
+    slot.client = server.client();
+    slot.client.setNoDelay(true);
+    slot.client.print(F("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                        "Cache-Control: no-cache\r\nConnection: keep-alive\r\n\r\n"));
+    slot.active = true;
+    slot.head = 0;
+    slot.count = 0;
+    slot.sentOffset = 0;
+    eventStats.clients++;
+
+    // Eerst de volledige toestand
+    ControllerState state;
+    uint32_t version = getControllerState(state);
+    char json[600];
+    char frame[EVENT_FRAME_SIZE];
+    size_t length = serializeControllerState(state, version, json, sizeof(json));
+    length = length ? formatFrame(frame, sizeof(frame), "state", json) : 0;
+    if (length) enqueue(slot, frame, length);
+}
+
+// Zoveel versturen als de socket zonder wachten aanneemt
+static void flushClient(EventClient& slot) {
+    while (slot.active && slot.count > 0) {
+        EventFrame& frame = slot.queue[slot.head];
+        int sent = send(slot.client.fd(), frame.data + slot.sentOffset, frame.length - slot.sentOffset, MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return; // Socketbuffer vol, later verder
+            dropClient(slot, "verbinding verbroken");
+            return;
+        }
+
+        slot.sentOffset += sent;
+        if (slot.sentOffset < frame.length) return;
+
+        slot.sentOffset = 0;
+        slot.head = (slot.head + 1) % EVENT_QUEUE_LENGTH;
+        slot.count--;
+        eventStats.framesSent++;
+    }
+}
+
+void loopEvents() {
+    if (eventStats.clients == 0) {
+        lastSentVersion = getControllerState(lastSentState); // Basis voor de eerste delta bij een nieuwe kijker
+        return;
+    }
+
+    // Nieuwe versie: alleen de verschillen versturen
+    ControllerState state;
+    uint32_t version = getControllerState(state);
+    if (version != lastSentVersion) {
+        char json[600];
+        char frame[EVENT_FRAME_SIZE];
+        size_t length = serializeDelta(state, version, json, sizeof(json));
+        length = length ? formatFrame(frame, sizeof(frame), "delta", json) : 0;
+        if (length) enqueueAll(frame, length);
+        lastSentState = state;
+        lastSentVersion = version;
+    }
+
+    // Commentaarregel houdt proxies open en laat dode verbindingen opvallen
+    if (millis() - lastPing >= EVENT_PING_INTERVAL) {
+        enqueueAll(": ping\n\n", 8);
+        lastPing = millis();
+    }
+
+    for (int i = 0; i < EVENT_MAX_CLIENTS; i++) {
+        if (eventClients[i].active) {
+            if (!eventClients[i].client.connected()) dropClient(eventClients[i], "verbinding gesloten");
+            else flushClient(eventClients[i]);
+        }
+    }
+}
+
+EventStats getEventStats() {
+    return eventStats;
+}
@@ -0,0 +1,24 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Server-Sent Events op /events. Een nieuwe kijker krijgt eerst de volledige toestand,
+// daarna alleen de velden die veranderen. Trage kijkers worden afgekoppeld in plaats van te wachten.
+
+struct EventStats {
+    uint32_t clients;        // Huidige kijkers
+    uint32_t framesSent;     // Volledig verstuurde berichten
+    uint32_t clientsDropped; // Afgekoppeld omdat de wachtrij vol liep
+};
+
+// Handler voor GET /events; neemt de verbinding over van de webserver
+void handleEventsRequest(WebServer& server);
+
+// Wijzigingen in de wachtrijen zetten en zonder blokkeren wegschrijven
+void loopEvents();
+
+EventStats getEventStats();
+
+#endif // EVENTS_H
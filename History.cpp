@@ -0,0 +1,203 @@
+#include "History.h"
+#include "Scheduler.h"
+
+static_assert(RELAY_COUNT <= 15, "Relaismasker past niet in een 16-bit monster");
+
+// Eén laag: per reeks een ring van verschillen. base is de waarde vóór het oudste monster,
+// last de waarde na het nieuwste; bij het overschrijven van het oudste monster schuift base mee.
+struct HistoryTier {
+    int16_t* samples;          // HISTORY_SERIES_COUNT ringen van capacity monsters achter elkaar
+    uint16_t capacity;
+    uint32_t intervalSeconds;
+    uint8_t ratio;             // Monsters van de fijnere laag per monster in deze laag
+    uint16_t count;
+    uint16_t head;             // Volgende schrijfpositie
+    uint64_t newestSeconds;    // Uptime van het nieuwste monster
+    int32_t base[HISTORY_SERIES_COUNT];
+    int32_t last[HISTORY_SERIES_COUNT];
+
+    // Monsters van de fijnere laag die nog verzameld worden
+    int32_t sum[HISTORY_SERIES_COUNT];
+    uint8_t valid[HISTORY_SERIES_COUNT];
+    uint16_t relayMask;
+    uint8_t collected;
+};
+
+static const uint16_t RAW_CAPACITY = 360;       // 1 uur van 10 s
+static const uint16_t MINUTE_CAPACITY = 1440;   // 24 uur van 1 minuut
+static const uint16_t QUARTER_CAPACITY = 2880;  // 30 dagen van 15 minuten
+
+static int16_t rawSamples[HISTORY_SERIES_COUNT * RAW_CAPACITY];
+static int16_t minuteSamples[HISTORY_SERIES_COUNT * MINUTE_CAPACITY];
+static int16_t quarterSamples[HISTORY_SERIES_COUNT * QUARTER_CAPACITY];
+
+// Alleen de vaste velden verschillen per laag; de rest begint leeg
+#define HISTORY_TIER(samples, capacity, intervalSeconds, ratio) \
+    {samples, capacity, intervalSeconds, ratio, 0, 0, 0, {0}, {0}, {0}, {0}, 0, 0}
+
+static HistoryTier tiers[] = {
+    HISTORY_TIER(rawSamples, RAW_CAPACITY, 10, 1),
+    HISTORY_TIER(minuteSamples, MINUTE_CAPACITY, 60, 6),
+    HISTORY_TIER(quarterSamples, QUARTER_CAPACITY, 900, 15),
+};
+static const int TIER_COUNT = sizeof(tiers) / sizeof(tiers[0]);
+
+static int16_t* ring(HistoryTier& tier, int series) {
+    return tier.samples + series * tier.capacity;
+}
+
+// Fysieke plek van het logische monster index (0 = oudste)
+static uint16_t slot(const HistoryTier& tier, uint16_t index) {
+    return (tier.head + tier.capacity - tier.count + index) % tier.capacity;
+}
+
+static uint64_t oldestSeconds(const HistoryTier& tier) {
+    return tier.newestSeconds - (uint64_t)(tier.count - 1) * tier.intervalSeconds;
+}
+
+static void append(int level, const int32_t* values, uint64_t seconds);
+
+// Monster van de fijnere laag meenemen in het gemiddelde voor deze laag
+static void collect(int level, const int32_t* values, uint64_t seconds) {
+    HistoryTier& tier = tiers[level];
+    for (int s = 0; s < HISTORY_SERIES_COUNT; s++) {
+        if (values[s] == HISTORY_GAP) continue;
+        if (s == HISTORY_RELAYS) {
+            tier.relayMask |= (uint16_t)values[s];
+        } else {
+            tier.sum[s] += values[s];
+        }
+        tier.valid[s]++;
+    }
+    if (++tier.collected < tier.ratio) return;
+
+    int32_t aggregated[HISTORY_SERIES_COUNT];
+    for (int s = 0; s < HISTORY_SERIES_COUNT; s++) {
+        if (tier.valid[s] == 0) {
+            aggregated[s] = HISTORY_GAP;
+        } else if (s == HISTORY_RELAYS) {
+            aggregated[s] = tier.relayMask;
+        } else {
+            aggregated[s] = (tier.sum[s] + (tier.sum[s] >= 0 ? tier.valid[s] / 2 : -tier.valid[s] / 2)) / tier.valid[s];
+        }
+        tier.sum[s] = 0;
+        tier.valid[s] = 0;
+    }
+    tier.relayMask = 0;
+    tier.collected = 0;
+    append(level, aggregated, seconds);
+}
+
+static void append(int level, const int32_t* values, uint64_t seconds) {
+    HistoryTier& tier = tiers[level];
+    bool full = tier.count == tier.capacity;
+
+    for (int s = 0; s < HISTORY_SERIES_COUNT; s++) {
+        int16_t* samples = ring(tier, s);
+        if (full && samples[tier.head] != HISTORY_GAP) {
+            tier.base[s] += samples[tier.head]; // Oudste monster valt weg
+        }
+        if (values[s] == HISTORY_GAP) {
+            samples[tier.head] = HISTORY_GAP;
+        } else {
+            int32_t delta = constrain(values[s] - tier.last[s], -32767, 32767);
+            samples[tier.head] = (int16_t)delta;
+            tier.last[s] += delta;
+        }
+    }
+
+    tier.head = (tier.head + 1) % tier.capacity;
+    if (!full) tier.count++;
+    tier.newestSeconds = seconds;
+
+    if (level + 1 < TIER_COUNT) collect(level + 1, values, seconds);
+}
+
+static int32_t encodeTemperature(float temperature, bool valid) {
+    return valid ? constrain(lroundf(temperature * 100.0), -32767L, 32767L) : HISTORY_GAP;
+}
+
+void recordHistory(const ControllerState& state) {
+    int32_t values[HISTORY_SERIES_COUNT];
+    values[HISTORY_BUFFER] = encodeTemperature(state.bufferTemperature, state.bufferValid);
+    values[HISTORY_OUTDOOR] = encodeTemperature(state.outdoorTemperature, state.outdoorValid);
+    int32_t relays = 0;
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (state.relayStatus[i]) relays |= 1 << i;
+    }
+    values[HISTORY_RELAYS] = relays;
+
+    append(0, values, millis64() / 1000ULL);
+}
+
+bool findHistory(HistorySeries series, uint64_t fromSeconds, uint64_t toSeconds, HistoryCursor& cursor) {
+    if (series >= HISTORY_SERIES_COUNT) return false;
+
+    // Fijnste laag die op één periode na terugreikt tot fromSeconds, anders de grofste met gegevens
+    int level = -1;
+    for (int i = 0; i < TIER_COUNT; i++) {
+        if (tiers[i].count == 0) continue;
+        level = i;
+        if (oldestSeconds(tiers[i]) <= fromSeconds + tiers[i].intervalSeconds) break;
+    }
+    if (level < 0) return false;
+
+    HistoryTier& tier = tiers[level];
+    uint64_t oldest = oldestSeconds(tier);
+    uint16_t first = 0;
+    if (fromSeconds > oldest) {
+        uint64_t skip = (fromSeconds - oldest + tier.intervalSeconds - 1) / tier.intervalSeconds;
+        first = (uint16_t)min<uint64_t>(skip, tier.count);
+    }
+    uint16_t end = tier.count;
+    if (toSeconds < tier.newestSeconds) {
+        end = toSeconds < oldest ? 0 : (uint16_t)((toSeconds - oldest) / tier.intervalSeconds + 1);
+    }
+    if (end < first) end = first;
+
+    cursor.series = series;
+    cursor.tier = level;
+    cursor.end = end;
+    cursor.intervalSeconds = tier.intervalSeconds;
+    cursor.firstSeconds = oldest + (uint64_t)first * tier.intervalSeconds;
+
+    // Verschillen optellen tot het eerste gevraagde monster
+    const int16_t* samples = ring(tier, series);
+    cursor.value = tier.base[series];
+    for (uint16_t i = 0; i < first; i++) {
+        int16_t delta = samples[slot(tier, i)];
+        if (delta != HISTORY_GAP) cursor.value += delta;
+    }
+    cursor.position = first;
+    return true;
+}
+
+uint16_t historyRemaining(const HistoryCursor& cursor) {
+    return cursor.end - cursor.position;
+}
+
+bool nextHistory(HistoryCursor& cursor, int16_t& value) {
+    if (cursor.position >= cursor.end) return false;
+
+    HistoryTier& tier = tiers[cursor.tier];
+    int16_t delta = ring(tier, cursor.series)[slot(tier, cursor.position)];
+    cursor.position++;
+    if (delta == HISTORY_GAP) {
+        value = HISTORY_GAP;
+    } else {
+        cursor.value += delta;
+        value = (int16_t)cursor.value;
+    }
+    return true;
+}
+
+bool historySeriesFromName(const char* name, HistorySeries& series) {
+    static const char* const names[HISTORY_SERIES_COUNT] = {"buffer", "outdoor", "relays"};
+    for (int i = 0; i < HISTORY_SERIES_COUNT; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            series = (HistorySeries)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,58 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <Arduino.h>
+#include "ControllerState.h"
+
+// Verloop van buffertemperatuur, buitentemperatuur en relais op het apparaat zelf, in drie lagen:
+// elke 10 s voor het laatste uur, per minuut voor 24 uur en per kwartier voor 30 dagen.
+// Elke laag is per reeks een ring van 16-bit verschillen met de vorige waarde; alles ligt vast
+// bij het compileren (ongeveer 28 kB). Temperaturen in 0,01 °C, relais als bitmasker (bit i = relais i).
+
+enum HistorySeries : uint8_t {
+    HISTORY_BUFFER,    // Buffertemperatuur, gemiddelde over de periode
+    HISTORY_OUTDOOR,   // Buitentemperatuur, gemiddelde over de periode
+    HISTORY_RELAYS,    // Relais die ergens in de periode aan stonden
+    HISTORY_SERIES_COUNT
+};
+
+const int16_t HISTORY_GAP = INT16_MIN;             // Geen geldige meting in deze periode
+const unsigned long HISTORY_SAMPLE_INTERVAL = 10000; // Aanroepritme van recordHistory() in ms
+
+// Kop van het binaire antwoord van /api/history (little-endian), gevolgd door count int16-waarden
+struct __attribute__((packed)) HistoryHeader {
+    char magic[2];             // "WH"
+    uint8_t version;           // 1
+    uint8_t series;            // HistorySeries
+    uint32_t intervalSeconds;  // Periode van één monster
+    uint32_t firstTime;        // Tijd van het eerste monster (Unix of uptime, zie X-History-Clock)
+    uint16_t count;
+};
+
+// Leespositie in één laag van één reeks
+struct HistoryCursor {
+    uint8_t series;
+    uint8_t tier;
+    uint16_t position;         // Volgende te lezen monster, 0 = oudste in de ring
+    uint16_t end;              // Eén voorbij het laatste monster in het gevraagde bereik
+    int32_t value;             // Opgetelde waarde tot en met het vorige monster
+    uint32_t intervalSeconds;  // Periode van één monster in deze laag
+    uint64_t firstSeconds;     // Uptime (s) van het eerste monster in het bereik
+};
+
+// Nieuw monster toevoegen. Eens per HISTORY_SAMPLE_INTERVAL aanroepen, altijd vanuit dezelfde taak als de lezers.
+void recordHistory(const ControllerState& state);
+
+// Fijnste laag die het bereik (uptime in seconden) dekt; geeft false als er nog niets is
+bool findHistory(HistorySeries series, uint64_t fromSeconds, uint64_t toSeconds, HistoryCursor& cursor);
+
+// Aantal monsters dat de cursor nog oplevert
+uint16_t historyRemaining(const HistoryCursor& cursor);
+
+// Volgend monster; HISTORY_GAP als er in die periode geen geldige meting was
+bool nextHistory(HistoryCursor& cursor, int16_t& value);
+
+// Naam in de URL (buffer, outdoor, relays) naar reeks; false bij een onbekende naam
+bool historySeriesFromName(const char* name, HistorySeries& series);
+
+#endif // HISTORY_H
@@ -2,95 +2,372 @@
 
 #include "MQTT.h"
 #include <ArduinoJson.h>
+#include <mdns.h>
 #include "Debug.h"
+#include "Boot.h"
+#include "Spool.h"
+#include "Metrics.h"
+#include "Supervisor.h"
+#include "TcpConnect.h"
+#include <unistd.h>
 
 WiFiClient espClient;
 PubSubClient mqttClient(espClient);
 
-// Algemene callback
-void mqttCallback(char* topic, byte* payload, unsigned int length) {
-    debugPrint("Bericht ontvangen op topic ");
-    debugPrint(topic);
-    debugPrint(": ");
+// Laatst ontvangen modus, bijgewerkt door het retained bericht op warmtepomp/mode.
+// Eén byte, dus zonder lock leesbaar vanuit de regeltaak.
+static volatile HeatPumpMode currentMode = MODE_NONE;
+
+typedef void (*TopicHandler)(const char* topic, const char* message);
+
+// Koppeling tussen een topic en de functie die het afhandelt
+struct TopicRoute {
+    const char* topic;
+    TopicHandler handler;
+};
+
+static void handleMode(const char* topic, const char* message) {
+    if (strcmp(message, "Verwarmen") == 0) {
+        currentMode = MODE_HEATING;
+    } else if (strcmp(message, "Koelen") == 0) {
+        currentMode = MODE_COOLING;
+    } else {
+        logPrintf(LOG_WARN, LOG_MQTT, "Onbekende modus ontvangen: %s", message);
+    }
+}
+
+static void handleCommand(const char* topic, const char* message) {
+    logPrintf(LOG_INFO, LOG_MQTT, "Commando ontvangen: %s", message);
+}
+
+// Draaitijd zoals de warmtepompen die zelf melden; dient alleen als eenmalige startwaarde
+static volatile unsigned long runtimeSeed[PUMP_COUNT] = {0};
+static volatile bool runtimeSeedReceived[PUMP_COUNT] = {false};
+
+static void handlePumpStatus(const char* topic, const char* message) {
+    int pumpIndex = -1;
+    if (sscanf(topic, "warmtepomp/pump/%d/status", &pumpIndex) != 1 || pumpIndex < 0 || pumpIndex >= PUMP_COUNT) {
+        return;
+    }
 
+    StaticJsonDocument<256> doc;
+    DeserializationError error = deserializeJson(doc, message);
+    if (error || !doc.containsKey("run_time")) return;
+
+    runtimeSeed[pumpIndex] = doc["run_time"].as<unsigned long>();
+    __sync_synchronize(); // Waarde zichtbaar voor de regeltaak voordat de vlag dat is
+    runtimeSeedReceived[pumpIndex] = true;
+}
+
+// Vaste abonnementen; blijven actief zolang de verbinding bestaat
+static const TopicRoute topicRoutes[] = {
+    {"warmtepomp/mode", handleMode},
+    {"warmtepomp/command", handleCommand},
+    {"warmtepomp/pump/+/status", handlePumpStatus}, // Eén abonnement voor alle pompen
+};
+static const int topicRouteCount = sizeof(topicRoutes) / sizeof(topicRoutes[0]);
+
+static void subscribeRoutes() {
+    for (int i = 0; i < topicRouteCount; i++) {
+        if (!mqttClient.subscribe(topicRoutes[i].topic)) {
+            logPrintf(LOG_ERROR, LOG_MQTT, "Abonneren mislukt op %s", topicRoutes[i].topic);
+        }
+    }
+}
+
+// Vergelijkt een topic met een filter; '+' staat voor precies één niveau
+static bool topicMatches(const char* filter, const char* topic) {
+    while (*filter && *topic) {
+        if (*filter == '+') {
+            while (*topic && *topic != '/') topic++;
+            filter++;
+        } else if (*filter++ != *topic++) {
+            return false;
+        }
+    }
+    return *filter == '\0' && *topic == '\0';
+}
+
+// Algemene callback: stuurt elk bericht door naar de handler van het topic
+void mqttCallback(char* topic, byte* payload, unsigned int length) {
     char message[256] = {0};
     length = length < 255 ? length : 255;
     memcpy(message, payload, length);
     message[length] = '\0';
-    debugPrint(message);
+
+    for (int i = 0; i < topicRouteCount; i++) {
+        if (topicMatches(topicRoutes[i].topic, topic)) {
+            topicRoutes[i].handler(topic, message);
+            return;
+        }
+    }
+
+    logPrintf(LOG_DEBUG, LOG_MQTT, "Bericht ontvangen op topic %s: %s", topic, message);
 }
 
-// MQTT initialiseren
-void setupMQTT() {
-    const char* mqttUsername = "MQTT";
-    const char* mqttPassword = "mqtt";
+// Brokergegevens
+static const char* mqttBrokerHost = "homeassistant"; // Wordt via mDNS opgezocht als homeassistant.local
+static const uint16_t mqttBrokerPort = 1883;
+static const char* mqttUsername = "MQTT";
+static const char* mqttPassword = "mqtt";
+
+// Wachttijden voor de verbindingsstatemachine
+const unsigned long MQTT_RESOLVE_TIMEOUT = 2000;
+const unsigned long MQTT_CONNECT_TIMEOUT = 3000; // TCP-verbinding opbouwen
+const unsigned long MQTT_BACKOFF_MIN = 1000;
+const unsigned long MQTT_BACKOFF_MAX = 60000;
+const int MQTT_MAX_FAILURES_CACHED_IP = 3; // Daarna het adres opnieuw opzoeken
+const int SPOOL_REPLAY_PER_TICK = 5;         // Maximaal aantal gespoolde berichten per aanroep van replaySpool()
+const int LOG_FORWARD_PER_TICK = 5;          // Maximaal aantal logregels per aanroep van publishLog()
+
+static volatile MqttConnectionState connectionState = MQTT_RESOLVING;
+static MqttConnectionStats connectionStats = {0, 0, 0, 0, 0, 0};
+
+static IPAddress brokerAddress;
+static bool brokerAddressKnown = false;
+static int failuresOnCachedAddress = 0;
+static int connectFd = -1; // Socket tot hij verbonden is; daarna van espClient
+
+static mdns_search_once_t* brokerSearch = nullptr;
+static unsigned long stateEnteredTime = 0;
+static unsigned long backoffDuration = MQTT_BACKOFF_MIN;
+static unsigned long disconnectedSince = 0;
+static unsigned long backoffUntil = 0;
+
+static void enterState(MqttConnectionState state) {
+    connectionState = state;
+    stateEnteredTime = millis();
+}
 
-    mqttClient.setServer("homeassistant.local", 1883);
-    mqttClient.setCallback(mqttCallback);
+// Volgende poging uitstellen; de wachttijd verdubbelt tot MQTT_BACKOFF_MAX, met ±25% spreiding
+static void enterBackoff() {
+    unsigned long jitter = backoffDuration / 4;
+    unsigned long wait = backoffDuration - jitter + (jitter > 0 ? esp_random() % (2 * jitter) : 0);
+    backoffDuration = min(backoffDuration * 2, MQTT_BACKOFF_MAX);
 
-    unsigned long startAttemptTime = millis();
-    const unsigned long timeout = 10000; // max 10 sec proberen
-    bool connected = false;
+    backoffUntil = millis() + wait;
+    enterState(MQTT_BACKOFF);
+}
 
-    while (!connected && millis() - startAttemptTime < timeout) {
-        debugPrint("Verbinding maken met MQTT...");
-        if (mqttClient.connect("ESP32Client", mqttUsername, mqttPassword)) {
-            debugPrint("MQTT verbonden!");
-            mqttClient.subscribe("warmtepomp/command");
-            connected = true;
-        } else {
-            Serial.print("Verbinding mislukt. Status: ");
-            debugPrint(String(mqttClient.state()));
-            delay(1000); // korte tussenpauze
+static void cancelBrokerSearch() {
+    if (brokerSearch != nullptr) {
+        mdns_query_async_delete(brokerSearch);
+        brokerSearch = nullptr;
+    }
+}
+
+// mDNS-zoekopdracht starten en later zonder wachten het resultaat ophalen
+static bool resolveBroker() {
+    if (brokerSearch == nullptr) {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+        brokerSearch = mdns_query_async_new(mqttBrokerHost, NULL, NULL, MDNS_TYPE_A, MQTT_RESOLVE_TIMEOUT, 1, NULL);
+#else
+        brokerSearch = mdns_query_async_new(mqttBrokerHost, NULL, NULL, MDNS_TYPE_A, MQTT_RESOLVE_TIMEOUT, 1);
+#endif
+        if (brokerSearch == nullptr) {
+            logPrintf(LOG_ERROR, LOG_MQTT, "mDNS-zoekopdracht naar broker kon niet starten");
+            enterBackoff();
         }
+        return false;
     }
 
-    if (!mqttClient.connected()) {
-        debugPrint("MQTT-verbinding mislukt. Doorgaan zonder MQTT.");
+    mdns_result_t* results = nullptr;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    uint8_t resultCount = 0;
+    bool finished = mdns_query_async_get_results(brokerSearch, 0, &results, &resultCount);
+#else
+    bool finished = mdns_query_async_get_results(brokerSearch, 0, &results);
+#endif
+    if (!finished) return false;
+
+    bool found = false;
+    for (mdns_result_t* r = results; r != nullptr && !found; r = r->next) {
+        for (mdns_ip_addr_t* a = r->addr; a != nullptr; a = a->next) {
+            if (a->addr.type == ESP_IPADDR_TYPE_V4) {
+                brokerAddress = IPAddress(a->addr.u_addr.ip4.addr);
+                found = true;
+                break;
+            }
+        }
+    }
+    mdns_query_results_free(results);
+    cancelBrokerSearch();
+
+    if (!found) {
+        logPrintf(LOG_WARN, LOG_MQTT, "Broker niet gevonden via mDNS");
+        enterBackoff();
+        return false;
+    }
+
+    brokerAddressKnown = true;
+    failuresOnCachedAddress = 0;
+    logPrintf(LOG_INFO, LOG_MQTT, "Broker gevonden op %u.%u.%u.%u", brokerAddress[0], brokerAddress[1], brokerAddress[2], brokerAddress[3]);
+    return true;
+}
+
+// MQTT initialiseren; de verbinding zelf wordt opgebouwd in loopMQTT()
+void setupMQTT() {
+    mqttClient.setCallback(mqttCallback);
+    // De TCP-verbinding wacht niet (zie startConnect()); dit begrenst alleen het wachten op CONNACK
+    // van een broker die de verbinding wel aanneemt maar niet antwoordt
+    mqttClient.setSocketTimeout(1);
+    espClient.setTimeout(2);
+    disconnectedSince = millis();
+    enterState(MQTT_RESOLVING);
+}
+
+static void closeConnectSocket() {
+    if (connectFd >= 0) {
+        close(connectFd);
+        connectFd = -1;
     }
 }
 
-String GetMode() { // Verwarm of koelmodes opvragen.
-    if (!mqttClient.connected()) {
-        return "Niks"; // Kan niet ophalen
+static void connectFailed(const char* reason) {
+    closeConnectSocket();
+    connectionStats.failedAttempts++;
+    logPrintf(LOG_WARN, LOG_MQTT, "MQTT-verbinding mislukt (%s). Status: %d", reason, mqttClient.state());
+    if (++failuresOnCachedAddress >= MQTT_MAX_FAILURES_CACHED_IP) {
+        brokerAddressKnown = false; // Broker heeft mogelijk een ander adres gekregen
+    }
+    enterBackoff();
+}
+
+// Socket zonder blokkeren laten verbinden; loopMQTT() kijkt elke tick of het gelukt is
+static void startConnect() {
+    connectionStats.reconnectAttempts++;
+    connectFd = tcpConnectStart((uint32_t)brokerAddress, mqttBrokerPort);
+    if (connectFd < 0) {
+        connectFailed("socket");
+        return;
+    }
+    enterState(MQTT_CONNECTING);
+}
+
+// Zodra de socket verbonden is neemt espClient hem over; PubSubClient verbindt dan niet zelf
+// maar stuurt alleen CONNECT en wacht op CONNACK
+static void connectBroker() {
+    TcpConnectStatus status = tcpConnectPoll(connectFd);
+    if (status == TCP_CONNECT_PENDING) {
+        if (millis() - stateEnteredTime >= MQTT_CONNECT_TIMEOUT) connectFailed("time-out");
+        return;
+    }
+    if (status == TCP_CONNECT_FAILED) {
+        connectFailed("tcp");
+        return;
     }
 
-    String mode = "Niks"; // Standaard: niks teruggeven
+    espClient = WiFiClient(connectFd);
+    connectFd = -1;
+    mqttClient.setServer(brokerAddress, mqttBrokerPort);
+    if (!mqttClient.connect("ESP32Client", mqttUsername, mqttPassword)) {
+        espClient.stop();
+        connectFailed("broker");
+        return;
+    }
 
-    bool received = false;
+    subscribeRoutes();
 
-    // Tijdelijke handler voor alleen het mode-topic
-    auto modeHandler = [&](char* topic, byte* payload, unsigned int length) {
-        if (strcmp(topic, "warmtepomp/mode") == 0) {
-            char message[256] = {0};
-            length = length < 255 ? length : 255;
-            memcpy(message, payload, length);
-            message[length] = '\0';
+    unsigned long now = millis();
+    connectionStats.lastTimeToConnectMs = now - disconnectedSince;
+    connectionStats.totalDisconnectedMs += now - disconnectedSince;
+    connectionStats.connectCount++;
+    backoffDuration = MQTT_BACKOFF_MIN;
+    failuresOnCachedAddress = 0;
+    enterState(MQTT_SUBSCRIBED);
+    logPrintf(LOG_INFO, LOG_MQTT, "MQTT verbonden na %u ms", (unsigned)connectionStats.lastTimeToConnectMs);
+}
 
-            String incomingMode = String(message);
+bool getRuntimeSeed(int pumpIndex, unsigned long& runtime) {
+    if (pumpIndex < 0 || pumpIndex >= PUMP_COUNT || !runtimeSeedReceived[pumpIndex]) return false;
+    runtime = runtimeSeed[pumpIndex];
+    return true;
+}
 
-            if (incomingMode == "Verwarmen" || incomingMode == "Koelen") {
-                mode = incomingMode;
-                received = true;
-            }
-        }
-    };
+HeatPumpMode GetMode() { // Verwarm of koelmodes, bijgehouden door de mode-handler.
+    return currentMode;
+}
 
-    mqttClient.setCallback(modeHandler);
+// Instellingen van de publicatielaag
+static PublishConfig publishConfig = {5UL * 60UL * 1000UL, 0.2, false, {CODEC_JSON, CODEC_JSON, CODEC_JSON}, 0};
 
-    mqttClient.subscribe("warmtepomp/mode");
+// Geeft de payload in stukken door aan mqttClient.write(). De serializer schrijft per teken;
+// rechtstreeks naar de client zou elk teken een eigen schrijfactie op de socket maken.
+class PayloadStream : public Print {
+public:
+    PayloadStream() : length(0), written(0) {}
 
-    unsigned long startTime = millis();
-    while (!received && millis() - startTime < 2000) { // Maximaal 2 seconden wachten
-        mqttClient.loop();
+    size_t write(uint8_t c) override {
+        if (length == sizeof(chunk)) send();
+        chunk[length++] = c;
+        return 1;
     }
 
-    mqttClient.unsubscribe("warmtepomp/mode");
+    size_t write(const uint8_t* data, size_t size) override {
+        for (size_t i = 0; i < size; i++) write(data[i]);
+        return size;
+    }
 
-    // Herstel oorspronkelijke callback
-    mqttClient.setCallback(mqttCallback);
+    // Restant versturen; geeft het aantal door de client aangenomen bytes terug
+    size_t finish() {
+        send();
+        return written;
+    }
+
+private:
+    void send() {
+        if (length > 0) written += mqttClient.write(chunk, length);
+        length = 0;
+    }
 
-    return mode;
+    uint8_t chunk[64];
+    size_t length;
+    size_t written;
+};
+
+// Alleen de eerste limit bytes doorgeven; voor een document waarvan het einde apart volgt
+class PrefixPrint : public Print {
+public:
+    PrefixPrint(Print& out, size_t limit) : out(out), remaining(limit) {}
+
+    size_t write(uint8_t c) override {
+        if (remaining == 0) return 1;
+        remaining--;
+        return out.write(c);
+    }
+
+private:
+    Print& out;
+    size_t remaining;
+};
+
+static bool beginPayload(const char* topic, size_t length, bool retained) {
+    if (mqttClient.beginPublish(topic, length, retained)) return true;
+    connectionStats.publishFailures++;
+    return false;
+}
+
+static bool endPayload(PayloadStream& stream, size_t length) {
+    bool complete = stream.finish() == length;
+    if (mqttClient.endPublish() && complete) return true;
+    connectionStats.publishFailures++;
+    return false;
+}
+
+// Document serialiseren in de vorm van zijn groep en direct achter de MQTT-header versturen,
+// zonder tussenbuffer voor het hele bericht. De lengte moet vooraf vast staan, dus eerst meten.
+static bool publishDocument(const char* topic, JsonDocument& doc, PayloadGroup group, bool retained) {
+    bool binary = publishConfig.codecs[group] == CODEC_MSGPACK;
+    size_t length = binary ? measureMsgPack(doc) : measureJson(doc);
+    if (!beginPayload(topic, length, retained)) return false;
+
+    PayloadStream stream;
+    if (binary) {
+        serializeMsgPack(doc, stream);
+    } else {
+        serializeJson(doc, stream);
+    }
+    return endPayload(stream, length);
 }
 
 // Test of topic actief is
@@ -107,7 +384,7 @@ bool topicExists(const char* topic) {
 void updateStarttime() {
     struct tm timeinfo;
     if (!getLocalTime(&timeinfo)) {
-        debugPrint("Kon starttijd niet verkrijgen");
+        logPrintf(LOG_WARN, LOG_MQTT, "Kon starttijd niet verkrijgen");
         return;
     }
 
@@ -116,59 +393,140 @@ void updateStarttime() {
 
     if (mqttClient.connected()) {
         if (!mqttClient.publish("warmtepomp/starttijd", timeStringBuff, true)) {
-            debugPrint("Publicatie starttijd mislukt.");
+            logPrintf(LOG_WARN, LOG_MQTT, "Publicatie starttijd mislukt.");
         } else {
-            debugPrint("Starttijd gepubliceerd op MQTT: " + String(timeStringBuff));
+            logPrintf(LOG_INFO, LOG_MQTT, "Starttijd gepubliceerd op MQTT: %s", timeStringBuff);
         }
     }
 }
 
-// Runtime data ophalen
-void getAllRuntimes(unsigned long* runtimes) {
-    if (!mqttClient.connected()) {
-        for (int i = 0; i < 3; i++) runtimes[i] = 0;
-        return;
+// Publiceer de duur van de opstartfasen
+void publishBootTimes() {
+    if (!mqttClient.connected()) return;
+
+    StaticJsonDocument<192> doc;
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        doc[bootPhaseName((BootPhase)i)] = bootPhaseDuration((BootPhase)i);
+    }
+    if (!publishDocument("warmtepomp/boot", doc, PAYLOAD_TELEMETRY, true)) {
+        logPrintf(LOG_WARN, LOG_MQTT, "Publicatie opstarttijden mislukt.");
     }
+}
 
-    bool received[3] = {false, false, false};
+// Gebeurtenis uit het spoor: [tijd, stap] bij binnenkomst, [tijd, stap, duur] bij vertrek
+static void crumbDocument(const SupervisorReport& report, const SupervisorCrumb& crumb, JsonDocument& doc) {
+    JsonArray array = doc.to<JsonArray>();
+    array.add(crumb.timeMs);
+    array.add(report.names[crumb.stage]);
+    if (crumb.event == CRUMB_EXIT) array.add(crumb.durationMs);
+}
 
-    // Tijdelijke topic handler
-    auto runtimeHandler = [&](char* topic, byte* payload, unsigned int length) {
-        StaticJsonDocument<256> doc;
-        DeserializationError error = deserializeJson(doc, payload, length);
-        if (error) return;
-
-        for (int i = 0; i < 3; i++) {
-            char expectedTopic[50];
-            snprintf(expectedTopic, sizeof(expectedTopic), "warmtepomp/pump/%d/status", i);
-            if (strcmp(topic, expectedTopic) == 0 && doc.containsKey("run_time")) {
-                runtimes[i] = doc["run_time"].as<unsigned long>();
-                received[i] = true;
-            }
+// Lengte van het spoor zoals streamTrail() het schrijft, zonder de haken; geeft ook het aantal gebeurtenissen
+static size_t measureTrail(const SupervisorReport& report, bool binary, uint8_t& count) {
+    StaticJsonDocument<64> doc;
+    SupervisorTrailCursor cursor;
+    SupervisorCrumb crumb;
+    size_t length = 0;
+    count = 0;
+    supervisorTrailBegin(report, cursor);
+    while (supervisorTrailNext(report, cursor, crumb)) {
+        if (crumb.stage >= report.stageCount) continue;
+        crumbDocument(report, crumb, doc);
+        length += binary ? measureMsgPack(doc) : measureJson(doc) + (count > 0 ? 1 : 0); // Met komma
+        count++;
+    }
+    return length;
+}
+
+static void streamTrail(const SupervisorReport& report, bool binary, Print& out) {
+    StaticJsonDocument<64> doc;
+    SupervisorTrailCursor cursor;
+    SupervisorCrumb crumb;
+    bool first = true;
+    supervisorTrailBegin(report, cursor);
+    while (supervisorTrailNext(report, cursor, crumb)) {
+        if (crumb.stage >= report.stageCount) continue;
+        crumbDocument(report, crumb, doc);
+        if (binary) {
+            serializeMsgPack(doc, out);
+        } else {
+            if (!first) out.write(',');
+            serializeJson(doc, out);
         }
-    };
+        first = false;
+    }
+}
 
-    mqttClient.setCallback(runtimeHandler);
+// Reden van de laatste herstart met de stappen die toen bezig waren, uit het RTC-geheugen van Supervisor.
+// De kop is een klein document met een leeg spoor als laatste veld; het spoor gaat daarna per
+// gebeurtenis vanuit de ringen de socket op, in plaats van eerst in één groot document.
+void publishRebootReport() {
+    if (!mqttClient.connected()) return;
 
-    for (int i = 0; i < 3; i++) {
-        char topic[50];
-        snprintf(topic, sizeof(topic), "warmtepomp/pump/%d/status", i);
-        mqttClient.subscribe(topic);
-    }
+    StaticJsonDocument<768> head; // Zes velden, misses van hooguit SUPERVISOR_STAGES stappen
+    head["reason"] = rebootReason.c_str();
 
-    unsigned long startTime = millis();
-    while ((!received[0] || !received[1] || !received[2]) && millis() - startTime < 5000) {
-        mqttClient.loop();
+    const SupervisorReport* report = getPreviousBoot();
+    if (report == nullptr) {
+        if (!publishDocument("warmtepomp/reboot", head, PAYLOAD_TELEMETRY, true)) {
+            logPrintf(LOG_WARN, LOG_MQTT, "Publicatie herstartrapport mislukt.");
+        }
+        return;
     }
 
-    for (int i = 0; i < 3; i++) {
-        char topic[50];
-        snprintf(topic, sizeof(topic), "warmtepomp/pump/%d/status", i);
-        mqttClient.unsubscribe(topic);
+    head["uptime_ms"] = report->uptimeMs;
+    if (report->hungStage >= 0) {
+        head["hung_stage"] = report->names[report->hungStage];
+        head["hung_ms"] = report->hungMs;
+    }
+    JsonObject misses = head.createNestedObject("misses");
+    for (uint8_t i = 0; i < report->stageCount; i++) {
+        if (report->misses[i] > 0) misses[report->names[i]] = report->misses[i];
+    }
+    head.createNestedArray("trail");
+
+    // Het lege spoor eindigt op "[]}" in JSON en op een lege arraykop in MessagePack; daar komt het spoor
+    bool binary = publishConfig.codecs[PAYLOAD_TELEMETRY] == CODEC_MSGPACK;
+    uint8_t count;
+    size_t trailLength = measureTrail(*report, binary, count);
+    size_t headLength;
+    uint8_t open[3];
+    size_t openLength;
+    if (binary) {
+        headLength = measureMsgPack(head) - 1;
+        openLength = 1;
+        open[0] = 0x90 | count;
+        if (count >= 16) {
+            open[0] = 0xDC;
+            open[1] = 0;
+            open[2] = count;
+            openLength = 3;
+        }
+    } else {
+        headLength = measureJson(head) - 3;
+        open[0] = '[';
+        openLength = 1;
+    }
+    size_t closeLength = binary ? 0 : 2;
+    size_t length = headLength + openLength + trailLength + closeLength;
+    if (!beginPayload("warmtepomp/reboot", length, true)) {
+        logPrintf(LOG_WARN, LOG_MQTT, "Publicatie herstartrapport mislukt.");
+        return;
     }
 
-    // Herstel oorspronkelijke callback
-    mqttClient.setCallback(mqttCallback);
+    PayloadStream stream;
+    PrefixPrint prefix(stream, headLength);
+    if (binary) {
+        serializeMsgPack(head, prefix);
+    } else {
+        serializeJson(head, prefix);
+    }
+    stream.write(open, openLength);
+    streamTrail(*report, binary, stream);
+    if (!binary) stream.write(reinterpret_cast<const uint8_t*>("]}"), closeLength);
+    if (!endPayload(stream, length)) {
+        logPrintf(LOG_WARN, LOG_MQTT, "Publicatie herstartrapport mislukt.");
+    }
 }
 
 // Publiceer draaitijd
@@ -180,11 +538,9 @@ void sendRuntimeToMQTT(int pumpIndex, unsigned long runtime) {
 
     StaticJsonDocument<64> doc;
     doc["runtime"] = runtime;
-    char buffer[64];
-    serializeJson(doc, buffer);
 
-    if (!mqttClient.publish(topic, buffer, true)) {
-        debugPrint("Publicatie runtime mislukt voor pomp " + String(pumpIndex));
+    if (!publishDocument(topic, doc, PAYLOAD_TELEMETRY, true)) {
+        logPrintf(LOG_WARN, LOG_MQTT, "Publicatie runtime mislukt voor pomp %d", pumpIndex);
     }
 }
 
@@ -194,12 +550,27 @@ void publishBufferTemperature(float bufferTemperature) {
 
     StaticJsonDocument<64> doc;
     doc["buffer_temperature"] = bufferTemperature;
-    char buffer[64];
-    serializeJson(doc, buffer);
 
-    if (!mqttClient.publish("warmtepomp/buffer_temperature", buffer, true)) {
-        debugPrint("Publicatie buffer temperatuur mislukt");
+    if (!publishDocument("warmtepomp/buffer_temperature", doc, PAYLOAD_STATE, true)) {
+        logPrintf(LOG_WARN, LOG_MQTT, "Publicatie buffer temperatuur mislukt");
+    }
+}
+
+// Publiceer de status van één relais
+static bool publishRelay(int index, bool status, unsigned long lastOn, unsigned long lastOff) {
+    StaticJsonDocument<128> doc;
+    doc["status"] = status ? "ON" : "OFF";
+    doc["last_on"] = lastOn;
+    doc["last_off"] = lastOff;
+
+    char topic[50];
+    snprintf(topic, sizeof(topic), "warmtepomp/relay/%d/status", index);
+
+    if (!publishDocument(topic, doc, PAYLOAD_STATE, true)) {
+        logPrintf(LOG_WARN, LOG_MQTT, "Publicatie relaisstatus mislukt voor relais %d", index);
+        return false;
     }
+    return true;
 }
 
 // Publiceer relaisstatussen
@@ -207,33 +578,354 @@ void publishRelaisStatus(bool* relaisStatus, unsigned long* lastOnTimes, unsigne
     if (!mqttClient.connected()) return;
 
     for (int i = 0; i < relaisCount; i++) {
-        StaticJsonDocument<128> doc;
-        doc["status"] = relaisStatus[i] ? "ON" : "OFF";
-        doc["last_on"] = lastOnTimes[i];
-        doc["last_off"] = lastOffTimes[i];
+        publishRelay(i, relaisStatus[i], lastOnTimes[i], lastOffTimes[i]);
+    }
+}
 
-        char buffer[128];
-        serializeJson(doc, buffer);
+// Laatst gepubliceerde toestand
+static ControllerState lastPublished;
+static bool lastPublishedValid = false;
+static unsigned long lastHeartbeat = 0;
+static uint32_t lastConnectCount = 0;
 
-        char topic[50];
-        snprintf(topic, sizeof(topic), "warmtepomp/relay/%d/status", i);
+void configurePublishing(const PublishConfig& config) {
+    publishConfig = config;
+    lastPublishedValid = false; // Alles opnieuw versturen in de nieuwe vorm
+}
 
-        if (!mqttClient.publish(topic, buffer, true)) {
-            debugPrint("Publicatie relaisstatus mislukt voor relais " + String(i));
+static bool relayChanged(const ControllerState& state, int i) {
+    return state.relayStatus[i] != lastPublished.relayStatus[i] ||
+           state.lastOnTimes[i] != lastPublished.lastOnTimes[i] ||
+           state.lastOffTimes[i] != lastPublished.lastOffTimes[i];
+}
+
+static bool temperatureChanged(const ControllerState& state) {
+    if (state.bufferValid != lastPublished.bufferValid) return true;
+    return state.bufferValid && fabs(state.bufferTemperature - lastPublished.bufferTemperature) >= publishConfig.temperatureDeadband;
+}
+
+// Alle velden in één retained document op warmtepomp/state
+static bool publishSnapshot(const ControllerState& state) {
+    StaticJsonDocument<768> doc;
+    JsonArray relays = doc.createNestedArray("relays");
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        JsonObject relay = relays.createNestedObject();
+        relay["status"] = state.relayStatus[i] ? "ON" : "OFF";
+        relay["last_on"] = state.lastOnTimes[i];
+        relay["last_off"] = state.lastOffTimes[i];
+    }
+    if (state.bufferValid) {
+        doc["buffer_temperature"] = state.bufferTemperature;
+    } else {
+        doc["buffer_temperature"] = nullptr;
+    }
+    doc["mode"] = state.cooling ? "Koelen" : "Verwarmen";
+    JsonArray runtimes = doc.createNestedArray("runtimes");
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        runtimes.add(state.runtimeSeconds[i]);
+    }
+
+    if (!publishDocument("warmtepomp/state", doc, PAYLOAD_STATE, true)) {
+        logPrintf(LOG_WARN, LOG_MQTT, "Publicatie toestand mislukt");
+        return false;
+    }
+    return true;
+}
+
+// Gepubliceerde (of gespoolde) toestand onthouden.
+// Een temperatuur binnen de dode zone overschrijft de laatst gemelde waarde niet.
+static void rememberPublished(const ControllerState& state, bool temperatureDirty) {
+    float publishedTemperature = temperatureDirty ? state.bufferTemperature : lastPublished.bufferTemperature;
+    bool publishedValid = temperatureDirty ? state.bufferValid : lastPublished.bufferValid;
+    lastPublished = state;
+    lastPublished.bufferTemperature = publishedTemperature;
+    lastPublished.bufferValid = publishedValid;
+    lastPublishedValid = true;
+}
+
+static int16_t encodeTemperature(float temperature) {
+    return (int16_t)lroundf(temperature * 100.0);
+}
+
+// Zonder verbinding de wijzigingen in de spool bewaren
+static void spoolChanges(const ControllerState& state) {
+    if (!lastPublishedValid) {
+        rememberPublished(state, true); // Eerste toestand dient als vergelijkingspunt
+        return;
+    }
+
+    bool temperatureDirty = temperatureChanged(state);
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (state.relayStatus[i] != lastPublished.relayStatus[i]) {
+            spoolAppend(SPOOL_RELAY, i, state.relayStatus[i] ? 1 : 0);
         }
     }
+    if (temperatureDirty && state.bufferValid) {
+        spoolAppend(SPOOL_BUFFER_TEMPERATURE, 0, encodeTemperature(state.bufferTemperature));
+    }
+    rememberPublished(state, temperatureDirty);
+}
+
+static void publishSpoolStats() {
+    SpoolStats stats = getSpoolStats();
+
+    StaticJsonDocument<128> doc;
+    doc["depth"] = stats.depth;
+    doc["written"] = stats.written;
+    doc["replayed"] = stats.replayed;
+    doc["dropped"] = stats.dropped;
+
+    publishDocument("warmtepomp/spool", doc, PAYLOAD_TELEMETRY, true);
+}
+
+// Kengetallen van de cascade; gaan mee met de heartbeat
+static void publishStagingMetrics(const StagingMetrics& staging) {
+    StaticJsonDocument<256> doc;
+    doc["demand"] = staging.demandPumps;
+    doc["slope"] = lroundf(staging.bufferSlope * 1000.0) / 1000.0;  // °C per minuut
+    doc["starts_per_hour"] = lroundf(staging.startsPerHour * 10.0) / 10.0;
+    doc["starts"] = staging.totalStarts;
+    doc["recoveries"] = staging.recoveries;
+    doc["recovering"] = staging.recovering;
+    doc["last_recovery_s"] = staging.lastRecoveryMs / 1000UL;
+    doc["max_recovery_s"] = staging.maxRecoveryMs / 1000UL;
+
+    publishDocument("warmtepomp/staging", doc, PAYLOAD_TELEMETRY, true);
+}
+
+// Schakelingen per kanaal van het schuifregister, voor de slijtage van de relais; gaan mee met de heartbeat
+static void publishOutputStats(const OutputStats& outputs) {
+    StaticJsonDocument<256> doc;
+    JsonArray actuations = doc.createNestedArray("actuations");
+    for (int i = 0; i < OUTPUT_CHANNELS; i++) {
+        actuations.add(outputs.actuations[i]);
+    }
+    doc["latches"] = outputs.latches;
+    doc["unchanged"] = outputs.unchanged;
+    doc["interlock_trips"] = outputs.interlockTrips;
+
+    publishDocument("warmtepomp/outputs", doc, PAYLOAD_TELEMETRY, true);
 }
 
-// MQTT-loop
-void loopMQTT(bool* relaisStatus, unsigned long* lastOnTimes, unsigned long* lastOffTimes, int relaisCount) {
+// Per stap aantal, gemiddelde, p95 en maximum in µs, plus heap, RSSI en mislukte publicaties
+void publishMetrics() {
+    static unsigned long lastMetricsPublish = 0;
+    if (publishConfig.metricsIntervalMs == 0 || !mqttClient.connected()) return;
+    if (millis() - lastMetricsPublish < publishConfig.metricsIntervalMs) return;
+    lastMetricsPublish = millis();
+
+    StaticJsonDocument<768> doc;
+    JsonObject stages = doc.createNestedObject("stages");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        StageHistogram histogram = getStageHistogram((MetricStage)i);
+        JsonObject stage = stages.createNestedObject(metricStageName((MetricStage)i));
+        stage["count"] = histogram.count;
+        stage["mean_us"] = histogram.count > 0 ? (uint32_t)(histogram.sumUs / histogram.count) : 0;
+        stage["p95_us"] = stageQuantileUs(histogram, 0.95);
+        stage["max_us"] = histogram.maxUs;
+    }
+
+    SystemMetrics system = getSystemMetrics();
+    doc["free_heap"] = system.freeHeap;
+    doc["min_free_heap"] = system.minFreeHeap;
+    doc["largest_free_block"] = system.largestFreeBlock;
+    doc["rssi"] = system.rssi;
+    doc["publish_failures"] = connectionStats.publishFailures;
+
+    publishDocument("warmtepomp/metrics", doc, PAYLOAD_TELEMETRY, false);
+}
+
+// Publiceer alleen wat sinds de vorige keer veranderd is, of alles bij de heartbeat of na een nieuwe verbinding
+void publishChanges(const ControllerState& state) {
     if (!mqttClient.connected()) {
-        setupMQTT(); // Probeer te reconnecten
+        spoolChanges(state);
+        return;
+    }
+
+    unsigned long now = millis();
+    bool full = !lastPublishedValid || now - lastHeartbeat >= publishConfig.heartbeatMs ||
+                connectionStats.connectCount != lastConnectCount;
+
+    bool temperatureDirty = full || temperatureChanged(state);
+    bool relaysDirty = full;
+    for (int i = 0; i < RELAY_COUNT && !relaysDirty; i++) {
+        relaysDirty = relayChanged(state, i);
     }
-    mqttClient.loop();
 
-    static unsigned long lastPublishTime = 0;
-    if (millis() - lastPublishTime > 10000) {
-        publishRelaisStatus(relaisStatus, lastOnTimes, lastOffTimes, relaisCount);
-        lastPublishTime = millis();
+    if (publishConfig.snapshotMode) {
+        // Draaitijden lopen elke seconde op; die gaan mee met de heartbeat of een andere wijziging
+        bool dirty = relaysDirty || temperatureDirty || state.cooling != lastPublished.cooling;
+        if (dirty && !publishSnapshot(state)) return; // Volgende tick opnieuw proberen
+    } else {
+        for (int i = 0; i < RELAY_COUNT; i++) {
+            if (full || relayChanged(state, i)) {
+                if (!publishRelay(i, state.relayStatus[i], state.lastOnTimes[i], state.lastOffTimes[i])) return;
+            }
+        }
+        if (temperatureDirty && state.bufferValid) {
+            publishBufferTemperature(state.bufferTemperature);
+        }
+    }
+
+    if (full) {
+        publishSpoolStats();
+        publishStagingMetrics(state.staging);
+        publishOutputStats(state.outputs);
+        lastHeartbeat = now;
+    }
+    rememberPublished(state, temperatureDirty);
+    lastConnectCount = connectionStats.connectCount;
+}
+
+// Tekst bij een waarschuwingscode
+static void fillWarning(JsonDocument& doc, uint8_t code) {
+    switch (code) {
+        case WARNING_BUFFER_TEMPERATURE:
+            doc["type"] = "temperatuur_fout";
+            doc["melding"] = "Buffertemperatuur is al 30 minuten ongeldig.";
+            doc["actie"] = "Pompen uitgeschakeld.";
+            break;
+        default:
+            doc["type"] = "onbekend";
+            doc["code"] = code;
+            break;
+    }
+}
+
+// Publiceer een waarschuwing; zonder verbinding gaat hij de spool in
+void publishWarning(WarningCode code) {
+    if (!mqttClient.connected()) {
+        spoolAppend(SPOOL_WARNING, 0, code);
+        return;
+    }
+
+    StaticJsonDocument<192> doc;
+    fillWarning(doc, code);
+
+    if (!publishDocument("warmtepomp/waarschuwing", doc, PAYLOAD_EVENTS, false)) {
+        spoolAppend(SPOOL_WARNING, 0, code);
+    }
+}
+
+// Eén gespoold record versturen met zijn oorspronkelijke tijdstempel
+static bool publishSpoolRecord(const SpoolRecord& record) {
+    StaticJsonDocument<192> doc;
+    char topic[50];
+
+    switch (record.type) {
+        case SPOOL_BUFFER_TEMPERATURE:
+            snprintf(topic, sizeof(topic), "warmtepomp/history/buffer_temperature");
+            doc["buffer_temperature"] = record.value / 100.0;
+            break;
+        case SPOOL_RELAY:
+            snprintf(topic, sizeof(topic), "warmtepomp/history/relay/%d", record.index);
+            doc["status"] = record.value ? "ON" : "OFF";
+            break;
+        case SPOOL_WARNING:
+            snprintf(topic, sizeof(topic), "warmtepomp/waarschuwing");
+            fillWarning(doc, (uint8_t)record.value);
+            break;
+        default:
+            return true; // Onbekend record overslaan
+    }
+    doc["ts"] = record.timestamp;
+
+    return publishDocument(topic, doc, PAYLOAD_EVENTS, false);
+}
+
+// Waarschuwingen en fouten uit de logbuffer doorsturen naar warmtepomp/log
+void publishLog() {
+    static bool started = false;
+    static LogIterator iterator;
+    if (!started) {
+        iterator = logBegin();
+        started = true;
+    }
+    if (!mqttClient.connected()) return;
+
+    LogRecord record;
+    int sent = 0;
+    while (sent < LOG_FORWARD_PER_TICK) {
+        LogIterator position = iterator;
+        if (!logNext(iterator, record)) return;
+        if (record.level < LOG_WARN) continue;
+
+        StaticJsonDocument<256> doc;
+        doc["uptime_ms"] = record.timestampMs;
+        doc["level"] = logLevelName(record.level);
+        doc["subsystem"] = logSubsystemName(record.subsystem);
+        doc["message"] = (const char*)record.message;
+
+        // Niet loggen bij een mislukte publicatie, dat zou zichzelf voeden
+        if (!publishDocument("warmtepomp/log", doc, PAYLOAD_EVENTS, false)) {
+            iterator = position; // Volgende keer opnieuw
+            return;
+        }
+        sent++;
+    }
+}
+
+// Spool geleidelijk afspelen zodat de actuele publicaties voorgaan
+void replaySpool() {
+    if (!mqttClient.connected()) return;
+
+    SpoolRecord record;
+    for (int n = 0; n < SPOOL_REPLAY_PER_TICK && spoolPeek(record); n++) {
+        if (!publishSpoolRecord(record)) break; // Later opnieuw proberen
+        spoolAdvance();
+    }
+    spoolSaveReadOffset();
+}
+
+MqttConnectionState getMqttConnectionState() {
+    return connectionState;
+}
+
+MqttConnectionStats getMqttConnectionStats() {
+    MqttConnectionStats stats = connectionStats;
+    if (connectionState != MQTT_SUBSCRIBED) {
+        stats.totalDisconnectedMs += millis() - disconnectedSince; // Lopende onderbreking meetellen
+    }
+    return stats;
+}
+
+// MQTT-loop: één stap van de verbindingsstatemachine, blokkeert niet
+void loopMQTT() {
+    if (connectionState == MQTT_SUBSCRIBED) {
+        if (mqttClient.loop()) return;
+
+        // Verbinding verloren
+        disconnectedSince = millis();
+        logPrintf(LOG_WARN, LOG_MQTT, "MQTT-verbinding verbroken. Status: %d", mqttClient.state());
+        enterState(MQTT_RESOLVING);
+    }
+
+    if (WiFi.status() != WL_CONNECTED) { // Zonder WiFi heeft verbinden geen zin
+        cancelBrokerSearch();
+        closeConnectSocket();
+        if (connectionState != MQTT_BACKOFF) enterState(MQTT_RESOLVING);
+        return;
+    }
+
+    switch (connectionState) {
+        case MQTT_RESOLVING:
+            if (brokerAddressKnown || resolveBroker()) {
+                startConnect();
+            } else if (connectionState == MQTT_RESOLVING && millis() - stateEnteredTime > 2 * MQTT_RESOLVE_TIMEOUT) {
+                logPrintf(LOG_WARN, LOG_MQTT, "mDNS-zoekopdracht naar broker verlopen");
+                cancelBrokerSearch();
+                enterBackoff();
+            }
+            break;
+        case MQTT_CONNECTING:
+            connectBroker();
+            break;
+        case MQTT_BACKOFF:
+            if ((long)(millis() - backoffUntil) >= 0) {
+                enterState(MQTT_RESOLVING);
+            }
+            break;
+        case MQTT_SUBSCRIBED:
+            break;
     }
 }
@@ -3,26 +3,90 @@
 
 #include <WiFi.h>
 #include <PubSubClient.h>
+#include "ControllerState.h"
 
 // Externe MQTT-client
 extern PubSubClient mqttClient;
 
+// Modus zoals ontvangen op warmtepomp/mode
+enum HeatPumpMode : uint8_t {
+    MODE_NONE,      // Nog niets ontvangen
+    MODE_HEATING,   // Verwarmen
+    MODE_COOLING    // Koelen
+};
+
+// Toestanden van de verbinding met de broker
+enum MqttConnectionState {
+    MQTT_RESOLVING,   // Adres van de broker opzoeken via mDNS (of gecachet adres gebruiken)
+    MQTT_CONNECTING,  // Socket verbinden zonder te wachten, dan CONNECT en abonneren
+    MQTT_SUBSCRIBED,  // Verbonden en geabonneerd
+    MQTT_BACKOFF      // Wachten met spreiding voor de volgende poging
+};
+
+// Tellers voor de verbinding
+struct MqttConnectionStats {
+    uint32_t reconnectAttempts;    // Aantal verbindingspogingen
+    uint32_t failedAttempts;       // Daarvan mislukt
+    uint32_t connectCount;         // Aantal geslaagde verbindingen
+    uint32_t lastTimeToConnectMs;  // Van verbroken tot weer verbonden, laatste keer
+    uint64_t totalDisconnectedMs;  // Totale tijd zonder verbinding
+    uint32_t publishFailures;      // Publicaties die de broker niet (volledig) bereikten
+};
+
 // Initialisatie en basisverbinding
-void setupMQTT();                              // Verbindt met de MQTT-broker
-void loopMQTT(bool* relaisStatus, unsigned long* lastOnTimes, unsigned long* lastOffTimes, int relaisCount);  // Houdt de verbinding in stand en publiceert periodiek
+void setupMQTT();                              // Stelt de client in; verbinden gebeurt in loopMQTT()
+void loopMQTT();                               // Houdt de verbinding in stand en verwerkt inkomende berichten, zonder te blokkeren
+MqttConnectionState getMqttConnectionState();  // Huidige toestand van de verbinding; veilig vanuit de regeltaak
+MqttConnectionStats getMqttConnectionStats();  // Tellers van de verbinding
+
+// Vorm van de payload
+enum PayloadCodec : uint8_t {
+    CODEC_JSON,     // Tekst, leesbaar voor Home Assistant en mosquitto_sub
+    CODEC_MSGPACK   // MessagePack: dezelfde velden, binair en kleiner
+};
+
+// Groepen topics die elk een eigen vorm kunnen krijgen
+enum PayloadGroup : uint8_t {
+    PAYLOAD_STATE,      // Relais, buffertemperatuur en warmtepomp/state
+    PAYLOAD_TELEMETRY,  // Draaitijden, spool, cascade, uitgangen en opstarttijden
+    PAYLOAD_EVENTS,     // Waarschuwingen, log en afgespeelde spool
+    PAYLOAD_GROUP_COUNT
+};
+
+// Instellingen voor publishChanges()
+struct PublishConfig {
+    unsigned long heartbeatMs;   // Alles opnieuw versturen na deze tijd, ook zonder wijziging
+    float temperatureDeadband;   // Minimale temperatuurverandering in °C voor een nieuwe publicatie
+    bool snapshotMode;           // true = één document op warmtepomp/state in plaats van losse topics
+    PayloadCodec codecs[PAYLOAD_GROUP_COUNT]; // Vorm per groep; de starttijd blijft altijd platte tekst
+    unsigned long metricsIntervalMs; // Samenvatting van Metrics op warmtepomp/metrics; 0 = uit
+};
+
+// Waarschuwingen op warmtepomp/waarschuwing
+enum WarningCode : uint8_t {
+    WARNING_BUFFER_TEMPERATURE = 1   // Buffertemperatuur te lang ongeldig, pompen uit
+};
 
 // Publicatie
+void configurePublishing(const PublishConfig& config); // Heartbeat, dode zone, vorm en codecs instellen
+void publishChanges(const ControllerState& state);     // Publiceert alleen gewijzigde velden (of alles bij de heartbeat); offline naar de spool
+void publishWarning(WarningCode code);                 // Stuurt een waarschuwing; offline naar de spool
+void publishLog();                                     // Stuurt nieuwe waarschuwingen en fouten uit de logbuffer door
+void replaySpool();                                    // Speelt tijdens storingen bewaarde berichten af, een paar per aanroep
+void publishMetrics();                                 // Samenvatting van tijden en heap, elke metricsIntervalMs
 void publishRelaisStatus(bool* relaisStatus, unsigned long* lastOnTimes, unsigned long* lastOffTimes, int relaisCount); // Stuurt relaisstatus naar MQTT
 void publishBufferTemperature(float bufferTemperature); // Stuurt buffertemperatuur naar MQTT
 void sendRuntimeToMQTT(int pumpIndex, unsigned long runtime); // Stuurt individuele runtime door
 void updateStarttime();                          // Stuurt opstarttijd door
+void publishBootTimes();                         // Stuurt de duur per opstartfase door
+void publishRebootReport();                      // Stuurt de herstartreden en de sporen van Supervisor door
 
 // Ophalen
-void getAllRuntimes(unsigned long* runtimes);    // Haalt runtimes op voor alle pompen
-String GetMode(); // Haalt modus op (Verwarmen / Koelen / Niks)
+bool getRuntimeSeed(int pumpIndex, unsigned long& runtime); // Door de pomp gemelde run_time (seconden), als die al binnen is
+HeatPumpMode GetMode(); // Laatst ontvangen modus, zonder netwerkverkeer; veilig vanuit de regeltaak
 
 // Utilities
 bool topicExists(const char* topic);             // Controleert of een topic actief is
-void mqttCallback(char* topic, byte* payload, unsigned int length); // Standaard callback functie
+void mqttCallback(char* topic, byte* payload, unsigned int length); // Stuurt berichten door via de topictabel
 
 #endif
@@ -0,0 +1,65 @@
+#include "Metrics.h"
+#include <WiFi.h>
+
+static StageHistogram histograms[STAGE_COUNT];
+static uint32_t cyclesPerUs = 240;
+
+static const char* const stageNames[STAGE_COUNT] = {"sensors", "mode", "pumps", "mqtt", "portal", "render"};
+
+void setupMetrics() {
+    uint32_t mhz = ESP.getCpuFreqMHz();
+    if (mhz > 0) cyclesPerUs = mhz;
+}
+
+// Kleinste i met us <= 2^i
+static uint8_t bucketFor(uint32_t us) {
+    if (us <= 1) return 0;
+    uint8_t bucket = 32 - __builtin_clz(us - 1);
+    return bucket < METRIC_BUCKETS ? bucket : METRIC_BUCKETS - 1;
+}
+
+void metricsRecord(MetricStage stage, uint32_t start) {
+    if (stage >= STAGE_COUNT) return;
+    uint32_t us = metricsInMicros(stage) ? (uint32_t)micros() - start : (ESP.getCycleCount() - start) / cyclesPerUs;
+
+    StageHistogram& histogram = histograms[stage];
+    histogram.buckets[bucketFor(us)]++;
+    histogram.count++;
+    histogram.sumUs += us;
+    if (us > histogram.maxUs) histogram.maxUs = us;
+}
+
+const char* metricStageName(MetricStage stage) {
+    return stage < STAGE_COUNT ? stageNames[stage] : "?";
+}
+
+StageHistogram getStageHistogram(MetricStage stage) {
+    if (stage >= STAGE_COUNT) return StageHistogram();
+    return histograms[stage];
+}
+
+uint32_t metricBucketBoundUs(uint8_t bucket) {
+    return bucket < METRIC_BUCKETS - 1 ? 1UL << bucket : UINT32_MAX;
+}
+
+uint32_t stageQuantileUs(const StageHistogram& histogram, float quantile) {
+    if (histogram.count == 0) return 0;
+    uint32_t target = (uint32_t)ceilf(histogram.count * quantile);
+    if (target == 0) target = 1;
+
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < METRIC_BUCKETS - 1; i++) {
+        seen += histogram.buckets[i];
+        if (seen >= target) return min(metricBucketBoundUs(i), histogram.maxUs);
+    }
+    return histogram.maxUs; // In de laatste emmer; het maximum is dan de beste schatting
+}
+
+SystemMetrics getSystemMetrics() {
+    SystemMetrics metrics;
+    metrics.freeHeap = ESP.getFreeHeap();
+    metrics.minFreeHeap = ESP.getMinFreeHeap();
+    metrics.largestFreeBlock = ESP.getMaxAllocHeap();
+    metrics.rssi = WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0;
+    return metrics;
+}
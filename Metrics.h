@@ -0,0 +1,72 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+// Tijdmetingen per stap van de regeling en het netwerk, als histogram met vaste emmers.
+// Meten kost twee keer de klok lezen en een paar optellingen; er wordt nooit gealloceerd.
+// Elke stap heeft één schrijvende taak. Een lezer op de andere core kan een half bijgewerkte
+// emmer zien; voor statistiek is dat goed genoeg en het scheelt een lock in de meetlus.
+
+enum MetricStage : uint8_t {
+    STAGE_SENSORS,   // taskSensors: conversie starten of ophalen
+    STAGE_MODE,      // GetMode() en koelrelais
+    STAGE_PUMPS,     // PumpMaster::update()
+    STAGE_MQTT,      // loopMQTT(), inclusief verbinden
+    STAGE_PORTAL,    // server.handleClient(), inclusief alle handlers
+    STAGE_RENDER,    // Weergave van de hoofdpagina
+    STAGE_COUNT
+};
+
+// Emmer i telt metingen tot en met 2^i µs; de laatste telt de rest (+Inf)
+const uint8_t METRIC_BUCKETS = 20;
+
+struct StageHistogram {
+    uint32_t buckets[METRIC_BUCKETS];
+    uint32_t count;
+    uint64_t sumUs;
+    uint32_t maxUs;
+};
+
+struct SystemMetrics {
+    uint32_t freeHeap;           // Nu vrij
+    uint32_t minFreeHeap;        // Laagste punt sinds het opstarten
+    uint32_t largestFreeBlock;   // Grootste blok dat nog in één keer te alloceren is
+    int8_t rssi;                 // dBm; 0 zonder WiFi-verbinding
+};
+
+// Kloksnelheid vastleggen voor het omrekenen van cycli naar µs
+void setupMetrics();
+
+// De cyclusteller wikkelt op 240 MHz na ongeveer 17 s rond. De portal kan langer bezig zijn (een upload
+// naar /update, een download van /api/trace) en meet daarom met micros(), dat pas na 71 minuten rondgaat.
+inline bool metricsInMicros(MetricStage stage) {
+    return stage == STAGE_PORTAL;
+}
+
+// Begin van een meting: cycli, of µs voor de stappen uit metricsInMicros()
+inline uint32_t metricsStart(MetricStage stage) {
+    return metricsInMicros(stage) ? (uint32_t)micros() : ESP.getCycleCount();
+}
+
+// Duur sinds metricsStart() toevoegen aan het histogram van de stap
+void metricsRecord(MetricStage stage, uint32_t start);
+
+// Meet de rest van het blok
+class StageTimer {
+public:
+    explicit StageTimer(MetricStage stage) : stage(stage), start(metricsStart(stage)) {}
+    ~StageTimer() { metricsRecord(stage, start); }
+
+private:
+    MetricStage stage;
+    uint32_t start;
+};
+
+const char* metricStageName(MetricStage stage);
+StageHistogram getStageHistogram(MetricStage stage);
+uint32_t metricBucketBoundUs(uint8_t bucket);                              // Bovengrens van een emmer in µs
+uint32_t stageQuantileUs(const StageHistogram& histogram, float quantile);  // Bovengrens van de emmer waarin het kwantiel valt
+SystemMetrics getSystemMetrics();
+
+#endif // METRICS_H
@@ -0,0 +1,176 @@
+#include "Ota.h"
+#include <Update.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include "Debug.h"
+#include "Supervisor.h"
+
+static OtaStats stats = {OTA_IDLE, 0, 0, 0, 0, 0, 0};
+static char lastError[96] = "";
+
+static mbedtls_sha256_context hashContext;
+static uint8_t expectedDigest[32];
+static unsigned long uploadStart = 0;
+static uint64_t stalledUs = 0;    // In µs opgeteld; per stuk is een ms te grof
+static uint32_t maxStallUs = 0;
+static bool updateOpen = false;   // Update.begin() gelukt en hash gestart; moet nog afgerond of afgebroken
+
+static bool pendingVerify = false;
+static unsigned long verifyStart = 0;
+
+// De Arduino-kern bevestigt een nieuwe firmware anders zelf bij het opstarten; loopOta() doet dat hier
+extern "C" bool verifyRollbackLater() {
+    return true;
+}
+
+static bool parseDigest(const char* text, uint8_t* digest) {
+    if (text == nullptr || strlen(text) != 64) return false;
+    for (int i = 0; i < 32; i++) {
+        uint8_t value = 0;
+        for (int j = 0; j < 2; j++) {
+            char c = text[2 * i + j];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else return false;
+        }
+        digest[i] = value;
+    }
+    return true;
+}
+
+static void closeUpdate(bool abort) {
+    if (!updateOpen) return;
+    if (abort) Update.abort();
+    mbedtls_sha256_free(&hashContext);
+    updateOpen = false;
+}
+
+static void fail(const char* reason) {
+    closeUpdate(true);
+    stats.state = OTA_FAILED;
+    stats.durationMs = millis() - uploadStart;
+    snprintf(lastError, sizeof(lastError), "%s", reason);
+    logPrintf(LOG_ERROR, LOG_PORTAL, "Update mislukt: %s", reason);
+}
+
+// Melding van de Update-bibliotheek overnemen in plaats van printError(Serial)
+static void failWithUpdateError(const char* step) {
+    char reason[sizeof(lastError)];
+    snprintf(reason, sizeof(reason), "%s: %s", step, Update.errorString());
+    fail(reason);
+}
+
+bool otaBegin(const char* expectedSha256) {
+    closeUpdate(true); // Een vorige upload is nooit afgerond
+    stats = {OTA_RECEIVING, 0, 0, 0, 0, 0, 0};
+    lastError[0] = '\0';
+    uploadStart = millis();
+    stalledUs = 0;
+    maxStallUs = 0;
+
+    if (!parseDigest(expectedSha256, expectedDigest)) {
+        fail("geen geldige sha256 opgegeven");
+        return false;
+    }
+    if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
+        failWithUpdateError("begin");
+        return false;
+    }
+
+    mbedtls_sha256_init(&hashContext);
+    mbedtls_sha256_starts(&hashContext, 0);
+    updateOpen = true;
+    logPrintf(LOG_INFO, LOG_PORTAL, "Update gestart");
+    return true;
+}
+
+bool otaWrite(const uint8_t* data, size_t length) {
+    if (stats.state != OTA_RECEIVING) return false;
+
+    mbedtls_sha256_update(&hashContext, data, length);
+
+    unsigned long writeStart = micros();
+    size_t written = Update.write(const_cast<uint8_t*>(data), length);
+    uint32_t stallUs = micros() - writeStart;
+    stalledUs += stallUs;
+    maxStallUs = max(maxStallUs, stallUs);
+    stats.stalledMs = stalledUs / 1000ULL;
+    stats.maxStallMs = maxStallUs / 1000UL;
+    stats.chunks++;
+
+    if (written != length) {
+        failWithUpdateError("schrijven");
+        return false;
+    }
+    stats.bytesWritten += length;
+    stageProgress(); // Een lange upload blijft zo binnen het budget van de portal, zolang er data komt
+    return true;
+}
+
+bool otaEnd() {
+    if (stats.state != OTA_RECEIVING) return false;
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&hashContext, digest);
+    stats.durationMs = millis() - uploadStart;
+    stats.bytesPerSecond = stats.durationMs > 0 ? (uint32_t)((uint64_t)stats.bytesWritten * 1000ULL / stats.durationMs) : stats.bytesWritten;
+
+    if (memcmp(digest, expectedDigest, sizeof(digest)) != 0) {
+        fail("sha256 komt niet overeen"); // Image wordt niet geactiveerd
+        return false;
+    }
+    if (!Update.end(true)) {
+        closeUpdate(false);
+        failWithUpdateError("afronden");
+        return false;
+    }
+    closeUpdate(false);
+
+    stats.state = OTA_SUCCEEDED;
+    logPrintf(LOG_INFO, LOG_PORTAL, "Update geslaagd: %u bytes in %u ms (%u B/s), %u ms vast in schrijven",
+              (unsigned)stats.bytesWritten, (unsigned)stats.durationMs, (unsigned)stats.bytesPerSecond, (unsigned)stats.stalledMs);
+    return true;
+}
+
+void otaAbort() {
+    if (stats.state == OTA_RECEIVING) fail("upload afgebroken");
+}
+
+OtaStats getOtaStats() {
+    return stats;
+}
+
+const char* getOtaError() {
+    return lastError;
+}
+
+void setupOta() {
+    esp_ota_img_states_t state;
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    pendingVerify = running != nullptr && esp_ota_get_state_partition(running, &state) == ESP_OK &&
+                    state == ESP_OTA_IMG_PENDING_VERIFY;
+    verifyStart = millis();
+    if (pendingVerify) {
+        logPrintf(LOG_WARN, LOG_SYSTEM, "Nieuwe firmware, nog niet bevestigd; gezondheidscontrole loopt");
+    }
+}
+
+void loopOta(bool healthy) {
+    if (!pendingVerify) return;
+
+    if (healthy) {
+        esp_ota_mark_app_valid_cancel_rollback();
+        pendingVerify = false;
+        logPrintf(LOG_INFO, LOG_SYSTEM, "Nieuwe firmware bevestigd na %u ms", (unsigned)(millis() - verifyStart));
+    } else if (millis() - verifyStart >= OTA_HEALTH_TIMEOUT) {
+        logPrintf(LOG_ERROR, LOG_SYSTEM, "Nieuwe firmware niet gezond binnen de tijd; terug naar de vorige");
+        pendingVerify = false;
+        esp_ota_mark_app_invalid_rollback_and_reboot(); // Komt alleen terug als er geen vorige firmware is
+    }
+}
+
+bool otaPendingVerify() {
+    return pendingVerify;
+}
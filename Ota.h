@@ -0,0 +1,53 @@
+#ifndef OTA_H
+#define OTA_H
+
+#include <Arduino.h>
+
+// Firmware-update via de portal. Het image wordt tijdens het schrijven gehasht en pas geactiveerd
+// als de SHA-256 overeenkomt met de opgegeven waarde. De nieuwe firmware start als "pending verify"
+// en moet binnen OTA_HEALTH_TIMEOUT gezond zijn, anders gaat de bootloader terug naar de vorige.
+
+const unsigned long OTA_HEALTH_TIMEOUT = 5UL * 60UL * 1000UL;
+
+enum OtaState : uint8_t {
+    OTA_IDLE,        // Geen upload sinds het opstarten
+    OTA_RECEIVING,   // Upload bezig
+    OTA_SUCCEEDED,   // Image geschreven en gecontroleerd; wacht op herstart
+    OTA_FAILED       // Afgebroken; de huidige firmware blijft actief
+};
+
+struct OtaStats {
+    OtaState state;
+    uint32_t bytesWritten;      // Bytes van de laatste upload
+    uint32_t durationMs;        // Van begin tot einde van de laatste upload
+    uint32_t bytesPerSecond;    // Doorvoer van de laatste upload
+    uint32_t stalledMs;         // Tijd in Update.write(), waarin de netwerktaak niets anders doet
+    uint32_t maxStallMs;        // Langste enkele schrijfactie
+    uint32_t chunks;            // Aantal ontvangen stukken
+};
+
+// Upload starten. expectedSha256 is de digest als 64 hexadecimale tekens; zonder geldige digest wordt geweigerd.
+bool otaBegin(const char* expectedSha256);
+
+// Stuk van het image hashen en wegschrijven. Na een fout worden verdere stukken genegeerd.
+bool otaWrite(const uint8_t* data, size_t length);
+
+// Upload afronden: digest controleren en het image pas dan activeren
+bool otaEnd();
+
+// Upload afgebroken door de client
+void otaAbort();
+
+OtaStats getOtaStats();
+const char* getOtaError();   // Laatste foutmelding, leeg als er geen was
+
+// Na het opstarten: controleren of deze firmware nog bevestigd moet worden
+void setupOta();
+
+// Bevestigen zodra healthy, of na OTA_HEALTH_TIMEOUT terug naar de vorige firmware (herstart)
+void loopOta(bool healthy);
+
+// Deze firmware is nieuw en nog niet bevestigd
+bool otaPendingVerify();
+
+#endif // OTA_H
@@ -0,0 +1,114 @@
+#include "Outputs.h"
+#include <ShiftRegister74HC595_NonTemplate.h>
+#include "Debug.h"
+
+static ShiftRegister74HC595_NonTemplate* shiftRegister = nullptr;
+
+static uint8_t stagedFrame = 0;    // Wat de schrijvers willen
+static uint8_t hardwareFrame = 0;  // Wat er op de uitgangen staat
+static bool hardwareKnown = false;
+static OutputStats stats = {{0}, 0, 0, 0};
+
+// Vergrendeling; zonder setOutputInterlock() staat hij uit
+static bool interlockEnabled = false;
+static uint8_t changeoverBit = 0;
+static uint8_t guardedBits = 0;
+static unsigned long interlockDeadTime = 0;
+static unsigned long guardedLastOn = 0;    // Laatste commit met een bewaakt kanaal aan
+static bool guardedEverOn = false;
+static unsigned long lastChangeover = 0;
+static bool changedOver = false;
+static uint8_t heldBits = 0;               // Bewaakte kanalen die de vergrendeling nu tegenhoudt
+
+void setupOutputs(uint8_t dataPin, uint8_t clockPin, uint8_t latchPin) {
+    shiftRegister = new ShiftRegister74HC595_NonTemplate(1, dataPin, clockPin, latchPin);
+    stagedFrame = 0;
+    hardwareKnown = false;
+}
+
+void setOutputInterlock(uint8_t changeoverChannel, uint8_t guardedMask, unsigned long deadTimeMs) {
+    interlockEnabled = changeoverChannel < OUTPUT_CHANNELS;
+    changeoverBit = 1 << changeoverChannel;
+    guardedBits = guardedMask & ~changeoverBit;
+    interlockDeadTime = deadTimeMs;
+}
+
+void outputSet(uint8_t channel, bool on) {
+    if (channel >= OUTPUT_CHANNELS) return;
+    if (on) stagedFrame |= 1 << channel;
+    else stagedFrame &= ~(1 << channel);
+}
+
+// Bewaakte kanalen uithouden; elk kanaal dat opnieuw tegengehouden wordt telt als een ingreep
+static uint8_t holdGuarded(uint8_t frame) {
+    uint8_t wanted = frame & guardedBits;
+    if (wanted & ~heldBits) stats.interlockTrips++;
+    heldBits = wanted;
+    return frame & ~guardedBits;
+}
+
+// Frame aanpassen aan de vergrendeling
+static uint8_t applyInterlock(uint8_t frame, unsigned long now) {
+    if (!interlockEnabled) return frame;
+
+    bool guardedQuiet = (hardwareFrame & guardedBits) == 0 && (!guardedEverOn || now - guardedLastOn >= interlockDeadTime);
+    if ((frame & changeoverBit) != (hardwareFrame & changeoverBit)) {
+        if (hardwareKnown && !guardedQuiet) {
+            // Nog niet omschakelen; eerst de bewaakte kanalen uit
+            frame = (frame & ~changeoverBit) | (hardwareFrame & changeoverBit);
+            return holdGuarded(frame);
+        }
+        lastChangeover = now;
+        changedOver = true;
+        return holdGuarded(frame);
+    }
+
+    // Na het omschakelen blijven de bewaakte kanalen nog even uit
+    if (changedOver && now - lastChangeover < interlockDeadTime) {
+        return holdGuarded(frame);
+    }
+    heldBits = 0;
+    return frame;
+}
+
+bool outputChangeoverPending() {
+    if (!interlockEnabled) return false;
+    if (hardwareKnown && (stagedFrame & changeoverBit) != (hardwareFrame & changeoverBit)) return true;
+    return changedOver && millis() - lastChangeover < interlockDeadTime;
+}
+
+bool outputCommit() {
+    if (shiftRegister == nullptr) return false;
+
+    unsigned long now = millis();
+    uint8_t frame = applyInterlock(stagedFrame, now);
+    if (hardwareKnown && frame == hardwareFrame) {
+        stats.unchanged++;
+        return false;
+    }
+
+    shiftRegister->setAll(&frame); // Eén keer schuiven en één latch voor alle kanalen
+
+    uint8_t changed = hardwareKnown ? frame ^ hardwareFrame : 0;
+    for (uint8_t i = 0; i < OUTPUT_CHANNELS; i++) {
+        if (changed & (1 << i)) stats.actuations[i]++;
+    }
+    stats.latches++;
+    if ((hardwareFrame | frame) & guardedBits) { // Ook het moment van uitschakelen telt als laatst aan
+        guardedLastOn = now;
+        guardedEverOn = true;
+    }
+    hardwareFrame = frame;
+    hardwareKnown = true;
+
+    logPrintf(LOG_DEBUG, LOG_PUMPS, "Uitgangen: 0x%02X", frame);
+    return true;
+}
+
+uint8_t getOutputFrame() {
+    return hardwareFrame;
+}
+
+OutputStats getOutputStats() {
+    return stats;
+}
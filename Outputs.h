@@ -0,0 +1,44 @@
+#ifndef OUTPUTS_H
+#define OUTPUTS_H
+
+#include <Arduino.h>
+
+// Uitgangen op het schuifregister: relais en statusleds, in één frame van 8 bits.
+// Schrijvers zetten bits in een voorlopig frame; outputCommit() schuift het frame in één keer
+// naar buiten en zet de latch, en alleen als het afwijkt van wat er al op de uitgangen staat.
+// Alleen aanroepen vanuit de regeltaak.
+
+const uint8_t OUTPUT_CHANNELS = 8;
+
+struct OutputStats {
+    uint32_t actuations[OUTPUT_CHANNELS]; // Schakelingen per kanaal sinds het opstarten (aan en uit elk één)
+    uint32_t latches;                     // Frames naar het register geschreven
+    uint32_t unchanged;                   // Commits zonder verschil, niet geschreven
+    uint32_t interlockTrips;              // Keren dat de vergrendeling een kanaal uithield dat een schrijver aan wilde
+};
+
+// Register aanmaken; alle kanalen staan voorlopig uit tot de eerste commit
+void setupOutputs(uint8_t dataPin, uint8_t clockPin, uint8_t latchPin);
+
+// Vergrendeling: het omschakelkanaal wisselt alleen als alle bewaakte kanalen minstens deadTimeMs uit zijn,
+// en die blijven na het wisselen nog deadTimeMs uit. Eerst breken, dan maken.
+// Dit is het vangnet; de schrijvers zetten de bewaakte kanalen zelf uit zolang outputChangeoverPending() true is.
+void setOutputInterlock(uint8_t changeoverChannel, uint8_t guardedMask, unsigned long deadTimeMs);
+
+// Omschakeling bezig: het omschakelkanaal in het voorlopige frame wijkt af van de uitgang,
+// of de dode tijd na het omschakelen loopt nog
+bool outputChangeoverPending();
+
+// Kanaal in het voorlopige frame zetten; er gaat nog niets naar buiten
+void outputSet(uint8_t channel, bool on);
+
+// Voorlopig frame na de vergrendeling vastleggen. Geeft true als het register beschreven is.
+// De eerste commit schrijft altijd, omdat de toestand van het register dan onbekend is.
+bool outputCommit();
+
+// Frame zoals het nu op de uitgangen staat
+uint8_t getOutputFrame();
+
+OutputStats getOutputStats();
+
+#endif // OUTPUTS_H
@@ -0,0 +1,72 @@
+#include "PageWriter.h"
+#include <stdarg.h>
+
+PageWriter::PageWriter(WebServer& server) : server(server) {
+    length = 0;
+    minFreeHeap = ESP.getFreeHeap();
+}
+
+void PageWriter::begin(int code, const char* contentType) {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(code, contentType, "");
+}
+
+void PageWriter::write(char c) {
+    if (length == BUFFER_SIZE) flush();
+    buffer[length++] = c;
+}
+
+void PageWriter::flush() {
+    if (length == 0) return;
+
+    server.sendContent(buffer, length);
+    length = 0;
+
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < minFreeHeap) minFreeHeap = freeHeap;
+}
+
+void PageWriter::print(const char* text) {
+    while (*text) write(*text++);
+}
+
+void PageWriter::print_P(PGM_P text) {
+    char c;
+    while ((c = pgm_read_byte(text++)) != 0) write(c);
+}
+
+void PageWriter::printEscaped(const char* text) {
+    for (const char* c = text; *c; c++) {
+        switch (*c) {
+            case '<': print("&lt;"); break;
+            case '>': print("&gt;"); break;
+            case '&': print("&amp;"); break;
+            case '\'': print("&#39;"); break;
+            case '"': print("&quot;"); break;
+            default: write(*c); break;
+        }
+    }
+}
+
+void PageWriter::printf(const char* format, ...) {
+    char text[128];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    print(text);
+}
+
+void PageWriter::writeBytes(const void* data, size_t size) {
+    const char* bytes = (const char*)data;
+    for (size_t i = 0; i < size; i++) write(bytes[i]);
+}
+
+void PageWriter::end() {
+    flush();
+    server.sendContent("", 0); // Lege chunk sluit de respons af
+}
+
+uint32_t PageWriter::getMinFreeHeap() const {
+    return minFreeHeap;
+}
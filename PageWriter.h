@@ -0,0 +1,41 @@
+#ifndef PAGEWRITER_H
+#define PAGEWRITER_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Schrijft een pagina in stukken (chunked transfer encoding) naar de client.
+// Tekst wordt verzameld in een vaste buffer en per volle buffer verstuurd, zodat
+// het geheugengebruik niet afhangt van de grootte van de pagina.
+class PageWriter {
+public:
+    static const size_t BUFFER_SIZE = 512;
+
+    explicit PageWriter(WebServer& server);
+
+    // Status en headers versturen; daarna volgen de stukken
+    void begin(int code, const char* contentType);
+
+    void print(const char* text);
+    void print_P(PGM_P text);          // Tekst uit flash (PROGMEM)
+    void printEscaped(const char* text); // Met HTML-escaping van < > & ' "
+    void printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    void writeBytes(const void* data, size_t size); // Binaire gegevens, onveranderd
+
+    // Restant versturen en de chunked respons afsluiten
+    void end();
+
+    // Laagste vrije heap gezien tijdens het schrijven
+    uint32_t getMinFreeHeap() const;
+
+private:
+    void write(char c);
+    void flush();
+
+    WebServer& server;
+    char buffer[BUFFER_SIZE];
+    size_t length;
+    uint32_t minFreeHeap;
+};
+
+#endif // PAGEWRITER_H
@@ -4,133 +4,476 @@
 #include <WebServer.h>
 #include <ESPmDNS.h>
 #include "PumpMaster.h"
-#include <Update.h>
-#include <DallasTemperature.h>
 #include <PubSubClient.h>
 #include "Debug.h"
+#include "PageWriter.h"
+#include "ControllerState.h"
+#include "Events.h"
+#include "CommandQueue.h"
+#include "History.h"
+#include "Scheduler.h"
+#include "Ota.h"
+#include "Metrics.h"
+#include "MQTT.h"
+#include "Trace.h"
+#include "Supervisor.h"
+#include <LittleFS.h>
+#include <esp_ota_ops.h>
 
 // Externe variabelen gedeclareerd in Warmtepompregelaar.ino
 extern WebServer server;
-extern DallasTemperature sensors;
-extern float bufferTemperature;
-extern String debugLog;
-extern bool relayStatus[6];
-extern unsigned long lastOnTimes[6]; // Laatste inschakeltijden
-extern unsigned long lastOffTimes[6]; // Laatste uitschakeltijden
-extern String mqttLog; // Externe MQTT-log
 extern PubSubClient mqttClient;
 extern String rebootReason;
-extern float outdoorTemperatureOnline;
-bool manualMode = false; // Automatisch of handmatig schakelen
 
-String formatTime(unsigned long timestamp) {
-    if (timestamp == 0) return "N/A"; // Geen tijd beschikbaar
+// Statistiek van de laatste paginaweergave
+static PortalRenderStats renderStats = {0, 0, 0};
+
+// Wordt bij de start willekeurig gekozen en in elk ETag opgenomen
+static uint32_t etagSalt = 0;
+
+// Begin van de hash van de firmware: verandert met elke build. In de URL van de vaste bestanden
+// (?v=) en in hun ETag, zodat een browser na een update nooit een oude versie gebruikt.
+static char buildId[9] = "";
+
+// Opmaak en vaste stukken van de pagina staan in flash
+static const char PORTAL_CSS[] PROGMEM =
+    "body{font-family:sans-serif;background:#f4f5f7;margin:0;color:#222}"
+    ".container{max-width:760px;margin:24px auto;padding:0 12px}"
+    "h1{text-align:center;font-size:1.6em}"
+    ".card{background:#fff;border:1px solid #ddd;border-radius:6px;padding:12px 16px;margin-bottom:14px}"
+    ".card h5{margin:0 0 10px;font-size:1.1em}"
+    ".btn{background:#0d6efd;color:#fff;border:0;border-radius:4px;padding:6px 12px;cursor:pointer}"
+    ".btn.sec{background:#6c757d;font-size:.85em;margin-top:6px}"
+    ".badge{float:right;color:#fff;border-radius:4px;padding:2px 8px;font-size:.85em}"
+    ".on{background:#198754}.off{background:#dc3545}"
+    "ul{list-style:none;padding:0;margin:0}li{border-top:1px solid #eee;padding:8px 0}"
+    "table{width:100%;border-collapse:collapse}td,th{text-align:left;padding:4px;border-top:1px solid #eee}"
+    ".log{font-family:monospace;white-space:pre-wrap;max-height:300px;overflow-y:auto;font-size:.85em}";
+
+static const char PAGE_HEAD[] PROGMEM =
+    "<!DOCTYPE html><html><head><meta charset='utf-8'>"
+    "<meta name='viewport' content='width=device-width,initial-scale=1'>";
+static const char PAGE_BODY_START[] PROGMEM =
+    "<body><div class='container'>"
+    "<h1>LilyGO Relay Portal V3</h1>"
+    "<div class='card'><h5>Mode</h5><form method='POST' action='/mode'>";
+static const char PAGE_MODE_END[] PROGMEM =
+    "<button type='submit' class='btn'>Opslaan</button></form></div>"
+    "<div class='card'><h5>Relais Status</h5><ul>";
+static const char PAGE_MQTT_START[] PROGMEM =
+    "</ul></div>"
+    "<div class='card'><h5>MQTT Info</h5><table><thead><tr><th>Tijd (s)</th><th>Bericht</th></tr></thead><tbody>";
+static const char PAGE_MQTT_OFFLINE[] PROGMEM = "<tr><td colspan='2'>Niet verbonden met MQTT</td></tr>";
+static const char PAGE_OUTDOOR_START[] PROGMEM =
+    "</tbody></table></div>"
+    "<div class='card'><h5>Buitentemperatuur</h5><p><span id='out'>";
+static const char PAGE_UPDATE[] PROGMEM =
+    "</span>&deg;C</p></div>"
+    "<div class='card'><h5>Firmware Update</h5>"
+    "<form method='POST' action='/update' enctype='multipart/form-data' onsubmit=\"this.action='/update?sha256='+this.sha256.value\">"
+    "<input type='file' name='update'><br>"
+    "<input type='text' name='sha256' placeholder='SHA-256 van het image' size='64' required><br><br>"
+    "<button type='submit' class='btn'>Update Firmware</button></form></div>"
+    "<div class='card'><h5>Debug Log</h5><div class='log'>";
+static const char PAGE_REBOOT_START[] PROGMEM =
+    "</div></div>"
+    "<div class='card'><h5>Laatste Reboot Reden</h5><p>";
+static const char PAGE_END[] PROGMEM = "</p></div></div></body></html>";
+
+// Houdt de pagina bij via /events of /api/state in plaats van de hele pagina te verversen.
+// Werkt voor elk element met een bekend id, zowel op / als op /dashboard.
+static const char PORTAL_JS[] PROGMEM =
+    "function t(id,v){var e=document.getElementById(id);if(e)e.textContent=v}"
+    "function f(v){return v==null?'-':v.toFixed(1)}"
+    "function u(s){s.relays.forEach(function(r,i){var e=document.getElementById('r'+i);"
+    "if(e){e.textContent=r.on?'On':'Off';e.className='badge '+(r.on?'on':'off')}});"
+    "t('buf',f(s.buffer));t('out',f(s.outdoor));t('mode',s.mode+(s.manual?' (handmatig)':''));"
+    "s.runtime_min.forEach(function(m,i){t('rt'+i,(m/60).toFixed(1)+' u')});"
+    "t('health',(s.health.wifi?'WiFi ok':'WiFi weg')+', '+(s.health.mqtt?'MQTT ok':'MQTT weg')+"
+    "(s.health.sensor?'':', sensorfout')+(s.health.alarm?', ALARM':''))}"
+    "var s=null;"
+    "function m(d){if(!s)return;for(var k in d){if(k=='relays'){for(var i in d.relays)Object.assign(s.relays[i],d.relays[i])}"
+    "else s[k]=d[k]}u(s)}"
+    "function p(){fetch('/api/state',{cache:'no-cache'}).then(function(r){return r.ok?r.json():null})"
+    ".then(function(n){if(n){s=n;u(s)}}).catch(function(){}).then(function(){setTimeout(p,5000)})}"
+    // Live via /events; lukt dat niet, dan elke 5 seconden pollen
+    "if(window.EventSource){var e=new EventSource('/events');"
+    "e.addEventListener('state',function(v){s=JSON.parse(v.data);u(s)});"
+    "e.addEventListener('delta',function(v){m(JSON.parse(v.data))});"
+    "e.onerror=function(){if(e.readyState==2)p()}}else p();";
+
+// Dashboard; de rijen voor relais en draaitijden volgen uit PUMP_COUNT en COOLING_RELAY
+static const char DASHBOARD_START[] PROGMEM =
+    "<body><div class='container'><h1>Warmtepompregelaar</h1>"
+    "<div class='card'><h5>Temperaturen</h5><table>"
+    "<tr><td>Buffer</td><td><span id='buf'>-</span> &deg;C</td></tr>"
+    "<tr><td>Buiten</td><td><span id='out'>-</span> &deg;C</td></tr>"
+    "<tr><td>Modus</td><td id='mode'>-</td></tr></table></div>"
+    "<div class='card'><h5>Relais</h5><ul>";
+static const char DASHBOARD_RUNTIMES[] PROGMEM = "</ul></div><div class='card'><h5>Draaitijden</h5><table>";
+static const char DASHBOARD_END[] PROGMEM =
+    "</table></div>"
+    "<div class='card'><h5>Status</h5><p id='health'>-</p><p><a href='/'>Bediening en log</a></p></div>"
+    "</div></body></html>";
+
+static void formatTime(unsigned long timestamp, char* buffer, size_t size) {
+    if (timestamp == 0) { // Geen tijd beschikbaar
+        snprintf(buffer, size, "N/A");
+        return;
+    }
     time_t rawTime = timestamp; // Direct naar seconden
     struct tm* timeInfo = localtime(&rawTime);
-    char buffer[10];
-    strftime(buffer, sizeof(buffer), "%H:%M:%S", timeInfo);
-    return String(buffer);
+    strftime(buffer, size, "%H:%M:%S", timeInfo);
 }
 
-void setupPortal(const char* hostname) {
-    if (!MDNS.begin(hostname)) {
-        debugPrint("Error setting up mDNS responder!");
-    } else {
-        debugPrint(String("mDNS responder started. Visit: http://") + hostname + ".local");
-        MDNS.addService("http", "tcp", 80);
+// Regels uit de logbuffer schrijven, eventueel alleen van één onderdeel
+static void writeLog(PageWriter& page, bool tableRows, int subsystem) {
+    LogIterator iterator = logBegin();
+    LogRecord record;
+    while (logNext(iterator, record)) {
+        if (subsystem >= 0 && record.subsystem != subsystem) continue;
+
+        unsigned long seconds = record.timestampMs / 1000;
+        unsigned long millisPart = record.timestampMs % 1000;
+        if (tableRows) {
+            page.printf("<tr><td>%lu.%03lu</td><td>", seconds, millisPart);
+            page.printEscaped(record.message);
+            page.print("</td></tr>");
+        } else {
+            page.printf("%lu.%03lu [%s] %s ", seconds, millisPart, logSubsystemName(record.subsystem), logLevelName(record.level));
+            page.printEscaped(record.message);
+            page.print("<br>");
+        }
     }
+}
+
+// Hoofdpagina rechtstreeks naar de socket schrijven
+// Opmaak en script met de build in de URL; zo'n URL verwijst altijd naar dezelfde inhoud
+static void printAssets(PageWriter& page) {
+    page.printf("<link rel='stylesheet' href='/style.css?v=%s'><script src='/app.js?v=%s' defer></script></head>", buildId, buildId);
+}
+
+static void handleRoot() {
+    StageTimer timer(STAGE_RENDER);
+    uint32_t heapBefore = ESP.getFreeHeap();
+    unsigned long start = millis();
 
-    debugPrint("WebServer gestart op IP: " + WiFi.localIP().toString());
+    // Alles wat de regeltaak beheert komt uit één consistente momentopname
+    ControllerState state;
+    getControllerState(state);
 
-    server.on("/", HTTP_GET, []() {
-        sensors.requestTemperatures();
-        String page = "<html><head>";
-        if (!server.hasArg("updating")) { // Alleen refreshtimer als er geen update plaatsvindt
-            page += "<meta http-equiv=\"refresh\" content=\"60\">"; // 1 minuut refresh
+    PageWriter page(server);
+    page.begin(200, "text/html");
+    page.print_P(PAGE_HEAD);
+    printAssets(page);
+    page.print_P(PAGE_BODY_START);
+
+    // Status en modus
+    page.printf("<label><input type='radio' name='mode' value='auto' %s> Automatisch</label><br>", !state.manualMode ? "checked" : "");
+    page.printf("<label><input type='radio' name='mode' value='manual' %s> Handmatig</label><br>", state.manualMode ? "checked" : "");
+    page.print_P(PAGE_MODE_END);
+
+    // Relais status
+    char onTime[16];
+    char offTime[16];
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        formatTime(state.lastOnTimes[i], onTime, sizeof(onTime));
+        formatTime(state.lastOffTimes[i], offTime, sizeof(offTime));
+        page.printf("<li>Relay %d<span id='r%d' class='badge %s'>%s</span><br>Last On: %s<br>Last Off: %s<br>Schakelingen: %u",
+                    i + 1, i, state.relayStatus[i] ? "on" : "off", state.relayStatus[i] ? "On" : "Off", onTime, offTime,
+                    i < OUTPUT_CHANNELS ? (unsigned)state.outputs.actuations[i] : 0);
+        if (state.manualMode) {
+            page.printf("<form method='POST' action='/toggle?relay=%d'><button type='submit' class='btn sec'>%s</button></form>",
+                        i, state.relayStatus[i] ? "Uitzetten" : "Aanzetten");
         }
-        page += "<link rel=\"stylesheet\" href=\"https://cdn.jsdelivr.net/npm/bootstrap@5.3.0/dist/css/bootstrap.min.css\">";
-        page += "</head><body class='bg-light'>";
-        page += "<div class='container mt-5'>";
-        page += "<h1 class='text-center mb-4'>LilyGO Relay Portal V3</h1>";
-
-        // Status en modus
-        page += "<div class='card mb-3'><div class='card-body'>";
-        page += "<h5 class='card-title'>Mode</h5>";
-        page += "<form method='POST' action='/mode'>";
-        page += "<label><input type='radio' name='mode' value='auto' " + String(!manualMode ? "checked" : "") + "> Automatisch</label><br>";
-        page += "<label><input type='radio' name='mode' value='manual' " + String(manualMode ? "checked" : "") + "> Handmatig</label><br>";
-        page += "<button type='submit' class='btn btn-primary mt-2'>Opslaan</button>";
-        page += "</form>";
-        page += "</div></div>";
-
-        // Relais status
-        page += "<div class='card'><div class='card-body'>";
-        page += "<h5 class='card-title'>Relais Status</h5><ul class='list-group'>";
-        for (int i = 0; i < 6; i++) {
-            page += "<li class='list-group-item d-flex justify-content-between align-items-center'>Relay " + String(i + 1);
-            page += (relayStatus[i] ? "<span class='badge bg-success'>On</span>" : "<span class='badge bg-danger'>Off</span>");
-            page += "<br>Last On: " + formatTime(lastOnTimes[i]);
-            page += "<br>Last Off: " + formatTime(lastOffTimes[i]);
-            if (manualMode) {
-                page += "<form method='POST' action='/toggle?relay=" + String(i) + "'>";
-                page += "<button type='submit' class='btn btn-sm btn-secondary mt-2'>" + String(relayStatus[i] ? "Uitzetten" : "Aanzetten") + "</button>";
-                page += "</form>";
-            }
-            page += "</li>";
+        page.print("</li>");
+    }
+
+    // MQTT Info
+    page.print_P(PAGE_MQTT_START);
+    if (mqttClient.connected()) {
+        writeLog(page, true, LOG_MQTT);
+    } else {
+        page.print_P(PAGE_MQTT_OFFLINE);
+    }
+
+    // Outdoor Temperature
+    page.print_P(PAGE_OUTDOOR_START);
+    page.printf("%.2f", state.outdoorTemperature);
+
+    // Firmware Update en debug log
+    page.print_P(PAGE_UPDATE);
+    writeLog(page, false, -1);
+
+    // Reboot Reason
+    page.print_P(PAGE_REBOOT_START);
+    page.printEscaped(rebootReason.c_str());
+    page.print_P(PAGE_END);
+    page.end();
+
+    renderStats.lastDurationMs = millis() - start;
+    renderStats.lastPeakHeapBytes = heapBefore > page.getMinFreeHeap() ? heapBefore - page.getMinFreeHeap() : 0;
+    if (renderStats.lastPeakHeapBytes > renderStats.maxPeakHeapBytes) {
+        renderStats.maxPeakHeapBytes = renderStats.lastPeakHeapBytes;
+    }
+}
+
+// Vaste bestanden uit flash; veranderen alleen met nieuwe firmware. Met de build van nu in de URL
+// mag de browser ze voorgoed bewaren; zonder (of met een oude) eerst navragen via het ETag.
+static void sendStatic(const char* contentType, PGM_P content) {
+    char etag[12];
+    snprintf(etag, sizeof(etag), "\"%s\"", buildId);
+    server.sendHeader("ETag", etag);
+    if (server.arg("v") == buildId) {
+        server.sendHeader("Cache-Control", "public, max-age=31536000, immutable");
+    } else {
+        server.sendHeader("Cache-Control", "no-cache");
+        if (server.header("If-None-Match") == etag) {
+            server.send(304);
+            return;
         }
-        page += "</ul></div></div>";
+    }
+    server.send_P(200, contentType, content);
+}
 
-        // MQTT Info
-        page += "<div class='card mt-3'><div class='card-body'>";
-        page += "<h5 class='card-title'>MQTT Info</h5><table class='table'>";
-        page += "<thead><tr><th>Topic</th><th>Payload</th></tr></thead><tbody>";
+static void handleStyle() {
+    sendStatic("text/css", PORTAL_CSS);
+}
+
+static void handleScript() {
+    sendStatic("application/javascript", PORTAL_JS);
+}
+
+// Verandert alleen met de firmware. De URL blijft gelijk, dus steeds navragen; het ETag van de
+// build maakt dat een 304 zolang er geen nieuwe firmware is.
+static void handleDashboard() {
+    char etag[12];
+    snprintf(etag, sizeof(etag), "\"%s\"", buildId);
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Cache-Control", "no-cache");
+    if (server.header("If-None-Match") == etag) {
+        server.send(304);
+        return;
+    }
+
+    PageWriter page(server);
+    page.begin(200, "text/html");
+    page.print_P(PAGE_HEAD);
+    printAssets(page);
+    page.print_P(DASHBOARD_START);
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (i < PUMP_COUNT) page.printf("<li>Pomp %d", i + 1);
+        else if (i == COOLING_RELAY) page.print("<li>Koelen");
+        else page.printf("<li>Relay %d", i + 1);
+        page.printf("<span id='r%d' class='badge'>-</span></li>", i);
+    }
+    page.print_P(DASHBOARD_RUNTIMES);
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        page.printf("<tr><td>Pomp %d</td><td id='rt%d'>-</td></tr>", i + 1, i);
+    }
+    page.print_P(DASHBOARD_END);
+    page.end();
+}
+
+// Toestand als JSON. Het ETag volgt het versienummer, dus een ongewijzigde toestand kost alleen een 304.
+static void handleApiState() {
+    ControllerState state;
+    uint32_t version = getControllerState(state);
+
+    char etag[24];
+    snprintf(etag, sizeof(etag), "\"%08lx-%lx\"", (unsigned long)etagSalt, (unsigned long)version);
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Cache-Control", "no-cache");
+
+    if (server.header("If-None-Match") == etag) {
+        server.send(304);
+        return;
+    }
 
-        if (mqttClient.connected()) {
-            mqttClient.loop();
-            page += mqttLog;
+    char json[768];
+    size_t length = serializeControllerState(state, version, json, sizeof(json));
+    if (length == 0) {
+        server.send(500, "text/plain", "state te groot");
+        return;
+    }
+    server.send(200, "application/json", json);
+}
+
+// Verloop uit History als CSV (tijd,waarde) of binair (format=bin). from en to zijn Unix-tijd,
+// of seconden sinds de start zolang de klok nog niet gesynchroniseerd is; standaard het laatste uur.
+static void handleApiHistory() {
+    HistorySeries series;
+    if (!server.hasArg("series") || !historySeriesFromName(server.arg("series").c_str(), series)) {
+        server.send(400, "text/plain", "series moet buffer, outdoor of relays zijn");
+        return;
+    }
+
+    // Unix-tijd = uptime + offset
+    uint64_t uptime = millis64() / 1000ULL;
+    time_t now = time(nullptr);
+    bool unixClock = now > 1700000000; // Na NTP-synchronisatie
+    uint64_t offset = unixClock ? (uint64_t)now - uptime : 0;
+
+    uint64_t to = server.hasArg("to") ? strtoull(server.arg("to").c_str(), nullptr, 10) : uptime + offset;
+    uint64_t from = server.hasArg("from") ? strtoull(server.arg("from").c_str(), nullptr, 10) : (to > 3600 ? to - 3600 : 0);
+    to = to > offset ? to - offset : 0;
+    from = from > offset ? from - offset : 0;
+    bool binary = server.arg("format") == "bin";
+
+    HistoryCursor cursor;
+    bool found = findHistory(series, from, to, cursor);
+    uint16_t count = found ? historyRemaining(cursor) : 0;
+
+    server.sendHeader("Cache-Control", "no-cache");
+    server.sendHeader("X-History-Clock", unixClock ? "unix" : "uptime");
+    PageWriter page(server);
+    page.begin(200, binary ? "application/octet-stream" : "text/csv");
+
+    if (binary) {
+        HistoryHeader header = {{'W', 'H'}, 1, series, found ? cursor.intervalSeconds : 0,
+                                found ? (uint32_t)(cursor.firstSeconds + offset) : 0, count};
+        page.writeBytes(&header, sizeof(header));
+    } else {
+        page.printf("time,%s\n", server.arg("series").c_str());
+    }
+
+    int16_t value;
+    uint64_t sampleTime = found ? cursor.firstSeconds + offset : 0;
+    while (found && nextHistory(cursor, value)) {
+        if (binary) {
+            page.writeBytes(&value, sizeof(value));
+        } else if (value == HISTORY_GAP) {
+            page.printf("%lu,\n", (unsigned long)sampleTime);
+        } else if (series == HISTORY_RELAYS) {
+            page.printf("%lu,%d\n", (unsigned long)sampleTime, value);
         } else {
-            page += "<tr><td colspan='2'>Niet verbonden met MQTT</td></tr>";
+            page.printf("%lu,%.2f\n", (unsigned long)sampleTime, value / 100.0);
         }
+        sampleTime += cursor.intervalSeconds;
+    }
+    page.end();
+}
 
-        page += "</tbody></table></div></div>";
+// Tijden per stap en heap in het tekstformaat van Prometheus. Emmers zijn cumulatief, zoals Prometheus verwacht.
+static void handleMetrics() {
+    PageWriter page(server);
+    page.begin(200, "text/plain; version=0.0.4");
 
-        // Outdoor Temperature
-        page += "<div class='card mt-3'><div class='card-body'>";
-        page += "<h5 class='card-title'>Buitentemperatuur</h5>";
-        page += "<p>" + String(outdoorTemperatureOnline) + "&deg;C</p>";
-        page += "</div></div>";
+    page.print("# HELP warmtepomp_stage_duration_microseconds Duur per stap van de regeling en het netwerk\n"
+               "# TYPE warmtepomp_stage_duration_microseconds histogram\n");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const char* name = metricStageName((MetricStage)i);
+        StageHistogram histogram = getStageHistogram((MetricStage)i);
+        uint32_t cumulative = 0;
+        for (uint8_t bucket = 0; bucket < METRIC_BUCKETS - 1; bucket++) {
+            cumulative += histogram.buckets[bucket];
+            page.printf("warmtepomp_stage_duration_microseconds_bucket{stage=\"%s\",le=\"%lu\"} %lu\n", name,
+                        (unsigned long)metricBucketBoundUs(bucket), (unsigned long)cumulative);
+        }
+        page.printf("warmtepomp_stage_duration_microseconds_bucket{stage=\"%s\",le=\"+Inf\"} %lu\n", name, (unsigned long)histogram.count);
+        page.printf("warmtepomp_stage_duration_microseconds_sum{stage=\"%s\"} %llu\n", name, (unsigned long long)histogram.sumUs);
+        page.printf("warmtepomp_stage_duration_microseconds_count{stage=\"%s\"} %lu\n", name, (unsigned long)histogram.count);
+    }
 
-        // Firmware Update
-        page += "<div class='card mt-3'><div class='card-body'>";
-        page += "<h5 class='card-title'>Firmware Update</h5>";
-        page += "<form method='POST' action='/update' enctype='multipart/form-data'>";
-        page += "<input type='file' name='update' class='form-control mb-3'><br>";
-        page += "<button type='submit' class='btn btn-primary'>Update Firmware</button>";
-        page += "</form>";
-        page += "</div></div>";
-
-        // Debug log
-        page += "<div class='card mt-3'><div class='card-body'>";
-        page += "<h5 class='card-title'>Debug Log</h5>";
-        page += "<div style='font-family:monospace; white-space:pre-wrap; max-height: 300px; overflow-y: auto;'>";
-        page += debugLog;
-        page += "</div></div></div>";
-
-        // Reboot Reason
-        page += "<div class='card mt-3'><div class='card-body'>";
-        page += "<h5 class='card-title'>Laatste Reboot Reden</h5>";
-        page += "<p>" + rebootReason + "</p>";
-        page += "</div></div>";
-
-        page += "</div></body></html>";
-        server.send(200, "text/html", page);
+    page.print("# HELP warmtepomp_stage_duration_max_microseconds Langste duur per stap sinds het opstarten\n"
+               "# TYPE warmtepomp_stage_duration_max_microseconds gauge\n");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        page.printf("warmtepomp_stage_duration_max_microseconds{stage=\"%s\"} %lu\n", metricStageName((MetricStage)i),
+                    (unsigned long)getStageHistogram((MetricStage)i).maxUs);
+    }
+
+    SystemMetrics system = getSystemMetrics();
+    page.printf("# TYPE warmtepomp_heap_free_bytes gauge\nwarmtepomp_heap_free_bytes %lu\n", (unsigned long)system.freeHeap);
+    page.printf("# TYPE warmtepomp_heap_min_free_bytes gauge\nwarmtepomp_heap_min_free_bytes %lu\n", (unsigned long)system.minFreeHeap);
+    page.printf("# TYPE warmtepomp_heap_largest_free_block_bytes gauge\nwarmtepomp_heap_largest_free_block_bytes %lu\n",
+                (unsigned long)system.largestFreeBlock);
+    page.printf("# TYPE warmtepomp_wifi_rssi_dbm gauge\nwarmtepomp_wifi_rssi_dbm %d\n", system.rssi);
+    page.printf("# TYPE warmtepomp_mqtt_publish_failures_total counter\nwarmtepomp_mqtt_publish_failures_total %lu\n",
+                (unsigned long)getMqttConnectionStats().publishFailures);
+
+    const SupervisorReport& boot = getCurrentBoot();
+    page.print("# HELP warmtepomp_stage_deadline_misses_total Keer dat een stap na zijn budget klaar was\n"
+               "# TYPE warmtepomp_stage_deadline_misses_total counter\n");
+    for (uint8_t i = 0; i < boot.stageCount; i++) {
+        page.printf("warmtepomp_stage_deadline_misses_total{stage=\"%s\"} %u\n", boot.names[i], (unsigned)boot.misses[i]);
+    }
+    SupervisorStats supervisor = getSupervisorStats();
+    page.printf("# TYPE warmtepomp_watchdog_feeds_total counter\nwarmtepomp_watchdog_feeds_total %lu\n", (unsigned long)supervisor.feeds);
+    page.printf("# TYPE warmtepomp_watchdog_withheld_total counter\nwarmtepomp_watchdog_withheld_total %lu\n",
+                (unsigned long)supervisor.withheld);
+    page.end();
+}
+
+// Segmenten van de trace op volgorde, oudste eerst; af te spelen met sim/tracereplay
+static void handleApiTrace() {
+    syncTrace(); // Wat nog in de wachtrij en de pagina in RAM staat meenemen
+    uint32_t sequences[TRACE_SEGMENTS];
+    uint8_t count = listTraceSegments(sequences, TRACE_SEGMENTS);
+
+    server.sendHeader("Content-Disposition", "attachment; filename=\"warmtepomp.trace\"");
+    PageWriter page(server);
+    page.begin(200, "application/octet-stream");
+    char path[24];
+    uint8_t buffer[256];
+    for (uint8_t i = 0; i < count; i++) {
+        traceSegmentPath(sequences[i], path, sizeof(path));
+        File file = LittleFS.open(path, "r");
+        if (!file) continue;
+        size_t length;
+        while ((length = file.read(buffer, sizeof(buffer))) > 0) {
+            page.writeBytes(buffer, length);
+            stageProgress(); // Tot 512 KB over een trage verbinding; zolang er iets weggaat is de stap niet vastgelopen
+        }
+        file.close();
+    }
+    page.end();
+}
+
+PortalRenderStats getPortalRenderStats() {
+    return renderStats;
+}
+
+void setupPortal(const char* hostname) {
+    if (!MDNS.begin(hostname)) {
+        logPrintf(LOG_ERROR, LOG_PORTAL, "Error setting up mDNS responder!");
+    } else {
+        logPrintf(LOG_INFO, LOG_PORTAL, "mDNS responder started. Visit: http://%s.local", hostname);
+        MDNS.addService("http", "tcp", 80);
+    }
+
+    server.on("/", HTTP_GET, handleRoot);
+    server.on("/style.css", HTTP_GET, handleStyle);
+    server.on("/app.js", HTTP_GET, handleScript);
+    server.on("/dashboard", HTTP_GET, handleDashboard);
+    server.on("/api/state", HTTP_GET, handleApiState);
+    server.on("/api/history", HTTP_GET, handleApiHistory);
+    server.on("/metrics", HTTP_GET, handleMetrics);
+    server.on("/api/trace", HTTP_GET, handleApiTrace);
+    server.on("/events", HTTP_GET, []() {
+        handleEventsRequest(server);
     });
 
-    // Verander modus
+    // If-None-Match is nodig voor de 304-afhandeling van /api/state, /dashboard en de vaste bestanden
+    static const char* collectedHeaders[] = {"If-None-Match"};
+    server.collectHeaders(collectedHeaders, 1);
+    etagSalt = esp_random(); // ETags van voor een herstart nooit hergebruiken
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    const uint8_t* hash = esp_app_get_description()->app_elf_sha256;
+#else
+    const uint8_t* hash = esp_ota_get_app_description()->app_elf_sha256;
+#endif
+    snprintf(buildId, sizeof(buildId), "%02x%02x%02x%02x", hash[0], hash[1], hash[2], hash[3]);
+
+    // Verander modus. De regeltaak voert de opdracht uit; de portal schrijft zelf geen relaisstatus.
     server.on("/mode", HTTP_POST, []() {
         if (server.hasArg("mode")) {
-            manualMode = server.arg("mode") == "manual";
-            debugPrint(String("Mode veranderd naar: ") + (manualMode ? "Handmatig" : "Automatisch"));
+            bool manual = server.arg("mode") == "manual";
+            Command command = {CMD_SET_MANUAL, 0, manual};
+            if (pushCommand(command)) {
+                logPrintf(LOG_INFO, LOG_PORTAL, "Mode veranderd naar: %s", manual ? "Handmatig" : "Automatisch");
+            } else {
+                logPrintf(LOG_WARN, LOG_PORTAL, "Opdrachtwachtrij vol, mode niet veranderd");
+            }
         }
         server.sendHeader("Location", "/");
         server.send(303);
@@ -140,57 +483,74 @@ void setupPortal(const char* hostname) {
     server.on("/toggle", HTTP_POST, []() {
         if (server.hasArg("relay")) {
             int relayIndex = server.arg("relay").toInt();
-            if (relayIndex >= 0 && relayIndex < 6) {
-                relayStatus[relayIndex] = !relayStatus[relayIndex];
-                debugPrint(String("Relay ") + relayIndex + (relayStatus[relayIndex] ? " aangezet" : " uitgezet"));
+            if (relayIndex >= 0 && relayIndex < RELAY_COUNT) {
+                Command command = {CMD_TOGGLE_RELAY, (uint8_t)relayIndex, false};
+                if (pushCommand(command)) {
+                    logPrintf(LOG_INFO, LOG_PORTAL, "Relay %d omschakelen aangevraagd", relayIndex);
+                } else {
+                    logPrintf(LOG_WARN, LOG_PORTAL, "Opdrachtwachtrij vol, relay %d niet geschakeld", relayIndex);
+                }
             }
         }
         server.sendHeader("Location", "/");
         server.send(303);
     });
-    // Werkende versie. Niks op aanpassen!
+    // De digest staat in de query (/update?sha256=...), want velden uit het formulier zijn
+    // tijdens de upload nog niet beschikbaar. Met curl: curl -F update=@image.bin 'http://verwarming.local/update?sha256=...'
     server.on("/update", HTTP_GET, []() {
         String page = "<html><body class='bg-light'>";
         page += "<div class='container mt-5'>";
         page += "<h1 class='text-center mb-4'>Firmware Update</h1>";
-        page += "<form method='POST' action='/update' enctype='multipart/form-data' class='text-center'>";
+        page += "<form method='POST' action='/update' enctype='multipart/form-data' class='text-center' "
+                "onsubmit=\"this.action='/update?sha256='+this.sha256.value\">";
         page += "<input type='file' name='update' class='form-control mb-3'><br>";
+        page += "<input type='text' name='sha256' placeholder='SHA-256 van het image' size='64' required><br><br>";
         page += "<input type='submit' value='Update Firmware' class='btn btn-primary'>";
         page += "</form></div></body></html>";
         server.send(200, "text/html", page);
     });
 
     server.on("/update", HTTP_POST, []() {
-        bool shouldReboot = !Update.hasError();
-        String message = shouldReboot ? "Update complete. Rebooting..." : "Update failed!";
-        debugPrint(message);
-        server.send(200, "text/plain", message);
-        if (shouldReboot) {
-            delay(100);
-            ESP.restart();
+        OtaStats stats = getOtaStats();
+        if (stats.state != OTA_SUCCEEDED) {
+            server.send(400, "text/plain", String("Update mislukt: ") + getOtaError());
+            return;
         }
+
+        char message[128];
+        snprintf(message, sizeof(message), "Update geslaagd: %u bytes, %u B/s, %u ms schrijven. Herstarten...",
+                 (unsigned)stats.bytesWritten, (unsigned)stats.bytesPerSecond, (unsigned)stats.stalledMs);
+        server.send(200, "text/plain", message);
+        delay(100);
+        ESP.restart();
     }, []() {
         HTTPUpload& upload = server.upload();
         if (upload.status == UPLOAD_FILE_START) {
-            String message = "Update Start: " + upload.filename;
-            debugPrint(message);
-            if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
-                Update.printError(Serial);
-            }
+            logPrintf(LOG_INFO, LOG_PORTAL, "Update Start: %s", upload.filename.c_str());
+            otaBegin(server.arg("sha256").c_str());
         } else if (upload.status == UPLOAD_FILE_WRITE) {
-            if (Update.write(upload.buf, upload.currentSize) != upload.currentSize) {
-                Update.printError(Serial);
-            }
+            otaWrite(upload.buf, upload.currentSize);
         } else if (upload.status == UPLOAD_FILE_END) {
-            if (Update.end(true)) {
-                String message = "Update Success: " + String(upload.totalSize) + " bytes.";
-                debugPrint(message);
-            } else {
-                Update.printError(Serial);
-            }
+            otaEnd();
+        } else if (upload.status == UPLOAD_FILE_ABORTED) {
+            otaAbort();
         }
     });
 
+    // Uitkomst en doorvoer van de laatste update, en of deze firmware nog bevestigd moet worden
+    server.on("/api/ota", HTTP_GET, []() {
+        static const char* const stateNames[] = {"idle", "receiving", "succeeded", "failed"};
+        OtaStats stats = getOtaStats();
+        char json[320];
+        snprintf(json, sizeof(json),
+                 "{\"state\":\"%s\",\"bytes\":%u,\"duration_ms\":%u,\"bytes_per_s\":%u,\"stalled_ms\":%u,"
+                 "\"max_stall_ms\":%u,\"chunks\":%u,\"pending_verify\":%s,\"error\":\"%s\"}",
+                 stateNames[stats.state], (unsigned)stats.bytesWritten, (unsigned)stats.durationMs, (unsigned)stats.bytesPerSecond,
+                 (unsigned)stats.stalledMs, (unsigned)stats.maxStallMs, (unsigned)stats.chunks,
+                 otaPendingVerify() ? "true" : "false", getOtaError());
+        server.send(200, "application/json", json);
+    });
+
     server.begin();
-    debugPrint("WebServer gestart op IP: " + WiFi.localIP().toString());
+    logPrintf(LOG_INFO, LOG_PORTAL, "WebServer gestart op IP: %s", WiFi.localIP().toString().c_str());
 }
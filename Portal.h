@@ -4,18 +4,20 @@
 #include <Arduino.h>
 #include <WebServer.h>
 extern WebServer server; // Gebruik de gedeelde WebServer-instantie
-extern String mqttLog;
 extern String rebootReason;
 
-
-// Externe arrays voor relaisstatus en tijdstempels
-extern bool relayStatus[6];
-extern unsigned long lastOnTimes[6];
-extern unsigned long lastOffTimes[6];
-
 // Functie om relaisstatus naar de portal te publiceren
 void publishRelayStatus(bool* relaisStatus, unsigned long* lastOnTimes, unsigned long* lastOffTimes, int relaisCount);
 
+// Geheugen- en tijdgebruik van de laatste weergave van de hoofdpagina
+struct PortalRenderStats {
+    uint32_t lastDurationMs;
+    uint32_t lastPeakHeapBytes;   // Vrije heap voor de weergave min het laagste punt tijdens de weergave
+    uint32_t maxPeakHeapBytes;
+};
+
+PortalRenderStats getPortalRenderStats();
+
 // Functie om de webportal in te stellen
 void setupPortal(const char* hostname);
 
@@ -0,0 +1,59 @@
+#ifndef PUMPCONFIG_H
+#define PUMPCONFIG_H
+
+#include <Arduino.h>
+
+// Samenstelling van de cascade. Alles ligt vast bij het compileren; tabellen in PumpMaster, RuntimeStore,
+// MQTT en ControllerState volgen hieruit. Een grotere cascade: bouwen met -DPUMP_COUNT=5; dat is het maximum,
+// want de print heeft zes relais en de kanalen 6 en 7 van het schuifregister zijn de leds.
+// Let op: een ander aantal pompen maakt de opgeslagen draaitijden in flash ongeldig.
+
+#ifndef PUMP_COUNT
+#define PUMP_COUNT 3    // Warmtepompen in de cascade
+#endif
+
+#ifndef RELAY_COUNT
+#define RELAY_COUNT 6   // Relais op de print
+#endif
+
+// Kanalen van het schuifregister na de relais
+constexpr uint8_t LED_BOOT_CHANNEL = 6; // CH7: brandt tot de opstart gepubliceerd is
+constexpr uint8_t LED_WIFI_CHANNEL = 7; // CH8: brandt zolang WiFi niet verbonden is
+
+// Pompen zitten op de eerste relais, het koelrelais direct daarna
+constexpr uint8_t pumpRelay(int pumpIndex) {
+    return (uint8_t)pumpIndex;
+}
+constexpr uint8_t COOLING_RELAY = PUMP_COUNT;
+
+static_assert(PUMP_COUNT > 0 && PUMP_COUNT <= 16, "PUMP_COUNT buiten bereik");
+static_assert(COOLING_RELAY < RELAY_COUNT, "Te weinig relais voor de pompen en het koelrelais");
+static_assert(RELAY_COUNT <= LED_BOOT_CHANNEL, "Relais zouden de leds aansturen");
+
+// Wachttijden van de cascade (in milliseconden)
+constexpr unsigned long PUMP_MIN_ON_TIME = 15UL * 60UL * 1000UL;     // Minimaal aan voordat een pomp weer uit mag
+constexpr unsigned long PUMP_MIN_OFF_TIME = 15UL * 60UL * 1000UL;    // Minimaal uit voordat een pomp weer aan mag
+constexpr unsigned long RUNTIME_SAVE_INTERVAL = 15UL * 60UL * 1000UL; // Draaitijden naar flash
+
+// Trapsgewijs bijschakelen naar behoefte. Pompen komen er één voor één bij: na elke schakelactie wacht een
+// volgende in dezelfde richting tot de gemeten helling het effect laat zien. Terugschakelen wacht daar niet op,
+// en er mogen meerdere pompen tegelijk af.
+constexpr unsigned long STAGE_SETTLE_TIME = 5UL * 60UL * 1000UL;     // Na een schakelactie, voor de volgende in dezelfde richting
+constexpr unsigned long SLOPE_INTERVAL = 60UL * 1000UL;              // Meetinterval voor de helling van de buffertemperatuur
+constexpr float SLOPE_SMOOTHING = 0.3;                               // Gewicht van een nieuwe hellingmeting
+constexpr float STAGE_LOOKAHEAD_MINUTES = 10.0;                      // Vooruitkijken met de gemeten helling
+constexpr unsigned long STARTS_WINDOW = 60UL * 60UL * 1000UL;        // Venster voor starts per uur
+
+// Stooklijn: doeltemperatuur van het buffervat bij verwarmen, lineair tussen twee punten en daarbuiten begrensd
+constexpr float HEATING_CURVE_MILD_OUTDOOR = 15.0;   // Bij deze buitentemperatuur...
+constexpr float HEATING_CURVE_MILD_TARGET = 25.0;    // ...is dit het doel
+constexpr float HEATING_CURVE_COLD_OUTDOOR = -10.0;
+constexpr float HEATING_CURVE_COLD_TARGET = 40.0;
+constexpr float HEATING_TARGET_FALLBACK = 30.0;      // Zonder buitentemperatuur
+
+// Voorsturing: verwachte warmtevraag van het huis, uitgedrukt in pompen
+constexpr float HOUSE_LOSS_KW_PER_K = 0.25;          // Warmteverlies van het huis (UA)
+constexpr float HOUSE_INDOOR_TEMPERATURE = 20.0;     // Binnentemperatuur bij verwarmen
+constexpr float PUMP_CAPACITY_KW = 6.0;              // Vermogen van één pomp
+
+#endif // PUMPCONFIG_H
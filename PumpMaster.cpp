@@ -1,20 +1,20 @@
 #include "PumpMaster.h"
-#include "MQTT.h" // Zorg ervoor dat MQTT.cpp is geïmporteerd voor getRuntime en publiceren
+#include "MQTT.h" // Zorg ervoor dat MQTT.cpp is geïmporteerd voor de eenmalige startwaarde van de draaitijd
 #include "Debug.h"
 
-// Globale wachttijden (in milliseconden)
-const unsigned long NORMAL_ON_TIME = 15 * 60 * 1000;
-const unsigned long NORMAL_OFF_TIME = 15 * 60 * 1000;
-const unsigned long NORMAL_CHANGE_TIME = 30 * 60 * 1000;
-const float TEMP_HYSTERESIS = 5.0;
-const unsigned long RUNTIME_UPDATE_INTERVAL = 10 * 60 * 1000;
+float heatingCurveTarget(float outdoorTemperature) {
+    float outdoor = constrain(outdoorTemperature, HEATING_CURVE_COLD_OUTDOOR, HEATING_CURVE_MILD_OUTDOOR);
+    float fraction = (HEATING_CURVE_MILD_OUTDOOR - outdoor) / (HEATING_CURVE_MILD_OUTDOOR - HEATING_CURVE_COLD_OUTDOOR);
+    return HEATING_CURVE_MILD_TARGET + fraction * (HEATING_CURVE_COLD_TARGET - HEATING_CURVE_MILD_TARGET);
+}
 
-// Draaiuren opslag
-unsigned long savedRuntime[3] = {0, 0, 0};
-unsigned long lastRuntimeUpdate = 0;
+float expectedLoadPumps(float outdoorTemperature) {
+    float loadKw = HOUSE_LOSS_KW_PER_K * (HOUSE_INDOOR_TEMPERATURE - outdoorTemperature);
+    return loadKw > 0.0 ? loadKw / PUMP_CAPACITY_KW : 0.0;
+}
 
 bool PumpMaster::getPumpStatus(int pumpIndex) {
-    if (pumpIndex >= 0 && pumpIndex < 3) {
+    if (pumpIndex >= 0 && pumpIndex < PUMP_COUNT) {
         return pumpStatus[pumpIndex];
     } else {
         return false;
@@ -22,30 +22,113 @@ bool PumpMaster::getPumpStatus(int pumpIndex) {
 }
 
 void PumpMaster::updateRuntimeFromMQTT() {
-    unsigned long runtimes[3] = {0, 0, 0};
-    getAllRuntimes(runtimes); // Haal alle runtimes in één keer op
+    // De run_time van de pomp (seconden) alleen gebruiken als er lokaal nog niets bekend is
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        unsigned long seed;
+        if (!runtimeSeeded[i] && getRuntimeSeed(i, seed)) {
+            runtimeSeeded[i] = true;
+            if (seed != 0 && seed != (unsigned long)-1) {
+                runtimeMs[i] += (uint64_t)seed * 1000ULL; // Lokaal telde vanaf 0, dus optellen
+                runtimeDirty = true;
+                sortRuntimeOrder();
+                logPrintf(LOG_INFO, LOG_PUMPS, "Draaitijd pomp %d overgenomen uit MQTT: %lu s", i + 1, seed);
+            }
+        }
+    }
+}
+
+uint64_t PumpMaster::getRuntime(int pumpIndex) {
+    if (pumpIndex >= 0 && pumpIndex < PUMP_COUNT) {
+        return runtimeMs[pumpIndex];
+    } else {
+        return 0;
+    }
+}
 
-    for (int i = 0; i < 3; i++) {
-        if (runtimes[i] != 0 && runtimes[i] != -1) {
-            savedRuntime[i] = runtimes[i];
+void PumpMaster::accumulateRuntime() {
+    unsigned long currentTime = millis();
+    unsigned long elapsed = currentTime - lastAccountingTime;
+    lastAccountingTime = currentTime;
+
+    bool changed = false;
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        if (pumpStatus[i]) {
+            runtimeMs[i] += elapsed;
+            changed = true;
         }
+    }
+    if (changed) {
+        runtimeDirty = true;
+        sortRuntimeOrder();
+    }
+}
 
-        sendRuntimeToMQTT(i, savedRuntime[i]);
+// Insertion sort: de volgorde is vrijwel altijd al goed, dus dit kost een enkele vergelijking per pomp.
+// Bij gelijke draaitijd blijft het laagste pompnummer vooraan.
+void PumpMaster::sortRuntimeOrder() {
+    for (int i = 1; i < PUMP_COUNT; i++) {
+        uint8_t pump = runtimeOrder[i];
+        int j = i - 1;
+        while (j >= 0 && (runtimeMs[runtimeOrder[j]] > runtimeMs[pump] ||
+                          (runtimeMs[runtimeOrder[j]] == runtimeMs[pump] && runtimeOrder[j] > pump))) {
+            runtimeOrder[j + 1] = runtimeOrder[j];
+            j--;
+        }
+        runtimeOrder[j + 1] = pump;
     }
 }
 
+void PumpMaster::saveRuntime() {
+    if (!runtimeDirty) return;
+    runtimeStore.save(runtimeMs, PUMP_COUNT);
+    runtimeDirty = false;
+    lastRuntimeSave = millis();
+}
+
 // Constructor
 PumpMaster::PumpMaster() {
-    for (int i = 0; i < 3; i++) {
+    for (int i = 0; i < PUMP_COUNT; i++) {
         pumpStatus[i] = false;
         lastOnTime[i] = 0;
         lastOffTime[i] = 0;
+        runtimeMs[i] = 0;
+        runtimeOrder[i] = i;
+        runtimeSeeded[i] = false;
     }
     currentBufferTemp = 0.0;
     targetBufferTemp = 0.0;
     lastPumpChangeTime = 0;
-    lastRuntimeUpdate = millis();
-    updateRuntimeFromMQTT(); // Directe initiële update
+    lastTempCheckTime = 0;
+    lastMeasuredTemp = 0.0;
+    bufferSlope = 0.0;
+    slopeValid = false;
+    expectedLoad = 0.0;
+    memset(&staging, 0, sizeof(staging));
+    startsInWindow = 0;
+    startsWindowBegin = 0;
+    recoveryStart = 0;
+    lastAccountingTime = 0;
+    lastRuntimeSave = 0;
+    runtimeDirty = false;
+}
+
+void PumpMaster::begin() {
+    runtimeStore.begin();
+    if (runtimeStore.load(runtimeMs, PUMP_COUNT)) {
+        for (int i = 0; i < PUMP_COUNT; i++) runtimeSeeded[i] = true;
+        sortRuntimeOrder();
+        logPrintf(LOG_INFO, LOG_PUMPS, "Draaitijden geladen uit flash.");
+    }
+
+    unsigned long currentTime = millis();
+    lastAccountingTime = currentTime;
+    lastRuntimeSave = currentTime;
+    startsWindowBegin = currentTime;
+    lastPumpChangeTime = currentTime - STAGE_SETTLE_TIME; // Geen wachttijd voor de helling na het opstarten
+
+    // De relais zijn bij het opstarten net uitgezet, dus elke pomp wacht eerst zijn minimale uittijd af.
+    // Na een korte herstart mag een compressor niet direct weer starten.
+    for (int i = 0; i < PUMP_COUNT; i++) lastOffTime[i] = currentTime;
 }
 
 // Update de buffertemperaturen
@@ -55,9 +138,13 @@ void PumpMaster::update(float currentTemp, float targetTemp, bool heating, float
 
     unsigned long currentTime = millis();
 
-    if (currentTime - lastRuntimeUpdate >= RUNTIME_UPDATE_INTERVAL) {
-        updateRuntimeFromMQTT();
-        lastRuntimeUpdate = currentTime;
+    accumulateRuntime();
+    updateRuntimeFromMQTT();
+    updateSlope(currentTime);
+
+    if (currentTime - lastRuntimeSave >= RUNTIME_SAVE_INTERVAL) {
+        saveRuntime();
+        lastRuntimeSave = currentTime;
     }
 
     regulatePumps(heating, hysteresis);
@@ -65,115 +152,253 @@ void PumpMaster::update(float currentTemp, float targetTemp, bool heating, float
 
 
 void PumpMaster::shutdownAllPumps() {
-    for (int i = 0; i < 3; i++) pumpStatus[i] = false;
+    accumulateRuntime();
+    unsigned long currentTime = millis();
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        if (pumpStatus[i]) lastOffTime[i] = currentTime;
+        pumpStatus[i] = false;
+    }
+    saveRuntime();
 }
 
 void PumpMaster::forcePumpOff(int pumpIndex) {
+    if (pumpIndex < 0 || pumpIndex >= PUMP_COUNT) return;
+    accumulateRuntime();
+    if (pumpStatus[pumpIndex]) lastOffTime[pumpIndex] = millis(); // Ook dan geldt de minimale uittijd
     pumpStatus[pumpIndex] = false;
+    saveRuntime();
     // eventueel logica toevoegen voor handmatige override
 }
 
-// Regeling voor de pompen
-// Update runtimes van MQTT en geef door aan MQTT.cpp
-void PumpMaster::regulatePumps(bool heating, float hysteresis) {
-    unsigned long currentTime = millis();
+int PumpMaster::selectPump(bool switchOn, unsigned long currentTime) {
+    if (switchOn) {
+        for (int i = 0; i < PUMP_COUNT; i++) {
+            uint8_t pump = runtimeOrder[i];
+            if (!pumpStatus[pump] && currentTime - lastOffTime[pump] >= PUMP_MIN_OFF_TIME) return pump;
+        }
+    } else {
+        for (int i = PUMP_COUNT - 1; i >= 0; i--) {
+            uint8_t pump = runtimeOrder[i];
+            if (pumpStatus[pump] && currentTime - lastOnTime[pump] >= PUMP_MIN_ON_TIME) return pump;
+        }
+    }
+    return -1;
+}
 
-    if (currentTime - lastPumpChangeTime < NORMAL_CHANGE_TIME) {
+void PumpMaster::updateSlope(unsigned long currentTime) {
+    if (!slopeValid) {
+        lastMeasuredTemp = currentBufferTemp;
+        lastTempCheckTime = currentTime;
+        slopeValid = true;
         return;
     }
 
-    // Verwarmen of koelen – logica keert om
-    if (heating) {
-        // **Afschakelen bij bereiken doel + hysteresis**
-        if (currentBufferTemp >= targetBufferTemp + hysteresis) {
-            int maxRuntimeIndex = -1;
-            unsigned long maxRuntime = 0;
+    unsigned long elapsed = currentTime - lastTempCheckTime;
+    if (elapsed < SLOPE_INTERVAL) return;
 
-            for (int i = 0; i < 3; i++) {
-                if (pumpStatus[i] && savedRuntime[i] > maxRuntime) {
-                    maxRuntime = savedRuntime[i];
-                    maxRuntimeIndex = i;
-                }
-            }
+    float measured = (currentBufferTemp - lastMeasuredTemp) * 60000.0 / elapsed;
+    bufferSlope += SLOPE_SMOOTHING * (measured - bufferSlope);
+    lastMeasuredTemp = currentBufferTemp;
+    lastTempCheckTime = currentTime;
+}
 
-            if (maxRuntimeIndex != -1) {
-                pumpStatus[maxRuntimeIndex] = false;
-                lastOffTime[maxRuntimeIndex] = currentTime;
-                lastPumpChangeTime = currentTime;
-                debugPrint("Pomp " + String(maxRuntimeIndex + 1) + " uitgeschakeld (verwarmen).");
-            }
-            return;
-        }
+// Binnen de band blijft het aantal gelijk. Daarbuiten komt er per volle hysteresis afwijking een pomp bij of af,
+// gerekend met de afwijking die over STAGE_LOOKAHEAD_MINUTES verwacht wordt. Een vat dat al snel opwarmt
+// krijgt dus geen extra pompen, en de cascade schakelt af voordat het doel wordt voorbijgeschoten.
+int PumpMaster::demandPumps(float shortfall, float gain, float hysteresis, int running) {
+    float projected = shortfall - gain * STAGE_LOOKAHEAD_MINUTES;
+    int demand = running;
+    if (projected >= hysteresis) {
+        demand = running + (int)(projected / hysteresis);
+    } else if (projected <= -hysteresis) {
+        demand = running - (int)(-projected / hysteresis);
+    }
+    return constrain(demand, 0, PUMP_COUNT);
+}
 
-        // **Inschakelen bij onder doel - hysteresis**
-        if (currentBufferTemp <= targetBufferTemp - hysteresis) {
-            int minRuntimeIndex = -1;
-            unsigned long minRuntime = ULONG_MAX;
-
-            for (int i = 0; i < 3; i++) {
-                if (!pumpStatus[i] && savedRuntime[i] < minRuntime &&
-                    currentTime - lastOffTime[i] >= NORMAL_OFF_TIME) {
-                    minRuntime = savedRuntime[i];
-                    minRuntimeIndex = i;
-                }
-            }
+void PumpMaster::countStarts(int started, unsigned long currentTime) {
+    staging.totalStarts += started;
+    startsInWindow += started;
+    unsigned long elapsed = currentTime - startsWindowBegin;
+    if (elapsed >= STARTS_WINDOW) {
+        staging.startsPerHour = startsInWindow * 3600000.0 / elapsed;
+        startsInWindow = 0;
+        startsWindowBegin = currentTime;
+    }
+}
 
-            if (minRuntimeIndex != -1) {
-                pumpStatus[minRuntimeIndex] = true;
-                lastOnTime[minRuntimeIndex] = currentTime;
-                lastPumpChangeTime = currentTime;
-                debugPrint("Pomp " + String(minRuntimeIndex + 1) + " ingeschakeld (verwarmen).");
-            }
-        }
+// Een inhaalslag begint als de afwijking de band verlaat en eindigt als het doel bereikt is
+void PumpMaster::trackRecovery(float shortfall, float hysteresis, unsigned long currentTime) {
+    if (!staging.recovering && shortfall >= hysteresis) {
+        staging.recovering = true;
+        recoveryStart = currentTime;
+    } else if (staging.recovering && shortfall <= 0.0) {
+        staging.recovering = false;
+        staging.recoveries++;
+        staging.lastRecoveryMs = currentTime - recoveryStart;
+        if (staging.lastRecoveryMs > staging.maxRecoveryMs) staging.maxRecoveryMs = staging.lastRecoveryMs;
+        logPrintf(LOG_INFO, LOG_PUMPS, "Doeltemperatuur bereikt na %lu min.", staging.lastRecoveryMs / 60000UL);
+    }
+}
 
-    } else {
-        // Koelen – omgekeerde logica
-        if (currentBufferTemp <= targetBufferTemp - hysteresis) {
-            int maxRuntimeIndex = -1;
-            unsigned long maxRuntime = 0;
-
-            for (int i = 0; i < 3; i++) {
-                if (pumpStatus[i] && savedRuntime[i] > maxRuntime) {
-                    maxRuntime = savedRuntime[i];
-                    maxRuntimeIndex = i;
-                }
-            }
+// De laatste schakelactie was een start als een draaiende pomp toen is aangegaan
+bool PumpMaster::lastChangeWasStart() {
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        if (pumpStatus[i] && lastOnTime[i] == lastPumpChangeTime) return true;
+    }
+    return false;
+}
 
-            if (maxRuntimeIndex != -1) {
-                pumpStatus[maxRuntimeIndex] = false;
-                lastOffTime[maxRuntimeIndex] = currentTime;
-                lastPumpChangeTime = currentTime;
-                debugPrint("Pomp " + String(maxRuntimeIndex + 1) + " uitgeschakeld (koelen).");
-            }
-            return;
-        }
+// Regeling voor de pompen
+void PumpMaster::regulatePumps(bool heating, float hysteresis) {
+    unsigned long currentTime = millis();
 
-        if (currentBufferTemp >= targetBufferTemp + hysteresis) {
-            int minRuntimeIndex = -1;
-            unsigned long minRuntime = ULONG_MAX;
+    // Afwijking en opwarmsnelheid in de richting waarin de pompen werken; bij koelen keert de logica om
+    float shortfall = heating ? targetBufferTemp - currentBufferTemp : currentBufferTemp - targetBufferTemp;
+    float gain = heating ? bufferSlope : -bufferSlope;
+    const char* modeName = heating ? "verwarmen" : "koelen";
 
-            for (int i = 0; i < 3; i++) {
-                if (!pumpStatus[i] && savedRuntime[i] < minRuntime &&
-                    currentTime - lastOffTime[i] >= NORMAL_OFF_TIME) {
-                    minRuntime = savedRuntime[i];
-                    minRuntimeIndex = i;
-                }
-            }
+    trackRecovery(shortfall, hysteresis, currentTime);
 
-            if (minRuntimeIndex != -1) {
-                pumpStatus[minRuntimeIndex] = true;
-                lastOnTime[minRuntimeIndex] = currentTime;
-                lastPumpChangeTime = currentTime;
-                debugPrint("Pomp " + String(minRuntimeIndex + 1) + " ingeschakeld (koelen).");
-            }
-        }
+    int running = 0;
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        if (pumpStatus[i]) running++;
+    }
+    int demand = demandPumps(shortfall, gain, hysteresis, running);
+    if (shortfall > 0.0) {
+        demand = max(demand, min((int)expectedLoad, PUMP_COUNT)); // Niet wachten tot het vat wegzakt
+        // De laatste pomp pas uit bij het doel: de helling valt met de pompen weg, dus de vooruitblik
+        // stopt anders te vroeg en blijft het vat zonder last binnen de band hangen
+        if (running > 0) demand = max(demand, 1);
     }
+    staging.demandPumps = demand;
+
+    // Verder in dezelfde richting pas als de helling het effect van de vorige schakelactie laat zien.
+    // Terug mag direct: dan schiet het vat al door, en de minimale aan- en uittijd beschermen de pomp zelf.
+    if (currentTime - lastPumpChangeTime < STAGE_SETTLE_TIME && (demand > running) == lastChangeWasStart()) {
+        countStarts(0, currentTime);
+        return;
+    }
+
+    // **Afschakelen: langst gedraaide pompen eerst**
+    bool stoppedAny = false;
+    while (running > demand) {
+        int pump = selectPump(false, currentTime);
+        if (pump == -1) break; // Overige pompen staan nog niet lang genoeg aan
+        pumpStatus[pump] = false;
+        lastOffTime[pump] = currentTime;
+        lastPumpChangeTime = currentTime;
+        running--;
+        stoppedAny = true;
+        logPrintf(LOG_INFO, LOG_PUMPS, "Pomp %d uitgeschakeld (%s).", pump + 1, modeName);
+    }
+    if (stoppedAny) saveRuntime(); // Na uitschakelen de opgebouwde draaitijd vastleggen
+
+    // **Bijschakelen: kortst gedraaide pompen eerst, één per STAGE_SETTLE_TIME**
+    demand = min(demand, running + 1);
+    int started = 0;
+    while (running < demand) {
+        int pump = selectPump(true, currentTime);
+        if (pump == -1) break; // Overige pompen staan nog niet lang genoeg uit
+        pumpStatus[pump] = true;
+        lastOnTime[pump] = currentTime;
+        lastPumpChangeTime = currentTime;
+        running++;
+        started++;
+        logPrintf(LOG_INFO, LOG_PUMPS, "Pomp %d ingeschakeld (%s).", pump + 1, modeName);
+    }
+    countStarts(started, currentTime);
+}
+
+void PumpMaster::setExpectedLoad(float pumps) {
+    expectedLoad = pumps > 0.0 ? pumps : 0.0;
+}
+
+StagingMetrics PumpMaster::getStagingMetrics() {
+    StagingMetrics metrics = staging;
+    metrics.bufferSlope = bufferSlope;
+    return metrics;
 }
 
+PumpMasterState PumpMaster::saveState() {
+    PumpMasterState state;
+    memset(&state, 0, sizeof(state));
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        state.runtimeMs[i] = runtimeMs[i];
+        state.lastOnTime[i] = lastOnTime[i];
+        state.lastOffTime[i] = lastOffTime[i];
+        if (pumpStatus[i]) state.pumpStatus |= 1 << i;
+        if (runtimeSeeded[i]) state.runtimeSeeded |= 1 << i;
+    }
+    state.lastPumpChangeTime = lastPumpChangeTime;
+    state.lastTempCheckTime = lastTempCheckTime;
+    state.lastAccountingTime = lastAccountingTime;
+    state.lastRuntimeSave = lastRuntimeSave;
+    state.startsWindowBegin = startsWindowBegin;
+    state.recoveryStart = recoveryStart;
+    state.startsInWindow = startsInWindow;
+    state.currentBufferTemp = currentBufferTemp;
+    state.targetBufferTemp = targetBufferTemp;
+    state.lastMeasuredTemp = lastMeasuredTemp;
+    state.bufferSlope = bufferSlope;
+    state.expectedLoad = expectedLoad;
+    state.startsPerHour = staging.startsPerHour;
+    state.totalStarts = staging.totalStarts;
+    state.recoveries = staging.recoveries;
+    state.lastRecoveryMs = staging.lastRecoveryMs;
+    state.maxRecoveryMs = staging.maxRecoveryMs;
+    state.demandPumps = staging.demandPumps;
+    if (slopeValid) state.flags |= PUMP_STATE_SLOPE_VALID;
+    if (staging.recovering) state.flags |= PUMP_STATE_RECOVERING;
+    if (runtimeDirty) state.flags |= PUMP_STATE_RUNTIME_DIRTY;
+    return state;
+}
+
+void PumpMaster::restoreState(const PumpMasterState& state) {
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        runtimeMs[i] = state.runtimeMs[i];
+        lastOnTime[i] = state.lastOnTime[i];
+        lastOffTime[i] = state.lastOffTime[i];
+        pumpStatus[i] = state.pumpStatus & (1 << i);
+        runtimeSeeded[i] = state.runtimeSeeded & (1 << i);
+        runtimeOrder[i] = i;
+    }
+    sortRuntimeOrder();
+    lastPumpChangeTime = state.lastPumpChangeTime;
+    lastTempCheckTime = state.lastTempCheckTime;
+    lastAccountingTime = state.lastAccountingTime;
+    lastRuntimeSave = state.lastRuntimeSave;
+    startsWindowBegin = state.startsWindowBegin;
+    recoveryStart = state.recoveryStart;
+    startsInWindow = state.startsInWindow;
+    currentBufferTemp = state.currentBufferTemp;
+    targetBufferTemp = state.targetBufferTemp;
+    lastMeasuredTemp = state.lastMeasuredTemp;
+    bufferSlope = state.bufferSlope;
+    expectedLoad = state.expectedLoad;
+    staging.startsPerHour = state.startsPerHour;
+    staging.totalStarts = state.totalStarts;
+    staging.recoveries = state.recoveries;
+    staging.lastRecoveryMs = state.lastRecoveryMs;
+    staging.maxRecoveryMs = state.maxRecoveryMs;
+    staging.demandPumps = state.demandPumps;
+    slopeValid = state.flags & PUMP_STATE_SLOPE_VALID;
+    staging.recovering = state.flags & PUMP_STATE_RECOVERING;
+    runtimeDirty = state.flags & PUMP_STATE_RUNTIME_DIRTY;
+}
+
+// Verkrijg laatste inschakeltijd van een pomp
+unsigned long PumpMaster::getLastOnTime(int pumpIndex) {
+    if (pumpIndex >= 0 && pumpIndex < PUMP_COUNT) {
+        return lastOnTime[pumpIndex];
+    } else {
+        return 0;
+    }
+}
 
 // Verkrijg laatste uitschakeltijd van een pomp
 unsigned long PumpMaster::getLastOffTime(int pumpIndex) {
-    if (pumpIndex >= 0 && pumpIndex < 3) {
+    if (pumpIndex >= 0 && pumpIndex < PUMP_COUNT) {
         return lastOffTime[pumpIndex];
     } else {
         return 0;
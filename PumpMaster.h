@@ -4,22 +4,73 @@
 #include "Debug.h"
 #include <Arduino.h>
 #include <ArduinoJson.h> // Toevoegen voor JSON-functionaliteit
+#include "PumpConfig.h"
+#include "ControllerState.h"
+#include "RuntimeStore.h"
+
+// Doeltemperatuur van het buffervat bij verwarmen volgens de stooklijn
+float heatingCurveTarget(float outdoorTemperature);
+
+// Aantal pompen dat de warmtevraag van het huis bij deze buitentemperatuur verwacht (kan een breuk zijn)
+float expectedLoadPumps(float outdoorTemperature);
+
+// Volledige toestand van PumpMaster met vaste breedtes, voor de keyframes van Trace.cpp.
+// De volgorde op draaitijd zit er niet in; die volgt uit de draaitijden.
+struct __attribute__((packed)) PumpMasterState {
+    uint64_t runtimeMs[PUMP_COUNT];
+    uint32_t lastOnTime[PUMP_COUNT];
+    uint32_t lastOffTime[PUMP_COUNT];
+    uint32_t lastPumpChangeTime;
+    uint32_t lastTempCheckTime;
+    uint32_t lastAccountingTime;
+    uint32_t lastRuntimeSave;
+    uint32_t startsWindowBegin;
+    uint32_t recoveryStart;
+    uint32_t startsInWindow;
+    float currentBufferTemp;
+    float targetBufferTemp;
+    float lastMeasuredTemp;
+    float bufferSlope;
+    float expectedLoad;
+    float startsPerHour;
+    uint32_t totalStarts;
+    uint32_t recoveries;
+    uint32_t lastRecoveryMs;
+    uint32_t maxRecoveryMs;
+    uint16_t pumpStatus;     // Bit per pomp
+    uint16_t runtimeSeeded;  // Bit per pomp
+    uint8_t demandPumps;
+    uint8_t flags;           // PUMP_STATE_*
+};
+
+const uint8_t PUMP_STATE_SLOPE_VALID = 0x01;
+const uint8_t PUMP_STATE_RECOVERING = 0x02;
+const uint8_t PUMP_STATE_RUNTIME_DIRTY = 0x04;
 
 class PumpMaster {
 public:
     // Constructor
     PumpMaster();
 
+    // Opgeslagen draaitijden inlezen; aanroepen vanuit setup(), niet vanuit een globale constructor
+    void begin();
+
     // Update functie om huidige en doeltemperaturen door te geven
     void update(float currentTemp, float targetTemp, bool heating, float hysteresis);
-    
+
 
     // Regeling voor de pompen
     void regulatePumps(bool heating, float hysteresis);
 
-    // Update runtimes van MQTT en geef door aan MQTT.cpp
+    // Voorsturing: zolang het vat onder het doel zit draaien er minstens zoveel (volle) pompen. 0 = uit.
+    void setExpectedLoad(float pumps);
+
+    // Eenmalige startwaarde uit MQTT overnemen
     void updateRuntimeFromMQTT();
 
+    // Opgebouwde draaitijd van een pomp in milliseconden
+    uint64_t getRuntime(int pumpIndex);
+
     // Status van een specifieke pomp ophalen
     bool getPumpStatus(int pumpIndex);
 
@@ -35,26 +86,76 @@ public:
     // Alle pompen uitschakelen
     void shutdownAllPumps();
 
+    // Kengetallen van de cascade: gewenst aantal pompen, helling, starts per uur en inhaalduur
+    StagingMetrics getStagingMetrics();
+
+    // Toestand vastleggen en terugzetten, voor de trace en het naspelen op de host; schrijft niets naar flash
+    PumpMasterState saveState();
+    void restoreState(const PumpMasterState& state);
+
 private:
     // Buffertemperaturen
     float currentBufferTemp;
     float targetBufferTemp;
 
     // Pompstatus
-    bool pumpStatus[3];
+    bool pumpStatus[PUMP_COUNT];
 
     // Tijdregistratie
-    unsigned long lastOnTime[3];
-    unsigned long lastOffTime[3];
+    unsigned long lastOnTime[PUMP_COUNT];
+    unsigned long lastOffTime[PUMP_COUNT];
     unsigned long lastPumpChangeTime;
     unsigned long lastTempCheckTime;
 
-    // Laatst gemeten temperatuur
+    // Laatst gemeten temperatuur en de afgeleide helling (°C per minuut)
     float lastMeasuredTemp;
+    float bufferSlope;
+    bool slopeValid;
+
+    // Verwachte last in pompen, van de buitentemperatuur
+    float expectedLoad;
+
+    // Helling van de buffertemperatuur bijwerken, eens per SLOPE_INTERVAL
+    void updateSlope(unsigned long currentTime);
+
+    // Aantal pompen dat nu zou moeten draaien, uit de afwijking en de verwachte afwijking na STAGE_LOOKAHEAD_MINUTES
+    int demandPumps(float shortfall, float gain, float hysteresis, int running);
+
+    // Richting van de laatste schakelactie, uit de schakeltijden
+    bool lastChangeWasStart();
+
+    // Starts per uur en inhaalslagen bijhouden
+    void countStarts(int started, unsigned long currentTime);
+    void trackRecovery(float shortfall, float hysteresis, unsigned long currentTime);
+    StagingMetrics staging;
+    uint32_t startsInWindow;
+    unsigned long startsWindowBegin;
+    unsigned long recoveryStart;
+
+    // Draaitijd optellen voor de pompen die aan staan
+    void accumulateRuntime();
+
+    // Draaitijden naar flash schrijven als er iets veranderd is
+    void saveRuntime();
+
+    // Pompnummers op volgorde van draaitijd, kortste eerst. Alleen draaiende pompen lopen op,
+    // dus na elke optelling schuiven die hooguit een paar plaatsen door.
+    void sortRuntimeOrder();
+
+    // Bij inschakelen de pomp met de kortste draaitijd die lang genoeg uit staat,
+    // bij uitschakelen de pomp met de langste draaitijd die lang genoeg aan staat. -1 als er geen is.
+    int selectPump(bool switchOn, unsigned long currentTime);
+
+    // Opgebouwde draaitijden (ms) en bijbehorende tijdstippen
+    uint64_t runtimeMs[PUMP_COUNT];
+    uint8_t runtimeOrder[PUMP_COUNT];
+    unsigned long lastAccountingTime;
+    unsigned long lastRuntimeSave;
+    bool runtimeDirty;
 
-    // Laatst bekende runtimes en update tijdstip
-    unsigned long savedRuntime[3];
-    unsigned long lastRuntimeUpdate;
+    // Opslag in flash; geopend in begin()
+    RuntimeStore runtimeStore;
+    bool runtimeSeeded[PUMP_COUNT];
 };
 
 #endif // PUMPMASTER_H
@@ -0,0 +1,92 @@
+#include "RuntimeStore.h"
+#include <EEPROM.h>
+#include "Debug.h"
+
+RuntimeStore::RuntimeStore() {
+    started = false;
+    newestSlot = -1;
+    sequence = 0;
+    saveCount = 0;
+}
+
+// CRC32 over alles behalve het checksumveld zelf
+uint32_t RuntimeStore::checksum(const Record& record) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(&record);
+    size_t length = offsetof(Record, checksum);
+
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+bool RuntimeStore::readSlot(int slot, Record& record) {
+    EEPROM.get(slot * sizeof(Record), record);
+    return record.checksum == checksum(record);
+}
+
+void RuntimeStore::begin() {
+    if (started) return;
+
+    if (!EEPROM.begin(SLOT_COUNT * sizeof(Record))) {
+        logPrintf(LOG_ERROR, LOG_PUMPS, "EEPROM openen mislukt, draaitijden worden niet bewaard.");
+        return;
+    }
+    started = true;
+
+    // Het slot met het hoogste volgnummer is het nieuwste
+    for (int slot = 0; slot < SLOT_COUNT; slot++) {
+        Record record;
+        if (readSlot(slot, record) && (newestSlot == -1 || (int32_t)(record.sequence - sequence) > 0)) {
+            newestSlot = slot;
+            sequence = record.sequence;
+        }
+    }
+
+    if (newestSlot == -1) {
+        logPrintf(LOG_INFO, LOG_PUMPS, "Geen opgeslagen draaitijden gevonden.");
+    }
+}
+
+bool RuntimeStore::load(uint64_t* runtimesMs, int count) {
+    if (!started || newestSlot == -1) return false;
+
+    Record record;
+    if (!readSlot(newestSlot, record)) return false;
+
+    for (int i = 0; i < count && i < MAX_PUMPS; i++) {
+        runtimesMs[i] = record.runtimeMs[i];
+    }
+    return true;
+}
+
+void RuntimeStore::save(const uint64_t* runtimesMs, int count) {
+    if (!started) return;
+
+    Record record;
+    memset(&record, 0, sizeof(record));
+    record.sequence = sequence + 1;
+    for (int i = 0; i < count && i < MAX_PUMPS; i++) {
+        record.runtimeMs[i] = runtimesMs[i];
+    }
+    record.checksum = checksum(record);
+
+    int slot = (newestSlot + 1) % SLOT_COUNT;
+    EEPROM.put(slot * sizeof(Record), record);
+    if (!EEPROM.commit()) {
+        logPrintf(LOG_ERROR, LOG_PUMPS, "Draaitijden opslaan mislukt.");
+        return;
+    }
+
+    newestSlot = slot;
+    sequence = record.sequence;
+    saveCount++;
+}
+
+uint32_t RuntimeStore::getSaveCount() const {
+    return saveCount;
+}
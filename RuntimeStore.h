@@ -0,0 +1,43 @@
+#ifndef RUNTIMESTORE_H
+#define RUNTIMESTORE_H
+
+#include <Arduino.h>
+#include "PumpConfig.h"
+
+// Draaitijden van de pompen in flash, verdeeld over een ring van slots.
+// Elke opslag schrijft naar het volgende slot, zodat de slijtage over alle slots wordt verdeeld.
+class RuntimeStore {
+public:
+    static const int MAX_PUMPS = PUMP_COUNT;
+    static const int SLOT_COUNT = 16;
+
+    RuntimeStore();
+
+    // EEPROM openen en het nieuwste geldige slot zoeken
+    void begin();
+
+    // Laatst opgeslagen draaitijden in ms. Geeft false als er nog niets is opgeslagen.
+    bool load(uint64_t* runtimesMs, int count);
+
+    // Draaitijden in het volgende slot wegschrijven
+    void save(const uint64_t* runtimesMs, int count);
+
+    uint32_t getSaveCount() const;
+
+private:
+    struct Record {
+        uint32_t sequence;
+        uint64_t runtimeMs[MAX_PUMPS];
+        uint32_t checksum;
+    };
+
+    static uint32_t checksum(const Record& record);
+    bool readSlot(int slot, Record& record);
+
+    bool started;
+    int newestSlot;        // -1 = geen geldig slot gevonden
+    uint32_t sequence;
+    uint32_t saveCount;
+};
+
+#endif // RUNTIMESTORE_H
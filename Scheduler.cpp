@@ -0,0 +1,113 @@
+#include "Scheduler.h"
+#include "esp_timer.h"
+#include "Supervisor.h"
+
+// esp_timer telt in microseconden op 64 bit en loopt dus nooit over
+uint64_t millis64() {
+    return (uint64_t)esp_timer_get_time() / 1000ULL;
+}
+
+Scheduler::Scheduler() {
+    count = 0;
+}
+
+int Scheduler::addTask(const char* name, uint32_t periodMs, TaskFunction function, uint32_t offsetMs, uint32_t budgetMs) {
+    if (count >= MAX_TASKS || function == nullptr || periodMs == 0) {
+        return -1;
+    }
+
+    ScheduledTask& task = tasks[count];
+    task.name = name;
+    task.function = function;
+    task.periodMs = periodMs;
+    task.nextRunMs = millis64() + offsetMs;
+    task.runs = 0;
+    task.overruns = 0;
+    task.lastDurationMs = 0;
+    task.maxDurationMs = 0;
+    task.lastLatenessUs = 0;
+    task.maxLatenessUs = 0;
+    task.stage = superviseStage(name, budgetMs > 0 ? budgetMs : periodMs);
+    return count++;
+}
+
+// Zoek de taak met de vroegste verstreken deadline
+int Scheduler::nextDueTask(uint64_t now) {
+    int due = -1;
+    for (int i = 0; i < count; i++) {
+        if (tasks[i].nextRunMs <= now && (due == -1 || tasks[i].nextRunMs < tasks[due].nextRunMs)) {
+            due = i;
+        }
+    }
+    return due;
+}
+
+void Scheduler::runTask(ScheduledTask& task, uint64_t now) {
+    // Een hele periode te laat gestart telt als overrun
+    bool late = now - task.nextRunMs >= task.periodMs;
+
+    // Vertraging ten opzichte van de deadline in microseconden
+    int64_t lateness = esp_timer_get_time() - (int64_t)task.nextRunMs * 1000;
+    task.lastLatenessUs = lateness > 0 ? (uint32_t)lateness : 0;
+    if (task.lastLatenessUs > task.maxLatenessUs) {
+        task.maxLatenessUs = task.lastLatenessUs;
+    }
+
+    stageEnter(task.stage);
+    task.function();
+    stageExit(task.stage);
+
+    uint64_t end = millis64();
+    task.lastDurationMs = (uint32_t)(end - now);
+    if (task.lastDurationMs > task.maxDurationMs) {
+        task.maxDurationMs = task.lastDurationMs;
+    }
+    task.runs++;
+
+    if (late || task.lastDurationMs > task.periodMs) {
+        task.overruns++;
+    }
+
+    // Volgende deadline op het vaste raster; gemiste slots niet inhalen
+    task.nextRunMs += task.periodMs;
+    if (task.nextRunMs <= end) {
+        task.nextRunMs = end + task.periodMs;
+    }
+}
+
+void Scheduler::run() {
+    // Eerst al het werk dat klaarstaat afhandelen
+    int due;
+    while ((due = nextDueTask(millis64())) != -1) {
+        runTask(tasks[due], millis64());
+    }
+
+    // Pas slapen als er niets meer te doen is
+    uint32_t wait = msUntilNextTask();
+    if (wait > 0) {
+        delay(wait);
+    }
+}
+
+uint32_t Scheduler::msUntilNextTask() {
+    if (count == 0) return 0;
+
+    uint64_t now = millis64();
+    uint64_t next = tasks[0].nextRunMs;
+    for (int i = 1; i < count; i++) {
+        if (tasks[i].nextRunMs < next) next = tasks[i].nextRunMs;
+    }
+    return next > now ? (uint32_t)(next - now) : 0;
+}
+
+int Scheduler::taskCount() const {
+    return count;
+}
+
+const ScheduledTask* Scheduler::getTask(int index) const {
+    if (index >= 0 && index < count) {
+        return &tasks[index];
+    } else {
+        return nullptr;
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+// Functie die door de scheduler periodiek wordt aangeroepen
+typedef void (*TaskFunction)();
+
+// Administratie per periodieke taak
+struct ScheduledTask {
+    const char* name;          // Naam voor debug en diagnose
+    TaskFunction function;     // Uit te voeren functie
+    uint32_t periodMs;         // Gewenste periode
+    uint64_t nextRunMs;        // Volgende deadline op de 64-bit klok
+    uint32_t runs;             // Aantal keer uitgevoerd
+    uint32_t overruns;         // Aantal keer te laat gestart of langer bezig dan de periode
+    uint32_t lastDurationMs;   // Duur van de laatste uitvoering
+    uint32_t maxDurationMs;    // Langste uitvoering sinds de start
+    uint32_t lastLatenessUs;   // Start na de deadline bij de laatste uitvoering (jitter)
+    uint32_t maxLatenessUs;    // Grootste vertraging sinds de start
+    int8_t stage;              // Nummer bij Supervisor; -1 zonder toezicht
+};
+
+// 64-bit milliseconde klok, loopt niet over zoals millis() na 49 dagen
+uint64_t millis64();
+
+class Scheduler {
+public:
+    static const int MAX_TASKS = 12;
+
+    Scheduler();
+
+    // Taak toevoegen. De eerste uitvoering volgt na offsetMs. Geeft de index terug of -1 als de tabel vol is.
+    // De taak komt onder toezicht van Supervisor met budgetMs als deadline; 0 = de periode.
+    int addTask(const char* name, uint32_t periodMs, TaskFunction function, uint32_t offsetMs = 0, uint32_t budgetMs = 0);
+
+    // Voert alle taken uit waarvan de deadline verstreken is (vroegste deadline eerst)
+    // en slaapt daarna hooguit tot de volgende deadline.
+    void run();
+
+    // Tijd tot de eerstvolgende deadline
+    uint32_t msUntilNextTask();
+
+    // Uitlezen van de taakadministratie
+    int taskCount() const;
+    const ScheduledTask* getTask(int index) const;
+
+private:
+    int nextDueTask(uint64_t now);
+    void runTask(ScheduledTask& task, uint64_t now);
+
+    ScheduledTask tasks[MAX_TASKS];
+    int count;
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,101 @@
+#include "Sensors.h"
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include "Scheduler.h"
+#include "Debug.h"
+
+// Tijd tussen het starten van twee conversies
+const unsigned long SENSOR_INTERVAL = 1000;
+const uint8_t SENSOR_RESOLUTION = 12;
+
+OneWire oneWire;
+DallasTemperature sensors(&oneWire);
+
+static SensorSnapshot snapshot = {0.0, 0.0, false, false, 0, 0};
+
+static uint8_t bufferSensorIndex = 0;
+static uint8_t outdoorSensorIndex = 1;
+static DeviceAddress bufferAddress;
+static DeviceAddress outdoorAddress;
+static bool bufferAddressKnown = false;
+static bool outdoorAddressKnown = false;
+
+static bool conversionPending = false;
+static unsigned long conversionStartTime = 0;
+static unsigned long conversionDuration = 750;
+
+// Adressen eenmalig opzoeken, zodat uitlezen niet telkens de hele bus afzoekt
+static void lookupAddresses() {
+    if (!bufferAddressKnown) {
+        bufferAddressKnown = sensors.getAddress(bufferAddress, bufferSensorIndex);
+    }
+    if (!outdoorAddressKnown) {
+        outdoorAddressKnown = sensors.getAddress(outdoorAddress, outdoorSensorIndex);
+    }
+}
+
+static bool readSensor(bool known, const uint8_t* address, float& value) {
+    if (!known) return false;
+
+    float temp = sensors.getTempC(address);
+    if (temp == DEVICE_DISCONNECTED_C || temp < -55.0 || temp > 125.0) {
+        return false;
+    }
+    value = temp;
+    return true;
+}
+
+void setupSensors(uint8_t pin, uint8_t bufferIndex, uint8_t outdoorIndex) {
+    bufferSensorIndex = bufferIndex;
+    outdoorSensorIndex = outdoorIndex;
+
+    oneWire.begin(pin);
+    sensors.begin();
+    sensors.setResolution(SENSOR_RESOLUTION);
+    sensors.setWaitForConversion(false); // requestTemperatures() keert direct terug
+    conversionDuration = sensors.millisToWaitForConversion(SENSOR_RESOLUTION);
+
+    lookupAddresses();
+    logPrintf(LOG_INFO, LOG_SENSORS, "Sensoren gevonden: %d", sensors.getDeviceCount());
+}
+
+void loopSensors() {
+    unsigned long now = millis();
+
+    if (!conversionPending) {
+        if (snapshot.sequence != 0 && now - conversionStartTime < SENSOR_INTERVAL) {
+            return;
+        }
+        lookupAddresses();
+        sensors.requestTemperatures();
+        conversionStartTime = now;
+        conversionPending = true;
+        return;
+    }
+
+    // Wachten tot de conversie klaar is, zonder de bus te blokkeren
+    if (now - conversionStartTime < conversionDuration && !sensors.isConversionComplete()) {
+        return;
+    }
+    conversionPending = false;
+
+    SensorSnapshot next = snapshot;
+    next.bufferValid = readSensor(bufferAddressKnown, bufferAddress, next.bufferTemperature);
+    next.outdoorValid = readSensor(outdoorAddressKnown, outdoorAddress, next.outdoorTemperature);
+    next.timestampMs = millis64();
+    next.sequence = snapshot.sequence + 1;
+
+    // Bij een losgeraakte sensor opnieuw zoeken bij de volgende conversie
+    if (!next.bufferValid) bufferAddressKnown = false;
+    if (!next.outdoorValid) outdoorAddressKnown = false;
+
+    snapshot = next;
+}
+
+const SensorSnapshot& getSensorSnapshot() {
+    return snapshot;
+}
+
+bool bufferTemperatureFresh(uint32_t maxAgeMs) {
+    return snapshot.bufferValid && millis64() - snapshot.timestampMs <= maxAgeMs;
+}
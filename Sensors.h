@@ -0,0 +1,28 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <Arduino.h>
+
+// Laatste complete meting van de DS18B20-sensoren
+struct SensorSnapshot {
+    float bufferTemperature;   // Buffervat in °C
+    float outdoorTemperature;  // Buitenvoeler in °C
+    bool bufferValid;          // Buffersensor gaf een bruikbare waarde
+    bool outdoorValid;         // Buitensensor gaf een bruikbare waarde
+    uint64_t timestampMs;      // millis64() van de meting, 0 = nog geen meting
+    uint32_t sequence;         // Telt op bij elke nieuwe meting
+};
+
+// Bus starten en sensoradressen opzoeken
+void setupSensors(uint8_t pin, uint8_t bufferIndex, uint8_t outdoorIndex);
+
+// Start een conversie of haalt het resultaat op als die klaar is. Blokkeert nooit.
+void loopSensors();
+
+// Gedeelde meting voor regeling, portal en MQTT
+const SensorSnapshot& getSensorSnapshot();
+
+// Buffertemperatuur geldig en niet ouder dan maxAgeMs
+bool bufferTemperatureFresh(uint32_t maxAgeMs);
+
+#endif // SENSORS_H
@@ -0,0 +1,119 @@
+#include "Spool.h"
+#include <LittleFS.h>
+#include <time.h>
+#include "Debug.h"
+
+static const char* SPOOL_FILE = "/spool.bin";
+static const char* SPOOL_OFFSET_FILE = "/spool.pos"; // Leespositie, zodat een herstart niets dubbel verstuurt
+const size_t SPOOL_MAX_BYTES = 64 * 1024; // Ruim een dag aan wijzigingen
+
+static bool spoolReady = false;
+static size_t spoolSize = 0;        // Bytes in het bestand
+static size_t spoolReadOffset = 0;  // Bytes die al afgespeeld zijn
+static size_t savedReadOffset = 0;  // Zoals in SPOOL_OFFSET_FILE
+static SpoolStats spoolStats = {0, 0, 0, 0};
+
+void setupSpool() {
+    if (!LittleFS.begin(true)) {
+        logPrintf(LOG_ERROR, LOG_SYSTEM, "LittleFS starten mislukt, berichten worden niet bewaard tijdens storingen.");
+        return;
+    }
+    spoolReady = true;
+    spoolSize = 0;
+    spoolReadOffset = 0;
+    savedReadOffset = 0;
+
+    // Records van voor de herstart alsnog afspelen
+    File file = LittleFS.open(SPOOL_FILE, "r");
+    if (file) {
+        spoolSize = file.size() - file.size() % sizeof(SpoolRecord);
+        file.close();
+    }
+
+    // Wat voor de herstart al verstuurd was overslaan
+    File position = LittleFS.open(SPOOL_OFFSET_FILE, "r");
+    if (position) {
+        uint32_t offset = 0;
+        if (position.read(reinterpret_cast<uint8_t*>(&offset), sizeof(offset)) == sizeof(offset) &&
+            offset <= spoolSize && offset % sizeof(SpoolRecord) == 0) {
+            spoolReadOffset = offset;
+            savedReadOffset = offset;
+        }
+        position.close();
+    }
+    if (spoolSize > spoolReadOffset) {
+        logPrintf(LOG_INFO, LOG_MQTT, "Spool bevat %u records van voor de herstart",
+                  (unsigned)((spoolSize - spoolReadOffset) / sizeof(SpoolRecord)));
+    }
+}
+
+void spoolAppend(uint8_t type, uint8_t index, int16_t value) {
+    if (!spoolReady || spoolSize + sizeof(SpoolRecord) > SPOOL_MAX_BYTES) {
+        spoolStats.dropped++;
+        return;
+    }
+
+    time_t now = time(nullptr);
+    SpoolRecord record;
+    record.timestamp = now > 1600000000 ? (uint32_t)now : 0;
+    record.type = type;
+    record.index = index;
+    record.value = value;
+
+    File file = LittleFS.open(SPOOL_FILE, "a");
+    if (!file || file.write(reinterpret_cast<const uint8_t*>(&record), sizeof(record)) != sizeof(record)) {
+        spoolStats.dropped++;
+        if (file) file.close();
+        return;
+    }
+    file.close();
+
+    spoolSize += sizeof(record);
+    spoolStats.written++;
+}
+
+bool spoolPeek(SpoolRecord& record) {
+    if (!spoolReady || spoolReadOffset >= spoolSize) return false;
+
+    File file = LittleFS.open(SPOOL_FILE, "r");
+    if (!file) return false;
+
+    bool ok = file.seek(spoolReadOffset) &&
+              file.read(reinterpret_cast<uint8_t*>(&record), sizeof(record)) == sizeof(record);
+    file.close();
+    return ok;
+}
+
+void spoolAdvance() {
+    if (spoolReadOffset >= spoolSize) return;
+
+    spoolReadOffset += sizeof(SpoolRecord);
+    spoolStats.replayed++;
+
+    // Alles verstuurd: bestand weg, zodat het niet blijft groeien
+    if (spoolReadOffset >= spoolSize) {
+        LittleFS.remove(SPOOL_FILE);
+        LittleFS.remove(SPOOL_OFFSET_FILE);
+        spoolSize = 0;
+        spoolReadOffset = 0;
+        savedReadOffset = 0;
+    }
+}
+
+void spoolSaveReadOffset() {
+    if (!spoolReady || spoolReadOffset == savedReadOffset) return;
+
+    File position = LittleFS.open(SPOOL_OFFSET_FILE, "w");
+    if (!position) return;
+    uint32_t offset = spoolReadOffset;
+    if (position.write(reinterpret_cast<const uint8_t*>(&offset), sizeof(offset)) == sizeof(offset)) {
+        savedReadOffset = spoolReadOffset;
+    }
+    position.close();
+}
+
+SpoolStats getSpoolStats() {
+    SpoolStats stats = spoolStats;
+    stats.depth = (spoolSize - spoolReadOffset) / sizeof(SpoolRecord);
+    return stats;
+}
@@ -0,0 +1,45 @@
+#ifndef SPOOL_H
+#define SPOOL_H
+
+#include <Arduino.h>
+
+// Soorten records in de spool
+enum SpoolRecordType : uint8_t {
+    SPOOL_BUFFER_TEMPERATURE = 1,  // value = temperatuur * 100
+    SPOOL_RELAY = 2,               // index = relais, value = 0/1
+    SPOOL_WARNING = 3              // value = WarningCode
+};
+
+// Compact record zoals het op flash staat (8 bytes)
+struct __attribute__((packed)) SpoolRecord {
+    uint32_t timestamp;  // Unix-tijd in seconden, 0 als de klok nog niet gesynchroniseerd was
+    uint8_t type;        // SpoolRecordType
+    uint8_t index;
+    int16_t value;
+};
+
+struct SpoolStats {
+    uint32_t depth;      // Nog af te spelen records
+    uint32_t written;    // Totaal weggeschreven sinds de start
+    uint32_t replayed;   // Totaal afgespeeld sinds de start
+    uint32_t dropped;    // Niet opgeslagen omdat de spool vol was of flash faalde
+};
+
+// LittleFS openen en een eventueel achtergebleven spool overnemen
+void setupSpool();
+
+// Record achteraan toevoegen; bij een volle spool wordt het record geteld als dropped
+void spoolAppend(uint8_t type, uint8_t index, int16_t value);
+
+// Oudste nog niet afgespeelde record lezen zonder het te verwijderen
+bool spoolPeek(SpoolRecord& record);
+
+// Oudste record als afgespeeld markeren; de spool wordt geleegd als alles verstuurd is
+void spoolAdvance();
+
+// Leespositie op flash zetten; na elk afgespeeld blok, zodat een herstart alleen dat blok herhaalt
+void spoolSaveReadOffset();
+
+SpoolStats getSpoolStats();
+
+#endif // SPOOL_H
@@ -0,0 +1,188 @@
+#include "Supervisor.h"
+#include <esp_attr.h>
+#include <esp_task_wdt.h>
+#include "Debug.h"
+
+const uint32_t SUPERVISOR_MAGIC = 0x53555056; // "SUPV"
+
+// Blijft staan bij een herstart door software, watchdog of crash; na inschakelen staat er willekeur in
+RTC_NOINIT_ATTR static SupervisorReport rtcReport;
+
+static SupervisorReport previousBoot;
+static bool previousValid = false;
+
+// Per stap; geschreven door de taak die de stap uitvoert, gelezen door superviseStages()
+struct StageState {
+    uint32_t budgetMs;
+    volatile uint32_t enteredAt;
+    volatile uint32_t progressAt;  // Binnenkomst of laatste voortgang; daar telt het budget vanaf
+    volatile bool active;
+};
+
+static StageState stages[SUPERVISOR_STAGES];
+static int8_t currentStage[2] = {-1, -1}; // Per core de stap die bezig is
+static uint32_t missesSeen = 0;
+static int8_t reportedHang = -1;
+static SupervisorStats supervisorStats = {0, 0};
+
+void setupSupervisor(uint32_t watchdogTimeoutMs) {
+    previousValid = rtcReport.magic == SUPERVISOR_MAGIC && rtcReport.stageCount <= SUPERVISOR_STAGES &&
+                    rtcReport.hungStage < (int8_t)rtcReport.stageCount;
+    if (previousValid) {
+        previousBoot = rtcReport;
+    }
+
+    memset(&rtcReport, 0, sizeof(rtcReport));
+    rtcReport.magic = SUPERVISOR_MAGIC;
+    rtcReport.hungStage = -1;
+    memset(stages, 0, sizeof(stages));
+    currentStage[0] = currentStage[1] = -1;
+    missesSeen = 0;
+    reportedHang = -1;
+    supervisorStats = {0, 0};
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    esp_task_wdt_config_t config = {watchdogTimeoutMs, 1 << 0, true}; // Idle-taak van core 0 blijft bewaakt, zoals in de kern
+    if (esp_task_wdt_reconfigure(&config) != ESP_OK) {
+        esp_task_wdt_init(&config); // Nog niet gestart door de kern
+    }
+#else
+    esp_task_wdt_init((watchdogTimeoutMs + 999) / 1000, true);
+#endif
+}
+
+int8_t superviseStage(const char* name, uint32_t budgetMs) {
+    if (rtcReport.stageCount >= SUPERVISOR_STAGES) return -1;
+    uint8_t stage = rtcReport.stageCount;
+    strncpy(rtcReport.names[stage], name, SUPERVISOR_NAME_LENGTH - 1);
+    rtcReport.names[stage][SUPERVISOR_NAME_LENGTH - 1] = '\0';
+    stages[stage].budgetMs = budgetMs;
+    rtcReport.stageCount++;
+    return stage;
+}
+
+// Regeltaak en netwerktaak draaien elk op een eigen core, dus elke ring heeft één schrijver
+static void addCrumb(int8_t stage, CrumbEvent event, uint32_t durationMs, uint32_t now) {
+    uint8_t core = xPortGetCoreID() & 1;
+    SupervisorCrumb& crumb = rtcReport.crumbs[core][rtcReport.crumbCount[core] % SUPERVISOR_CRUMBS];
+    crumb.timeMs = now;
+    crumb.stage = stage;
+    crumb.event = event;
+    crumb.durationMs = durationMs < 0xFFFF ? durationMs : 0xFFFF;
+    rtcReport.crumbCount[core]++;
+}
+
+void stageEnter(int8_t stage) {
+    if (stage < 0) return;
+    uint32_t now = millis();
+    stages[stage].enteredAt = now;
+    stages[stage].progressAt = now;
+    stages[stage].active = true;
+    currentStage[xPortGetCoreID() & 1] = stage;
+    addCrumb(stage, CRUMB_ENTER, 0, now);
+}
+
+void stageProgress() {
+    int8_t stage = currentStage[xPortGetCoreID() & 1];
+    if (stage < 0) return;
+    stages[stage].progressAt = millis();
+}
+
+void stageExit(int8_t stage) {
+    if (stage < 0) return;
+    uint32_t now = millis();
+    uint32_t duration = now - stages[stage].enteredAt;
+    stages[stage].active = false;
+    uint8_t core = xPortGetCoreID() & 1;
+    if (currentStage[core] == stage) currentStage[core] = -1;
+    if (duration > stages[stage].budgetMs && rtcReport.misses[stage] < 0xFFFF) {
+        rtcReport.misses[stage]++;
+    }
+    addCrumb(stage, CRUMB_EXIT, duration, now);
+}
+
+void superviseStages() {
+    uint32_t now = millis();
+    rtcReport.uptimeMs = now;
+
+    // Stap die het langst over zijn budget bezig is
+    int8_t hung = -1;
+    uint32_t hungMs = 0;
+    uint32_t misses = 0;
+    for (uint8_t i = 0; i < rtcReport.stageCount; i++) {
+        misses += rtcReport.misses[i];
+        if (!stages[i].active) continue;
+        uint32_t elapsed = now - stages[i].progressAt;
+        if (elapsed > stages[i].budgetMs && elapsed > hungMs) {
+            hung = i;
+            hungMs = elapsed;
+        }
+    }
+    rtcReport.hungStage = hung;
+    rtcReport.hungMs = hungMs;
+
+    if (hung >= 0 && hung != reportedHang) {
+        logPrintf(LOG_WARN, LOG_SYSTEM, "Stap %s al %lu ms bezig (budget %lu ms), watchdog wordt niet gevoed",
+                  rtcReport.names[hung], (unsigned long)hungMs, (unsigned long)stages[hung].budgetMs);
+    }
+    reportedHang = hung;
+
+    // Ook een stap die te laat klaar was slaat één keer voeden over
+    if (hung < 0 && misses == missesSeen) {
+        esp_task_wdt_reset();
+        supervisorStats.feeds++;
+    } else {
+        supervisorStats.withheld++;
+    }
+    missesSeen = misses;
+}
+
+const SupervisorReport* getPreviousBoot() {
+    return previousValid ? &previousBoot : nullptr;
+}
+
+const SupervisorReport& getCurrentBoot() {
+    return rtcReport;
+}
+
+SupervisorStats getSupervisorStats() {
+    return supervisorStats;
+}
+
+void supervisorTrailBegin(const SupervisorReport& report, SupervisorTrailCursor& cursor) {
+    for (int core = 0; core < 2; core++) {
+        uint32_t end = report.crumbCount[core];
+        cursor.next[core] = end > SUPERVISOR_CRUMBS ? end - SUPERVISOR_CRUMBS : 0;
+    }
+}
+
+bool supervisorTrailNext(const SupervisorReport& report, SupervisorTrailCursor& cursor, SupervisorCrumb& crumb) {
+    bool more0 = cursor.next[0] < report.crumbCount[0];
+    bool more1 = cursor.next[1] < report.crumbCount[1];
+    if (!more0 && !more1) return false;
+
+    const SupervisorCrumb& crumb0 = report.crumbs[0][cursor.next[0] % SUPERVISOR_CRUMBS];
+    const SupervisorCrumb& crumb1 = report.crumbs[1][cursor.next[1] % SUPERVISOR_CRUMBS];
+    int core = !more1 || (more0 && crumb0.timeMs <= crumb1.timeMs) ? 0 : 1;
+    crumb = core == 0 ? crumb0 : crumb1;
+    cursor.next[core]++;
+    return true;
+}
+
+uint8_t supervisorTrail(const SupervisorReport& report, SupervisorCrumb* trail, uint8_t maxCount) {
+    SupervisorTrailCursor cursor;
+    supervisorTrailBegin(report, cursor);
+    uint32_t total = (report.crumbCount[0] - cursor.next[0]) + (report.crumbCount[1] - cursor.next[1]);
+    uint32_t skip = total > maxCount ? total - maxCount : 0; // Alleen de nieuwste houden
+
+    uint8_t count = 0;
+    SupervisorCrumb crumb;
+    while (supervisorTrailNext(report, cursor, crumb)) {
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        trail[count++] = crumb;
+    }
+    return count;
+}
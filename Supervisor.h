@@ -0,0 +1,92 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <Arduino.h>
+
+// Bewaking van de stappen van de regeltaak en de netwerktaak. Elke stap heeft een budget; de task
+// watchdog wordt alleen gevoed als geen stap over zijn budget heen is. Binnenkomst en vertrek van de
+// laatste stappen staan in RTC-geheugen dat een herstart overleeft, zodat na een watchdog of crash
+// te zien is welke stap bezig was.
+
+const uint8_t SUPERVISOR_STAGES = 24;  // Taken van beide schedulers plus losse stappen uit setup()
+const uint8_t SUPERVISOR_CRUMBS = 32;  // Laatste gebeurtenissen per core
+const uint8_t SUPERVISOR_NAME_LENGTH = 12;
+
+enum CrumbEvent : uint8_t {
+    CRUMB_ENTER = 1,
+    CRUMB_EXIT = 2
+};
+
+// Eén binnenkomst of vertrek (8 bytes)
+struct SupervisorCrumb {
+    uint32_t timeMs;      // millis()
+    uint8_t stage;
+    uint8_t event;        // CrumbEvent
+    uint16_t durationMs;  // Bij vertrek; afgekapt op 65535
+};
+
+// Alles wat in RTC-geheugen staat; na een herstart de gegevens van de vorige keer
+struct SupervisorReport {
+    uint32_t magic;
+    uint32_t uptimeMs;                    // Bij de laatste controle
+    int8_t hungStage;                     // Stap die over zijn budget bezig was toen het voeden stopte; -1 = geen
+    uint32_t hungMs;                      // Hoe lang die stap toen al bezig was, of sinds zijn laatste voortgang
+    uint8_t stageCount;
+    char names[SUPERVISOR_STAGES][SUPERVISOR_NAME_LENGTH];
+    uint16_t misses[SUPERVISOR_STAGES];   // Keer klaar na het budget
+    uint32_t crumbCount[2];               // Per core geschreven; de ring begint bij crumbCount % SUPERVISOR_CRUMBS
+    SupervisorCrumb crumbs[2][SUPERVISOR_CRUMBS];
+};
+
+struct SupervisorStats {
+    uint32_t feeds;     // Watchdog gevoed
+    uint32_t withheld;  // Controles waarin een stap over zijn budget was
+};
+
+// Gegevens van de vorige keer overnemen, opnieuw beginnen en de task watchdog instellen.
+// Als eerste in setup(), voor alle stappen.
+void setupSupervisor(uint32_t watchdogTimeoutMs);
+
+// Stap onder toezicht brengen; geeft het nummer, of -1 als de tabel vol is
+int8_t superviseStage(const char* name, uint32_t budgetMs);
+
+// Vanuit de taak die de stap uitvoert; elke core heeft een eigen ring, dus zonder lock
+void stageEnter(int8_t stage);
+void stageExit(int8_t stage);
+
+// De stap die op deze core bezig is, maakt voortgang; zijn budget begint opnieuw. Voor stappen die
+// langer mogen duren zolang er iets gebeurt, zoals een upload naar /update of een download van
+// /api/trace. Te laat klaar telt daarna nog steeds als overschrijding.
+void stageProgress();
+
+// Eens per controleperiode vanuit de taak die bij de watchdog is aangemeld; voedt hem als alles op tijd is
+void superviseStages();
+
+// Losse stap, bijvoorbeeld in setup()
+class SupervisedStage {
+public:
+    SupervisedStage(const char* name, uint32_t budgetMs) : stage(superviseStage(name, budgetMs)) { stageEnter(stage); }
+    ~SupervisedStage() { stageExit(stage); }
+
+private:
+    int8_t stage;
+};
+
+// Vorige keer; nullptr na inschakelen of als het RTC-geheugen niet klopt
+const SupervisorReport* getPreviousBoot();
+
+// Deze keer
+const SupervisorReport& getCurrentBoot();
+SupervisorStats getSupervisorStats();
+
+// Gebeurtenissen van beide cores op tijdvolgorde, oudste eerst; geeft het aantal
+uint8_t supervisorTrail(const SupervisorReport& report, SupervisorCrumb* trail, uint8_t maxCount);
+
+// Hetzelfde spoor één gebeurtenis tegelijk, zonder kopie van de ringen
+struct SupervisorTrailCursor {
+    uint32_t next[2]; // Per core de volgende gebeurtenis
+};
+void supervisorTrailBegin(const SupervisorReport& report, SupervisorTrailCursor& cursor);
+bool supervisorTrailNext(const SupervisorReport& report, SupervisorTrailCursor& cursor, SupervisorCrumb& crumb);
+
+#endif // SUPERVISOR_H
@@ -0,0 +1,34 @@
+#include "TcpConnect.h"
+#include <lwip/sockets.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+int tcpConnectStart(uint32_t address, uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sockaddr_in server = {};
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = address;
+    if (connect(fd, (struct sockaddr*)&server, sizeof(server)) != 0 && errno != EINPROGRESS) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Verbonden zodra de socket schrijfbaar is; SO_ERROR zegt of dat ook gelukt is
+TcpConnectStatus tcpConnectPoll(int fd) {
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(fd, &writable);
+    struct timeval noWait = {0, 0};
+    if (select(fd + 1, nullptr, &writable, nullptr, &noWait) <= 0) return TCP_CONNECT_PENDING;
+
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) return TCP_CONNECT_FAILED;
+    return TCP_CONNECT_DONE;
+}
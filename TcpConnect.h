@@ -0,0 +1,21 @@
+#ifndef TCPCONNECT_H
+#define TCPCONNECT_H
+
+#include <stdint.h>
+
+// TCP-verbinding opbouwen zonder te wachten, voor taken die elke tick terugkomen (weer, MQTT).
+// Daarna neemt WiFiClient(fd) de socket over.
+
+enum TcpConnectStatus : int8_t {
+    TCP_CONNECT_FAILED = -1,  // Geweigerd of mislukt; de aanroeper sluit de socket
+    TCP_CONNECT_PENDING = 0,  // Nog bezig
+    TCP_CONNECT_DONE = 1      // Verbonden
+};
+
+// Socket openen en laten verbinden; adres in de volgorde van lwIP en IPAddress. Geeft -1 bij een fout.
+int tcpConnectStart(uint32_t address, uint16_t port);
+
+// Kijkt zonder te wachten of de verbinding er is
+TcpConnectStatus tcpConnectPoll(int fd);
+
+#endif // TCPCONNECT_H
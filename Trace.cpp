@@ -0,0 +1,373 @@
+#include "Trace.h"
+#include <LittleFS.h>
+#include <atomic>
+#include "PumpMaster.h"
+#include "Debug.h"
+
+const uint32_t TRACE_QUEUE_SIZE = 128;  // Macht van 2; ruim een keyframe plus de records van enkele seconden
+const uint32_t TRACE_MAX_REPEAT = 300;  // Langere reeksen afsluiten, zodat een download hooguit zoveel stappen mist
+const uint32_t TRACE_PAGE_RECORDS = 512; // 4 KB in RAM; één schrijfactie per volle pagina spaart de flash
+const uint32_t TRACE_PAGE_MAX_AGE = 10UL * 60UL * 1000UL; // Een halfvolle pagina gaat uiterlijk na 10 minuten naar flash
+const uint32_t KEYFRAME_RECORDS = (sizeof(PumpMasterState) + sizeof(TraceRecord) - 1) / sizeof(TraceRecord);
+const uint32_t SEGMENT_START_RECORDS = 3 + KEYFRAME_RECORDS + 2; // Segment, tijd, keyframe, modus, MQTT
+
+static_assert(KEYFRAME_RECORDS <= 255, "PumpMasterState past niet in een keyframe");
+
+// Wachtrij van de regeltaak (schrijver) naar de netwerktaak (lezer), zoals CommandQueue
+static TraceRecord traceQueue[TRACE_QUEUE_SIZE];
+static std::atomic<uint32_t> traceHead(0);
+static std::atomic<uint32_t> traceTail(0);
+
+// Regeltaak
+static PumpMaster* tracedMaster = nullptr;
+static bool traceReady = false;
+static bool segmentBroken = false;    // Record verloren; pas bij een nieuw segment weer opnemen
+static uint32_t segmentBytes = 0;
+static uint32_t lastRecordTime = 0;
+static uint8_t lastMode = 0xFF;       // Nog niets opgenomen
+static uint8_t lastMqttState = 0xFF;
+static uint32_t lastTargetBits = 0;
+static uint32_t lastBandBits = 0;
+static uint8_t lastBandArg = 0xFF;
+static uint32_t lastLoadBits = 0;    // Zoals in de trace; loadBits kan al verder zijn
+static uint32_t loadBits = 0;        // Laatst aan traceLoad() gegeven, opgenomen bij de volgende stap
+static TraceInputSlots inputSlots;
+static uint16_t tracedSeeds = 0;      // Pompen waarvan de startwaarde al is opgenomen
+static uint16_t lastDecision = 0;
+
+// Lopende reeks stappen, nog niet als record in de wachtrij: gelijke stappen als herhaling, andere compact
+static bool stepOpen = false;         // Laatste record was een stap
+static uint32_t lastStepBits = 0;
+static uint32_t lastStepTime = 0;
+static uint32_t repeatCount = 0;
+static uint32_t repeatInterval = 0;   // Ook voor de compacte stappen
+static uint32_t sampleCount = 0;
+static uint32_t sampleBits = 0;
+
+// Netwerktaak
+static uint32_t flushRaw = 0;         // Ruwe records van een keyframe die nog volgen
+static TraceRecord tracePage[TRACE_PAGE_RECORDS];
+static uint32_t pageCount = 0;
+static uint32_t pageSequence = 0;     // Segment waar de pagina bij hoort
+static bool pageStartsSegment = false; // Pagina begint met de segmentkop: bestand opnieuw beginnen
+static uint32_t pageStarted = 0;      // millis() van het eerste record in de pagina
+
+static TraceStats traceStats = {0, 0, 0, 0, 0, 0, 0};
+
+void traceSegmentPath(uint32_t sequence, char* path, size_t size) {
+    snprintf(path, size, "/trace%u.bin", (unsigned)(sequence % TRACE_SEGMENTS));
+}
+
+static uint32_t queueFree() {
+    return TRACE_QUEUE_SIZE - (traceTail.load(std::memory_order_relaxed) - traceHead.load(std::memory_order_acquire));
+}
+
+static bool push(const TraceRecord& record) {
+    uint32_t tail = traceTail.load(std::memory_order_relaxed);
+    if (tail - traceHead.load(std::memory_order_acquire) >= TRACE_QUEUE_SIZE) {
+        traceStats.dropped++;
+        segmentBroken = true;
+        return false;
+    }
+    traceQueue[tail % TRACE_QUEUE_SIZE] = record;
+    traceTail.store(tail + 1, std::memory_order_release);
+    traceStats.records++;
+    segmentBytes += sizeof(record);
+    return true;
+}
+
+static bool pop(TraceRecord& record) {
+    uint32_t head = traceHead.load(std::memory_order_relaxed);
+    if (head == traceTail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    record = traceQueue[head % TRACE_QUEUE_SIZE];
+    traceHead.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+static bool pushRecord(uint16_t deltaMs, uint8_t type, uint8_t arg, uint32_t value) {
+    TraceRecord record = {deltaMs, type, arg, value};
+    return push(record);
+}
+
+// Herhaalde of compacte stappen als één record; de tijd schuift op naar de laatste stap ervan
+static void pushRun() {
+    if (repeatCount > 0) {
+        pushRecord((uint16_t)repeatInterval, TRACE_REPEAT, 0, repeatCount);
+        repeatCount = 0;
+    } else if (sampleCount > 0) {
+        pushRecord((uint16_t)repeatInterval, TRACE_SAMPLES, sampleCount, sampleBits);
+        sampleCount = 0;
+        sampleBits = 0;
+    } else {
+        return;
+    }
+    lastRecordTime = lastStepTime;
+}
+
+static void closeRun() {
+    pushRun();
+    stepOpen = false;
+}
+
+static bool emit(uint8_t type, uint8_t arg, uint32_t value) {
+    if (segmentBroken) return false;
+    closeRun();
+
+    uint32_t now = (uint32_t)millis();
+    uint32_t delta = now - lastRecordTime;
+    if (delta > 0xFFFF) {
+        pushRecord(0, TRACE_TIME, 0, now);
+        delta = 0;
+    }
+    lastRecordTime = now;
+    return pushRecord((uint16_t)delta, type, arg, value);
+}
+
+// Segmentkop met keyframe; lukt alleen als alles in één keer in de wachtrij past
+static void startSegment(bool boot) {
+    if (queueFree() < SEGMENT_START_RECORDS + 1) return;
+    if (!segmentBroken) closeRun();
+    if (!boot) traceStats.segment++;
+
+    segmentBroken = false;
+    segmentBytes = 0;
+    stepOpen = false;
+    repeatCount = 0;
+    sampleCount = 0;
+    sampleBits = 0;
+    memset(&inputSlots, 0, sizeof(inputSlots));
+
+    uint32_t now = (uint32_t)millis();
+    lastRecordTime = now;
+    pushRecord(0, TRACE_SEGMENT, boot ? TRACE_BOOT : 0, traceStats.segment);
+    pushRecord(0, TRACE_TIME, 0, now);
+
+    PumpMasterState state = tracedMaster->saveState();
+    pushRecord(0, TRACE_KEYFRAME, KEYFRAME_RECORDS, sizeof(state));
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&state);
+    for (uint32_t i = 0; i < KEYFRAME_RECORDS; i++) {
+        TraceRecord raw;
+        memset(&raw, 0, sizeof(raw));
+        size_t offset = i * sizeof(raw);
+        memcpy(&raw, bytes + offset, min(sizeof(raw), sizeof(state) - offset));
+        push(raw);
+    }
+    lastDecision = state.pumpStatus;
+    lastLoadBits = traceFloatBits(state.expectedLoad);
+
+    // Invoer die in het vorige segment staat opnieuw opnemen
+    if (lastMode != 0xFF) pushRecord(0, TRACE_MODE, lastMode, 0);
+    if (lastMqttState != 0xFF) pushRecord(0, TRACE_MQTT, lastMqttState, 0);
+    lastBandArg = 0xFF;
+}
+
+void setupTrace(PumpMaster& master) {
+    tracedMaster = &master;
+    if (!LittleFS.begin(true)) {
+        logPrintf(LOG_ERROR, LOG_SYSTEM, "LittleFS starten mislukt, geen trace.");
+        return;
+    }
+
+    // Verder nummeren na het nieuwste segment
+    bool found = false;
+    uint32_t newest = 0;
+    char path[24];
+    for (uint8_t i = 0; i < TRACE_SEGMENTS; i++) {
+        traceSegmentPath(i, path, sizeof(path));
+        File file = LittleFS.open(path, "r");
+        if (!file) continue;
+        TraceRecord first;
+        if (file.read(reinterpret_cast<uint8_t*>(&first), sizeof(first)) == sizeof(first) && first.type == TRACE_SEGMENT &&
+            (!found || first.value > newest)) {
+            newest = first.value;
+            found = true;
+        }
+        file.close();
+    }
+    traceStats.segment = found ? newest + 1 : 0;
+
+    traceReady = true;
+    startSegment(true);
+}
+
+void traceInputs(HeatPumpMode mode, MqttConnectionState mqttState) {
+    if (!traceReady) return;
+    // Ook bijwerken als het record verloren gaat; een nieuw segment neemt de actuele waarde op
+    if (mode != lastMode) {
+        lastMode = mode;
+        emit(TRACE_MODE, mode, 0);
+    }
+    if (mqttState != lastMqttState) {
+        lastMqttState = mqttState;
+        emit(TRACE_MQTT, mqttState, 0);
+    }
+}
+
+void traceLoad(float pumps) {
+    if (!traceReady) return;
+    loadBits = traceFloatBits(pumps > 0.0 ? pumps : 0.0); // Zoals setExpectedLoad() hem bewaart
+}
+
+// Compacte code voor deze stap, of -1 als hij als volledige TRACE_STEP moet
+static int sampleCode(float currentTemp, uint32_t bits, uint32_t targetBits) {
+    int slot = traceFindInputs(inputSlots, targetBits, loadBits);
+    if (slot < 0) return -1;
+    float previous = traceFloat(lastStepBits);
+    float steps = roundf((currentTemp - previous) / TRACE_SAMPLE_LSB);
+    if (!(fabsf(steps) <= TRACE_SAMPLE_MAX_DELTA)) return -1; // Ook NaN
+    uint32_t sample = (uint32_t)slot << 3 | (uint32_t)((int)steps + TRACE_SAMPLE_MAX_DELTA);
+    if (traceFloatBits(traceSampleTemperature(previous, sample)) != bits) return -1; // Geen hele stap
+    return sample;
+}
+
+void traceStep(float currentTemp, float targetTemp, bool heating, float hysteresis) {
+    if (!traceReady) return;
+
+    // Alleen hier een nieuw segment, zodat een stap en zijn invoer altijd in hetzelfde segment staan
+    if (segmentBroken || segmentBytes >= TRACE_SEGMENT_BYTES) startSegment(false);
+    if (segmentBroken) return;
+
+    // Startwaarden die update() zo meteen overneemt
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        unsigned long seed;
+        if (!(tracedSeeds & (1 << i)) && getRuntimeSeed(i, seed) && emit(TRACE_SEED, i, (uint32_t)seed)) {
+            tracedSeeds |= 1 << i;
+        }
+    }
+
+    uint32_t targetBits = traceFloatBits(targetTemp);
+    uint32_t bandBits = traceFloatBits(hysteresis);
+    uint8_t bandArg = heating ? 1 : 0;
+    bool bandSame = lastBandArg != 0xFF && bandBits == lastBandBits && bandArg == lastBandArg;
+
+    traceStats.steps++;
+    uint32_t now = (uint32_t)millis();
+    uint32_t bits = traceFloatBits(currentTemp);
+    uint32_t interval = now - lastStepTime;
+    if (stepOpen && bandSame && repeatCount == 0 && sampleCount == 0 && interval <= 0xFFFF) repeatInterval = interval;
+    if (stepOpen && bandSame && interval == repeatInterval) {
+        // Gelijke stappen als herhaling, zolang er geen compacte stappen openstaan
+        bool same = bits == lastStepBits && targetBits == lastTargetBits && loadBits == lastLoadBits;
+        if (same && sampleCount == 0 && repeatCount < TRACE_MAX_REPEAT) {
+            repeatCount++;
+            lastStepTime = now;
+            return;
+        }
+        int sample = sampleCode(currentTemp, bits, targetBits);
+        if (sample >= 0) {
+            if (repeatCount > 0) pushRun();
+            sampleBits |= (uint32_t)sample << (sampleCount * TRACE_SAMPLE_BITS);
+            sampleCount++;
+            lastStepBits = bits;
+            lastStepTime = now;
+            lastTargetBits = targetBits;
+            lastLoadBits = loadBits;
+            if (sampleCount == TRACE_SAMPLES_PER_RECORD) pushRun();
+            return;
+        }
+    }
+
+    // Volledige stap met de invoer die veranderd is
+    if (loadBits != lastLoadBits && emit(TRACE_LOAD, 0, loadBits)) lastLoadBits = loadBits;
+    if (lastBandArg == 0xFF || targetBits != lastTargetBits) {
+        if (emit(TRACE_TARGET, 0, targetBits)) lastTargetBits = targetBits;
+    }
+    if (!bandSame && emit(TRACE_BAND, bandArg, bandBits)) {
+        lastBandBits = bandBits;
+        lastBandArg = bandArg;
+    }
+    if (emit(TRACE_STEP, 0, bits)) {
+        stepOpen = true;
+        lastStepBits = bits;
+        lastStepTime = now;
+        traceRememberInputs(inputSlots, lastTargetBits, lastLoadBits);
+    }
+}
+
+void traceForceOff(uint8_t pump) {
+    if (!traceReady) return;
+    emit(TRACE_FORCE_OFF, pump, 0);
+}
+
+void traceDecision() {
+    if (!traceReady) return;
+    uint16_t mask = 0;
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        if (tracedMaster->getPumpStatus(i)) mask |= 1 << i;
+    }
+    if (mask != lastDecision && emit(TRACE_DECISION, 0, mask)) lastDecision = mask;
+}
+
+// Pagina in één keer achter het segment zetten
+static void writePage() {
+    if (pageCount == 0) return;
+
+    char path[24];
+    traceSegmentPath(pageSequence, path, sizeof(path));
+    File file = LittleFS.open(path, pageStartsSegment ? "w" : "a");
+    size_t bytes = pageCount * sizeof(TraceRecord);
+    if (file && file.write(reinterpret_cast<const uint8_t*>(tracePage), bytes) == bytes) {
+        traceStats.bytesWritten += bytes;
+        traceStats.pageWrites++;
+    } else {
+        traceStats.writeErrors++;
+    }
+    if (file) file.close();
+    pageCount = 0;
+    pageStartsSegment = false;
+}
+
+// Wachtrij naar de pagina; naar flash als de pagina vol of te oud is, of als er een nieuw segment begint
+void flushTrace() {
+    if (!traceReady) return;
+
+    TraceRecord record;
+    while (pop(record)) {
+        bool header = flushRaw == 0 && record.type == TRACE_SEGMENT;
+        if (flushRaw > 0) {
+            flushRaw--; // Ruwe bytes van een keyframe; het typeveld betekent hier niets
+        } else if (record.type == TRACE_KEYFRAME) {
+            flushRaw = record.arg;
+        }
+
+        if (header) {
+            writePage();
+            pageSequence = record.value;
+            pageStartsSegment = true;
+        }
+        if (pageCount == 0) pageStarted = millis();
+        tracePage[pageCount++] = record;
+        if (pageCount == TRACE_PAGE_RECORDS) writePage();
+    }
+    if (pageCount > 0 && millis() - pageStarted >= TRACE_PAGE_MAX_AGE) writePage();
+}
+
+void syncTrace() {
+    if (!traceReady) return;
+    flushTrace();
+    writePage();
+}
+
+uint8_t listTraceSegments(uint32_t* sequences, uint8_t maxCount) {
+    uint8_t count = 0;
+    char path[24];
+    uint32_t newest = traceStats.segment;
+    uint32_t oldest = newest >= TRACE_SEGMENTS - 1 ? newest - (TRACE_SEGMENTS - 1) : 0;
+    for (uint32_t sequence = oldest; sequence <= newest && count < maxCount; sequence++) {
+        traceSegmentPath(sequence, path, sizeof(path));
+        File file = LittleFS.open(path, "r");
+        if (!file) continue;
+        TraceRecord first;
+        bool valid = file.read(reinterpret_cast<uint8_t*>(&first), sizeof(first)) == sizeof(first) &&
+                     first.type == TRACE_SEGMENT && first.value == sequence;
+        file.close();
+        if (valid) sequences[count++] = sequence;
+    }
+    return count;
+}
+
+TraceStats getTraceStats() {
+    return traceStats;
+}
@@ -0,0 +1,133 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include "MQTT.h"
+
+class PumpMaster;
+
+// Opname van alle invoer van PumpMaster en elke beslissing, om een voorval achteraf op de host na te
+// spelen (sim/tracereplay). Alleen de regeltaak neemt op; de records gaan via een wachtrij zonder locks
+// naar de netwerktaak, die ze met flushTrace() verzamelt in een pagina van 4 KB in RAM. Een volle
+// pagina, of uiterlijk na 10 minuten een halfvolle, komt in een ring van segmentbestanden op flash.
+// Elk segment begint met een keyframe van PumpMaster en is daardoor los af te spelen.
+//
+// De ruis van de sensoren (±1 stap van 1/16 °C) maakt bijna elke stap anders. Zulke stappen gaan als
+// TRACE_SAMPLES: per stap het verschil met de vorige buffertemperatuur in hele stappen van de sensor, en
+// welk van de laatst gebruikte paren van doel en verwachte last geldt. Het naspelen rekent exact terug.
+
+// Soorten records
+enum TraceType : uint8_t {
+    TRACE_SEGMENT = 1,  // value = volgnummer; arg = TRACE_BOOT in het eerste segment na het opstarten
+    TRACE_TIME,         // value = millis(); aan het begin van een segment en na een pauze van meer dan 65 s
+    TRACE_KEYFRAME,     // value = sizeof(PumpMasterState); arg = aantal records met ruwe bytes dat volgt
+    TRACE_TARGET,       // value = doeltemperatuur (float)
+    TRACE_BAND,         // value = hysterese (float); arg = 1 bij verwarmen
+    TRACE_LOAD,         // setExpectedLoad(): value = pompen (float)
+    TRACE_STEP,         // update() met value = buffertemperatuur (float) en het laatste doel en de laatste band
+    TRACE_REPEAT,       // Vorige stap nog value keer met dezelfde invoer, elke deltaMs
+    TRACE_MODE,         // GetMode(): arg = HeatPumpMode
+    TRACE_MQTT,         // getMqttConnectionState(): arg = MqttConnectionState
+    TRACE_SEED,         // Startwaarde uit MQTT voor het eerst gezien: arg = pomp, value = run_time in seconden
+    TRACE_FORCE_OFF,    // forcePumpOff(): arg = pomp
+    TRACE_DECISION,     // Pompen na een stap die iets veranderde: value = bit per pomp
+    TRACE_SAMPLES       // arg stappen, elke deltaMs: per stap TRACE_SAMPLE_BITS in value, de eerste onderaan
+};
+
+const uint8_t TRACE_BOOT = 1;
+
+// Record zoals het op flash staat (8 bytes, little-endian)
+struct __attribute__((packed)) TraceRecord {
+    uint16_t deltaMs;  // Sinds het vorige record; bij TRACE_REPEAT de tijd tussen de stappen
+    uint8_t type;      // TraceType
+    uint8_t arg;
+    uint32_t value;
+};
+
+// Compacte stap: bits 0-2 = verschil met de vorige buffertemperatuur + TRACE_SAMPLE_MAX_DELTA,
+// bits 3-4 = vak in TraceInputSlots met het doel en de verwachte last
+const uint8_t TRACE_SAMPLE_BITS = 5;
+const uint8_t TRACE_SAMPLES_PER_RECORD = 32 / TRACE_SAMPLE_BITS;
+const int TRACE_SAMPLE_MAX_DELTA = 3;
+const float TRACE_SAMPLE_LSB = 0.0625; // Stap van de DS18B20 bij 12 bits
+const uint8_t TRACE_INPUT_SLOTS = 4;
+
+// Laatst gebruikte paren van doel en verwachte last (als bits). Opname en naspelen werken ze bij na
+// elke volledige TRACE_STEP en beginnen ze leeg bij elk keyframe, zodat de vakken aan beide kanten gelijk zijn.
+struct TraceInputSlots {
+    uint32_t target[TRACE_INPUT_SLOTS];
+    uint32_t load[TRACE_INPUT_SLOTS];
+    uint8_t used;
+    uint8_t next; // Vak dat als eerste wordt overschreven
+};
+
+const uint8_t TRACE_SEGMENTS = 8;             // Bestanden in de ring
+const size_t TRACE_SEGMENT_BYTES = 64 * 1024; // Daarna begint een nieuw segment
+
+struct TraceStats {
+    uint32_t segment;       // Volgnummer van het huidige segment
+    uint32_t records;       // In de wachtrij gezet sinds de start
+    uint32_t steps;         // Opgenomen aanroepen van update(), ook de herhaalde
+    uint32_t dropped;       // Wachtrij vol; het segment is daarna opnieuw begonnen
+    uint32_t bytesWritten;  // Naar flash
+    uint32_t pageWrites;    // Schrijfacties naar flash, één per pagina
+    uint32_t writeErrors;
+};
+
+// Segmenten op flash zoeken en een nieuw segment met een keyframe beginnen.
+// Na setupSpool() (LittleFS) en pumpMaster.begin().
+void setupTrace(PumpMaster& master);
+
+// Regeltaak, rond elke aanroep van PumpMaster; alles behalve stappen alleen bij een wijziging
+void traceInputs(HeatPumpMode mode, MqttConnectionState mqttState);
+void traceLoad(float pumps);                                                      // Voor setExpectedLoad()
+void traceStep(float currentTemp, float targetTemp, bool heating, float hysteresis); // Voor update()
+void traceForceOff(uint8_t pump);                                                 // Voor forcePumpOff()
+void traceDecision();                                                             // Na update() of forcePumpOff()
+
+// Netwerktaak: wachtrij naar de pagina, en de pagina naar flash als die vol of oud genoeg is
+void flushTrace();
+
+// Netwerktaak: ook een halfvolle pagina nu naar flash, bijvoorbeeld voor een download
+void syncTrace();
+
+// Volgnummers van de segmenten op flash, oudste eerst; geeft het aantal
+uint8_t listTraceSegments(uint32_t* sequences, uint8_t maxCount);
+void traceSegmentPath(uint32_t sequence, char* path, size_t size);
+
+TraceStats getTraceStats();
+
+inline uint32_t traceFloatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float traceFloat(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Vak met dit paar, of -1
+inline int traceFindInputs(const TraceInputSlots& slots, uint32_t target, uint32_t load) {
+    for (int i = 0; i < slots.used; i++) {
+        if (slots.target[i] == target && slots.load[i] == load) return i;
+    }
+    return -1;
+}
+
+inline void traceRememberInputs(TraceInputSlots& slots, uint32_t target, uint32_t load) {
+    if (traceFindInputs(slots, target, load) >= 0) return;
+    slots.target[slots.next] = target;
+    slots.load[slots.next] = load;
+    if (slots.used < TRACE_INPUT_SLOTS) slots.used++;
+    slots.next = (slots.next + 1) % TRACE_INPUT_SLOTS;
+}
+
+// Buffertemperatuur van een compacte stap uit die van de vorige stap
+inline float traceSampleTemperature(float previous, uint32_t sample) {
+    return previous + ((int)(sample & 7) - TRACE_SAMPLE_MAX_DELTA) * TRACE_SAMPLE_LSB;
+}
+
+#endif // TRACE_H
@@ -6,9 +6,6 @@
 #include <WebServer.h>
 #include <Update.h>
 #include <ESPmDNS.h>
-#include <ShiftRegister74HC595_NonTemplate.h>
-#include <OneWire.h>
-#include <DallasTemperature.h>
 #include <EEPROM.h>
 #include <PubSubClient.h>
 #include <HTTPClient.h>
@@ -19,15 +16,31 @@
 #include "Debug.h"
 #include "PumpMaster.h" // Regelt de logica voor het verwarmen van de buffervaten.
 #include "Portal.h" // Regelt dat de informatie met de gebruikers wordt gedeeld. Als gebruiker kan je inloggen via verwarming.local
+#include "Sensors.h" // Leest de DS18B20-sensoren asynchroon uit en deelt de laatste meting.
+#include "Boot.h" // Houdt per opstartfase bij hoe lang die duurde.
+#include "Spool.h" // Bewaart MQTT-berichten op flash zolang de broker onbereikbaar is.
+#include "Events.h" // Stuurt wijzigingen live naar de portal via Server-Sent Events.
+#include "Scheduler.h" // Verdeelt het werk van de regeltaak en de netwerktaak over periodieke taken met elk een eigen periode.
+#include "CommandQueue.h" // Opdrachten van de portal aan de regeltaak.
+#include "ControllerState.h" // Momentopname van de regeltaak voor MQTT, portal en events.
+#include "Weather.h" // Haalt de buitentemperatuur op bij open-meteo, met de buitenvoeler als terugval.
+#include "History.h" // Verloop van temperaturen en relais in RAM, voor /api/history.
+#include "Outputs.h" // Relais en leds op het schuifregister, in één frame per commit.
+#include "Ota.h" // Firmware-update met SHA-256-controle en terugval als de nieuwe firmware niet gezond wordt.
+#include "Metrics.h" // Tijdhistogrammen per stap en heapgegevens, voor /metrics en warmtepomp/metrics.
+#include "Trace.h" // Invoer en beslissingen van PumpMaster op flash, om op de host na te spelen.
+#include "Supervisor.h" // Budget per stap; voedt de task watchdog en laat sporen na in RTC-geheugen.
+#include <esp_task_wdt.h>
 #include "MQTT.h" // Regelt dat er een MQTT tabel word gemaakt. Deze tabel word gedeeld met Portal.h en PumpMaster.h en aangevuld door de 3 warmtepompen.
 
-bool relayStatus[6] = {false, false, false, false, false, false}; // Alle relays standaard uit
-unsigned long lastOnTimes[6] = {0, 0, 0, 0, 0, 0}; // Laatste inschakeltijden voor alle relais
-unsigned long lastOffTimes[6] = {0, 0, 0, 0, 0, 0}; // Laatste uitschakeltijden voor alle relais
-String mqttLog = ""; // Log voor MQTT-berichten
+// Alleen van de regeltaak; andere taken lezen de toestand via getControllerState()
+bool relayStatus[RELAY_COUNT] = {false}; // Gevraagde stand; wat er werkelijk op staat komt uit getOutputFrame()
+unsigned long lastOnTimes[RELAY_COUNT] = {0}; // Laatste inschakeltijden volgens het frame op de uitgangen
+unsigned long lastOffTimes[RELAY_COUNT] = {0}; // Laatste uitschakeltijden volgens het frame op de uitgangen
+bool changeoverPending = false; // Omschakelen tussen verwarmen en koelen bezig; PumpMaster start dan niets
+bool manualMode = false; // Automatisch of handmatig schakelen, ingesteld via de portal
 
-bool pumpStatus[3] = {false, false, false}; // Alle pompen starten uit
-String laatsteMode = "Verwarmen"; // Standaard starten in Verwarmen
+HeatPumpMode laatsteMode = MODE_HEATING; // Standaard starten in Verwarmen
 
 // Externe configuratie
 #define DATA_PIN 7
@@ -39,7 +52,7 @@ String laatsteMode = "Verwarmen"; // Standaard starten in Verwarmen
 #define BUFFER_TEMP_SENSOR_INDEX 0
 
 const char* hostname = "verwarming";
-const char* weatherEndpoint = "https://api.open-meteo.com/v1/forecast?latitude=51.9125&longitude=4.3417&current_weather=true";
+const char* weatherEndpoint = "http://api.open-meteo.com/v1/forecast?latitude=51.9125&longitude=4.3417&current_weather=true";
 const char* ntpServer = "pool.ntp.org";
 const long gmtOffset_sec = 3600;
 const int daylightOffset_sec = 3600;
@@ -48,23 +61,64 @@ const int daylightOffset_sec = 3600;
 unsigned long invalidTempStartTime = 0;
 const unsigned long MAX_INVALID_TEMP_DURATION = 30UL * 60UL * 1000UL; // 30 minuten
 bool alarmTriggered = false;
+const uint32_t MAX_SENSOR_AGE = 10000; // Meting ouder dan 10 seconden telt als ongeldig
 
 
-OneWire oneWire(ONE_WIRE_BUS);
-DallasTemperature sensors(&oneWire);
 WebServer server(80);
-ShiftRegister74HC595_NonTemplate* control;
 PumpMaster pumpMaster;
+WiFiManager wifiManager;
+bool wifiPortalStarted = false;
+volatile bool bootPublished = false; // Gezet door de netwerktaak, gelezen door de regeltaak voor CH7
+const unsigned long WIFI_CONNECT_TIMEOUT = 30000; // Daarna het configuratieportaal openen
+const unsigned long BOOT_PUBLISH_TIMEOUT = 120000; // Opstarttijden uiterlijk na 2 minuten publiceren
+const unsigned long RUNTIME_PUBLISH_INTERVAL = 10UL * 60UL * 1000UL; // Draaitijden elke 10 minuten publiceren
+const unsigned long CHANGEOVER_DEAD_TIME = 30000; // Pompen uit rond het omschakelen tussen verwarmen en koelen
+const WeatherConfig WEATHER_CONFIG = {
+    15UL * 60UL * 1000UL,  // Elk kwartier ophalen; open-meteo ververst current_weather per kwartier
+    60UL * 1000UL,         // Na een mislukte poging na een minuut opnieuw, daarna steeds twee keer zo lang
+    60UL * 60UL * 1000UL,  // Een uur oude waarde is nog bruikbaar, daarna de buitenvoeler
+    10000                  // Hele ophaalactie binnen 10 seconden
+};
+const PublishConfig PUBLISH_CONFIG = {
+    5UL * 60UL * 1000UL,   // Heartbeat: alles opnieuw na 5 minuten
+    0.2,                   // Dode zone buffertemperatuur in °C
+    false,                 // Losse topics in plaats van warmtepomp/state
+    {CODEC_JSON,           // Toestand: Home Assistant leest JSON
+     CODEC_JSON,           // Telemetrie; CODEC_MSGPACK scheelt ongeveer een kwart aan bytes
+     CODEC_JSON},          // Waarschuwingen en log
+    60UL * 1000UL          // Samenvatting op warmtepomp/metrics elke minuut; 0 = alleen /metrics
+};
+
+// Regeltaak: sensoren, pompen en relais op core 1, met voorrang.
+// Netwerktaak: WiFi, MQTT, portal en events op core 0, naast de WiFi-stack.
+// Ze delen alleen de ControllerState (seqlock), de opdrachtwachtrij van de portal en losse vlaggen.
+Scheduler controlScheduler;
+Scheduler networkScheduler;
+TaskHandle_t controlTaskHandle = nullptr;
+TaskHandle_t networkTaskHandle = nullptr;
+int pumpsTaskIndex = -1; // Voor de gezondheidscontrole na een update
+const BaseType_t CONTROL_CORE = 1;
+const BaseType_t NETWORK_CORE = 0;
+const UBaseType_t CONTROL_PRIORITY = 3;
+const UBaseType_t NETWORK_PRIORITY = 2;
+const uint32_t CONTROL_STACK_SIZE = 4096;
+const uint32_t NETWORK_STACK_SIZE = 8192;
+const UBaseType_t SUPERVISOR_PRIORITY = 4;        // Boven beide schedulers, zodat hij zelf nooit te laat is
+const uint32_t SUPERVISOR_STACK_SIZE = 3072;
+const uint32_t SUPERVISOR_INTERVAL = 1000;        // Controle en voeden
+const uint32_t WATCHDOG_TIMEOUT_MS = 30000;       // Zonder voeden volgt een herstart
 
 float bufferTemperature = 0.0;
 float outdoorTemperatureOnline = 0.0;
+OutdoorSource outdoorSource = OUTDOOR_NONE; // Herkomst van outdoorTemperatureOnline
 bool debugMode = false;
 
 void turnRelaysOff() {
-    for (int i = 0; i < 8; i++) { // We hebben 8 kanalen, 6 voor een relais en 2 voor een led.
-        control->set(i, LOW);
-        control->set(6, HIGH);  // CH7 aan als de module start
+    for (int i = 0; i < OUTPUT_CHANNELS; i++) { // We hebben 8 kanalen, 6 voor een relais en 2 voor een led.
+        outputSet(i, false);
     }
+    outputSet(LED_BOOT_CHANNEL, true); // CH7 aan als de module start
+    outputCommit();
 }
 
 String getFormattedTime() {
@@ -79,36 +133,36 @@ String getFormattedTime() {
 
 void setup() {
     Serial.begin(115200);
-    delay(2000);
-    debugPrint("Begonnen met de serial communicatie");
+    bootStart();
+    setupSupervisor(WATCHDOG_TIMEOUT_MS);
+    setupMetrics();
+    logPrintf(LOG_INFO, LOG_SYSTEM, "Begonnen met de serial communicatie");
     pinMode(ENABLE_PIN, OUTPUT);
     digitalWrite(ENABLE_PIN, HIGH);
-    control = new ShiftRegister74HC595_NonTemplate(8, DATA_PIN, CLOCK_PIN, LATCH_PIN); // Uitbreiden naar 8 outputs
+    setupOutputs(DATA_PIN, CLOCK_PIN, LATCH_PIN);
+    uint8_t pumpMask = 0;
+    for (int i = 0; i < PUMP_COUNT; i++) pumpMask |= 1 << pumpRelay(i);
+    setOutputInterlock(COOLING_RELAY, pumpMask, CHANGEOVER_DEAD_TIME); // Niet omschakelen met draaiende pompen
     turnRelaysOff();
     digitalWrite(ENABLE_PIN, LOW);
-    sensors.begin();
 
-    WiFiManager wifiManager;
-    wifiManager.setHostname(hostname);
+    // Alles hieronder start direct; de afronding volgt in taskBoot()
+    setupSpool();
+    setupSensors(ONE_WIRE_BUS, BUFFER_TEMP_SENSOR_INDEX, OUTDOOR_TEMP_SENSOR_INDEX);
+    pumpMaster.begin();
+    setupTrace(pumpMaster);
 
-    if (wifiManager.autoConnect("LilyGO-Relay")) {
-        control->set(7, LOW);  // CH8 uit als WiFi werkt
-        debugPrint("WiFi verbonden");
-    } else {
-        control->set(7, HIGH); // CH8 aan bij falende WiFi-verbinding
-        debugPrint("WiFi-verbinding mislukt");
+    WiFi.mode(WIFI_STA);
+    WiFi.setHostname(hostname);
+    WiFi.begin(); // Verbinden met de opgeslagen gegevens, zonder te wachten
+    wifiManager.setHostname(hostname);
+    wifiManager.setConfigPortalBlocking(false);
+    {
+        SupervisedStage stage("setup_mqtt", 2000);
+        setupMQTT();
+        configurePublishing(PUBLISH_CONFIG);
     }
-
-    configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
-
-    setupMQTT();
-
-    // Start de portal via Portal.cpp
-    setupPortal(hostname);
-    control->set(6, LOW);  // CH7 uit als setup is afgerond
-
-    // Voeg de starttijd toe aan MQTT.
-    updateStarttime();
+    setupWeather(weatherEndpoint, WEATHER_CONFIG);
 
     esp_reset_reason_t reason = esp_reset_reason();
 
@@ -126,88 +180,366 @@ void setup() {
         default: rebootReason = "Onbekende reden (" + String(reason) + ")"; break;
     }
 
-    debugPrint("Laatste reboot reden: " + rebootReason);
+    logPrintf(LOG_INFO, LOG_SYSTEM, "Laatste reboot reden: %s", rebootReason.c_str());
+    setupOta();
+
+    outputSet(LED_WIFI_CHANNEL, true); // CH8 aan tot WiFi verbonden is
+    outputCommit();
+    setupTasks();
 }
 
-void loop() {
-    if (WiFi.status() == WL_CONNECTED) {
-        control->set(7, LOW);
-    } else {
-        control->set(7, HIGH);
+// Opstartfasen afronden zodra ze klaar zijn; niets hiervan wacht op een ander
+void taskBoot() {
+    if (!bootPhaseCompleted(BOOT_WIFI)) {
+        if (WiFi.status() == WL_CONNECTED) {
+            bootPhaseDone(BOOT_WIFI);
+            logPrintf(LOG_INFO, LOG_SYSTEM, "WiFi verbonden");
+            configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
+            setupPortal(hostname); // Start de portal via Portal.cpp
+            bootPhaseDone(BOOT_PORTAL);
+        } else if (!wifiPortalStarted && millis() > WIFI_CONNECT_TIMEOUT) {
+            logPrintf(LOG_WARN, LOG_SYSTEM, "WiFi-verbinding mislukt, configuratieportaal gestart");
+            wifiManager.startConfigPortal("LilyGO-Relay");
+            wifiPortalStarted = true;
+        }
+    }
+
+    if (wifiPortalStarted) {
+        wifiManager.process();
+    }
+
+    struct tm timeinfo;
+    if (bootPhaseCompleted(BOOT_WIFI) && !bootPhaseCompleted(BOOT_NTP) && getLocalTime(&timeinfo, 0)) {
+        bootPhaseDone(BOOT_NTP);
+    }
+
+    if (!bootPhaseCompleted(BOOT_MQTT) && getMqttConnectionState() == MQTT_SUBSCRIBED) {
+        bootPhaseDone(BOOT_MQTT);
+    }
+
+    // Publiceren zodra alles klaar is, of na een time-out met de fasen die wel klaar zijn
+    if (!bootPublished && bootPhaseCompleted(BOOT_MQTT) && (bootCompleted() || millis() > BOOT_PUBLISH_TIMEOUT)) {
+        updateStarttime();     // Voeg de starttijd toe aan MQTT.
+        publishBootTimes();
+        publishRebootReport();
+        bootPublished = true;  // CH7 gaat uit in de regeltaak
+    }
+}
+
+// Statusleds: CH7 brandt tot de opstart gepubliceerd is, CH8 volgt de WiFi-verbinding.
+// Het schuifregister wordt alleen vanuit de regeltaak beschreven.
+void taskLeds() {
+    outputSet(LED_BOOT_CHANNEL, !bootPublished);
+    outputSet(LED_WIFI_CHANNEL, WiFi.status() != WL_CONNECTED);
+}
+
+// Opdrachten van de portal uitvoeren
+void taskCommands() {
+    Command command;
+    while (popCommand(command)) {
+        switch (command.type) {
+            case CMD_SET_MANUAL:
+                manualMode = command.value;
+                break;
+            case CMD_TOGGLE_RELAY:
+                if (command.index < RELAY_COUNT) {
+                    relayStatus[command.index] = !relayStatus[command.index];
+                    logPrintf(LOG_INFO, LOG_PORTAL, "Relay %d %s", command.index, relayStatus[command.index] ? "aangezet" : "uitgezet");
+                }
+                break;
+        }
     }
+}
+
+// Conversie starten of ophalen en de gedeelde meting overnemen
+void taskSensors() {
+    StageTimer timer(STAGE_SENSORS);
+    loopSensors();
+
+    const SensorSnapshot& snapshot = getSensorSnapshot();
+    bufferTemperature = snapshot.bufferValid ? snapshot.bufferTemperature : -127.0; // -127 = sensor niet bereikbaar
+
+    float outdoor;
+    OutdoorSource source = selectOutdoorTemperature(snapshot, outdoor);
+    if (source != outdoorSource) {
+        static const char* const sourceNames[] = {"geen", "weerdienst", "buitenvoeler"};
+        logPrintf(LOG_INFO, LOG_SENSORS, "Buitentemperatuur komt nu van: %s", sourceNames[source]);
+        outdoorSource = source;
+    }
+    if (source != OUTDOOR_NONE) {
+        outdoorTemperatureOnline = outdoor;
+    }
+}
 
-    sensors.requestTemperatures();
-    bufferTemperature = sensors.getTempCByIndex(BUFFER_TEMP_SENSOR_INDEX);
+// Relais van de pompen volgen PumpMaster
+void setPumpRelays() {
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        uint8_t relay = pumpRelay(i);
+        relayStatus[relay] = pumpMaster.getPumpStatus(i);
+        outputSet(relay, relayStatus[relay]);
+    }
+}
 
-    // Mode ophalen via MQTT
-    String mode = GetMode();
-    if (mode == "Verwarmen" || mode == "Koelen") {
+// Mode overnemen van MQTT en koelrelais schakelen
+void taskMode() {
+    StageTimer timer(STAGE_MODE);
+    HeatPumpMode mode = GetMode();
+    traceInputs(mode, getMqttConnectionState());
+    if (mode != MODE_NONE) {
         if (mode != laatsteMode) {
-            debugPrint("Modus gewijzigd via MQTT: " + mode);
+            logPrintf(LOG_INFO, LOG_PUMPS, "Modus gewijzigd via MQTT: %s", mode == MODE_COOLING ? "Koelen" : "Verwarmen");
         }
         laatsteMode = mode;
     }
 
     // Koelrelais schakelen
-    if (laatsteMode == "Koelen") {
-        control->set(3, HIGH);      // Koelen AAN
-        relayStatus[3] = true;      // Relaystatus ook bijwerken
-    } else {
-        control->set(3, LOW);       // Koelen UIT
-        relayStatus[3] = false;     // Relaystatus ook bijwerken
+    relayStatus[COOLING_RELAY] = (laatsteMode == MODE_COOLING);
+    outputSet(COOLING_RELAY, relayStatus[COOLING_RELAY]);
+
+    // Omschakelen gaat via PumpMaster: draaiende pompen uit, zodat hun minimale uittijd geldt.
+    // De vergrendeling in Outputs.cpp is alleen het vangnet.
+    changeoverPending = outputChangeoverPending();
+    if (changeoverPending) {
+        bool stopped = false;
+        for (int i = 0; i < PUMP_COUNT; i++) {
+            if (!pumpMaster.getPumpStatus(i)) continue;
+            traceForceOff(i);
+            pumpMaster.forcePumpOff(i);
+            stopped = true;
+        }
+        if (stopped) {
+            logPrintf(LOG_INFO, LOG_PUMPS, "Pompen uit voor het omschakelen naar %s", laatsteMode == MODE_COOLING ? "koelen" : "verwarmen");
+            traceDecision();
+            setPumpRelays();
+        }
     }
+}
 
-    // Buffertemperatuur geldig?
-    if (bufferTemperature > 0.0) {
-        bool heating = (laatsteMode == "Verwarmen");
-        float targetTemp = heating ? 30.0 : 14.0;
+// Pompregeling en relais van de warmtepompen
+void taskPumps() {
+    // Buffertemperatuur geldig en recent gemeten?
+    if (bufferTemperatureFresh(MAX_SENSOR_AGE) && bufferTemperature > 0.0) {
+        bootPhaseDone(BOOT_SENSOR);
+        bool heating = (laatsteMode == MODE_HEATING);
+        bool outdoorKnown = (outdoorSource != OUTDOOR_NONE);
+        float targetTemp = 14.0;
+        if (heating) targetTemp = outdoorKnown ? heatingCurveTarget(outdoorTemperatureOnline) : HEATING_TARGET_FALLBACK;
         float hysteresis = heating ? 5.0 : 1.0;
 
-        pumpMaster.update(bufferTemperature, targetTemp, heating, hysteresis);
-        publishBufferTemperature(bufferTemperature);
+        float load = heating && outdoorKnown ? expectedLoadPumps(outdoorTemperatureOnline) : 0.0;
+        traceLoad(load);
+        pumpMaster.setExpectedLoad(load);
+        if (!changeoverPending) { // Tijdens het omschakelen geen pomp starten
+            traceStep(bufferTemperature, targetTemp, heating, hysteresis);
+            uint32_t updateStart = metricsStart(STAGE_PUMPS);
+            pumpMaster.update(bufferTemperature, targetTemp, heating, hysteresis);
+            metricsRecord(STAGE_PUMPS, updateStart);
+            traceDecision();
+        }
+        bootPhaseDone(BOOT_CONTROL);
 
         invalidTempStartTime = 0;
         alarmTriggered = false;
     } else {
-        debugPrint("Buffertemperatuur ongeldig (" + String(bufferTemperature) + " °C)");
+        logPrintf(LOG_WARN, LOG_SENSORS, "Buffertemperatuur ongeldig (%.2f °C)", bufferTemperature);
 
         if (invalidTempStartTime == 0) {
             invalidTempStartTime = millis();
-            debugPrint("Start met fouttimer voor buffertemperatuur.");
+            logPrintf(LOG_WARN, LOG_SENSORS, "Start met fouttimer voor buffertemperatuur.");
         }
 
         if (!alarmTriggered && millis() - invalidTempStartTime >= MAX_INVALID_TEMP_DURATION) {
-            debugPrint("Buffertemperatuur blijft te lang foutief. Schakel warmtepompen uit en stuur waarschuwing.");
+            logPrintf(LOG_ERROR, LOG_PUMPS, "Buffertemperatuur blijft te lang foutief. Schakel warmtepompen uit en stuur waarschuwing.");
 
-            for (int i = 0; i < 3; i++) {
+            for (int i = 0; i < PUMP_COUNT; i++) {
+                traceForceOff(i);
                 pumpMaster.forcePumpOff(i);
             }
+            traceDecision();
 
-            StaticJsonDocument<128> warning;
-            warning["type"] = "temperatuur_fout";
-            warning["melding"] = "Buffertemperatuur is al 30 minuten ongeldig.";
-            warning["actie"] = "Pompen uitgeschakeld.";
+            alarmTriggered = true; // De netwerktaak stuurt de waarschuwing bij de flank
+        }
+    }
 
-            char buffer[128];
-            serializeJson(warning, buffer);
-            mqttClient.publish("warmtepomp/waarschuwing", buffer, false);
+    setPumpRelays();
+}
 
-            alarmTriggered = true;
-        }
+// Relais en leds in één keer naar het schuifregister, alleen als er iets veranderd is.
+// Schakeltijden volgen het frame dat echt op de uitgangen staat.
+void taskOutputs() {
+    static uint8_t previousFrame = 0;
+    outputCommit();
+    uint8_t frame = getOutputFrame();
+    uint8_t changed = frame ^ previousFrame;
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (!(changed & (1 << i))) continue;
+        if (frame & (1 << i)) lastOnTimes[i] = millis();
+        else lastOffTimes[i] = millis();
     }
+    previousFrame = frame;
+}
+
+// Huidige toestand verzamelen voor MQTT en portal
+ControllerState collectState() {
+    ControllerState state;
+    uint8_t frame = getOutputFrame(); // Gemeld wordt wat er op de relais staat, niet wat er gevraagd is
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        state.relayStatus[i] = frame & (1 << i);
+        state.lastOnTimes[i] = lastOnTimes[i];
+        state.lastOffTimes[i] = lastOffTimes[i];
+    }
+    state.bufferValid = bufferTemperatureFresh(MAX_SENSOR_AGE);
+    state.bufferTemperature = bufferTemperature;
+    state.outdoorValid = (outdoorSource != OUTDOOR_NONE);
+    state.outdoorTemperature = outdoorTemperatureOnline;
+    state.cooling = (laatsteMode == MODE_COOLING);
+    state.manualMode = manualMode;
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        state.runtimeSeconds[i] = (unsigned long)(pumpMaster.getRuntime(i) / 1000ULL);
+    }
+    state.staging = pumpMaster.getStagingMetrics();
+    state.outputs = getOutputStats();
+    state.wifiConnected = (WiFi.status() == WL_CONNECTED);
+    state.mqttConnected = (getMqttConnectionState() == MQTT_SUBSCRIBED);
+    state.alarm = alarmTriggered;
+    return state;
+}
+
+// Toestand vastleggen voor de netwerktaak
+void taskState() {
+    setControllerState(collectState());
+}
+
+// Verbinding met de broker onderhouden en inkomende berichten verwerken
+void taskMqtt() {
+    StageTimer timer(STAGE_MQTT);
+    loopMQTT();
+}
+
+// Gewijzigde velden publiceren vanuit de laatste momentopname van de regeltaak
+void taskPublish() {
+    static bool alarmPublished = false;
+    static unsigned long lastRuntimePublish = 0;
+
+    ControllerState state;
+    getControllerState(state);
+    publishChanges(state);
 
-    // Relaisstatus bijwerken
-    for (int i = 0; i < 3; i++) {
-        bool currentStatus = pumpMaster.getPumpStatus(i);
-        if (currentStatus != relayStatus[i]) {
-            relayStatus[i] = currentStatus;
-            if (currentStatus) lastOnTimes[i] = millis();
-            else lastOffTimes[i] = millis();
+    // Waarschuwing eenmalig bij het afgaan van het alarm
+    if (state.alarm && !alarmPublished) {
+        publishWarning(WARNING_BUFFER_TEMPERATURE);
+    }
+    alarmPublished = state.alarm;
+
+    if (millis() - lastRuntimePublish >= RUNTIME_PUBLISH_INTERVAL) {
+        for (int i = 0; i < PUMP_COUNT; i++) {
+            sendRuntimeToMQTT(i, state.runtimeSeconds[i]);
         }
-        control->set(i, relayStatus[i]);
+        lastRuntimePublish = millis();
     }
 
-    loopMQTT(relayStatus, lastOnTimes, lastOffTimes, 6);
+    publishLog();
+    replaySpool();
+    publishMetrics();
+}
+
+// Verloop vastleggen; op de netwerktaak, net als /api/history dat het leest
+void taskHistory() {
+    ControllerState state;
+    getControllerState(state);
+    recordHistory(state);
+}
+
+// Buitentemperatuur ophalen; leest per aanroep alleen wat al binnen is
+void taskWeather() {
+    loopWeather();
+}
+
+// Nieuwe firmware bevestigen zodra hij gezond is, alleen op wat het apparaat zelf ziet: de pompregeling
+// draait, de buffervoeler geeft verse metingen en de portal is op (zodat er opnieuw geflasht kan worden).
+// MQTT telt niet mee; een storing van de broker mag een goede firmware niet terugdraaien.
+// Anders na OTA_HEALTH_TIMEOUT terug naar de vorige.
+void taskOta() {
+    const ScheduledTask* pumps = controlScheduler.getTask(pumpsTaskIndex);
+    bool controlRunning = pumps != nullptr && pumps->runs > 0;
+    ControllerState state;
+    getControllerState(state); // Consistente momentopname van de regeltaak
+    loopOta(controlRunning && state.bufferValid && bootPhaseCompleted(BOOT_PORTAL));
+}
+
+// Opgenomen invoer en beslissingen van de regeltaak naar de pagina in RAM; per volle pagina naar flash
+void taskTrace() {
+    flushTrace();
+}
+
+// Webportal afhandelen
+void taskPortal() {
+    StageTimer timer(STAGE_PORTAL);
     server.handleClient();
-    delay(1000);
+}
+
+// Wijzigingen naar de live kijkers van /events sturen
+void taskEvents() {
+    loopEvents();
+}
+
+// Regeltaak; draait met voorrang zodat netwerkverkeer de regeling niet vertraagt
+void controlTask(void* parameter) {
+    for (;;) {
+        controlScheduler.run();
+    }
+}
+
+void networkTask(void* parameter) {
+    for (;;) {
+        networkScheduler.run();
+    }
+}
+
+// Enige taak bij de task watchdog; voedt hem alleen als alle stappen binnen hun budget blijven
+void supervisorTask(void* parameter) {
+    esp_task_wdt_add(NULL);
+    for (;;) {
+        superviseStages();
+        vTaskDelay(pdMS_TO_TICKS(SUPERVISOR_INTERVAL));
+    }
+}
+
+void setupTasks() {
+    controlScheduler.addTask("commands", 50, taskCommands);
+    controlScheduler.addTask("sensors", 100, taskSensors);
+    controlScheduler.addTask("mode", 200, taskMode, 100);
+    pumpsTaskIndex = controlScheduler.addTask("pumps", 1000, taskPumps, 200);
+    controlScheduler.addTask("leds", 1000, taskLeds);
+    controlScheduler.addTask("outputs", 200, taskOutputs, 250); // Na mode, pumps en leds
+    controlScheduler.addTask("state", 1000, taskState, 300);
+
+    // Budgetten van netwerktaken ruimer dan hun periode; verbinden en versturen mogen even duren
+    networkScheduler.addTask("boot", 100, taskBoot, 0, 1000);
+    networkScheduler.addTask("mqtt", 50, taskMqtt, 0, 2000); // Verbinden wacht alleen nog op CONNACK, hooguit 1 s
+    networkScheduler.addTask("publish", 1000, taskPublish, 400, 3000);
+    networkScheduler.addTask("portal", 10, taskPortal, 0, 2000); // /update en /api/trace melden voortgang, dus langer mag
+    networkScheduler.addTask("events", 100, taskEvents, 0, 1000);
+    networkScheduler.addTask("weather", 100, taskWeather, 50, 1000);
+    networkScheduler.addTask("history", HISTORY_SAMPLE_INTERVAL, taskHistory, 600);
+    networkScheduler.addTask("ota", 1000, taskOta, 700);
+    networkScheduler.addTask("trace", 1000, taskTrace, 800);
+
+    xTaskCreatePinnedToCore(controlTask, "control", CONTROL_STACK_SIZE, nullptr, CONTROL_PRIORITY, &controlTaskHandle, CONTROL_CORE);
+    xTaskCreatePinnedToCore(networkTask, "network", NETWORK_STACK_SIZE, nullptr, NETWORK_PRIORITY, &networkTaskHandle, NETWORK_CORE);
+    xTaskCreatePinnedToCore(supervisorTask, "supervisor", SUPERVISOR_STACK_SIZE, nullptr, SUPERVISOR_PRIORITY, nullptr, NETWORK_CORE);
+}
+
+// Administratie van de regeltaak, o.a. de vertraging per taak (jitter)
+const Scheduler& getControlScheduler() {
+    return controlScheduler;
+}
+
+const Scheduler& getNetworkScheduler() {
+    return networkScheduler;
+}
+
+void loop() {
+    // Al het werk zit in de twee vastgepinde taken
+    vTaskDelete(NULL);
 }
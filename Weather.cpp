@@ -0,0 +1,422 @@
+#include "Weather.h"
+#include <WiFi.h>
+#include <lwip/dns.h>
+#include <unistd.h>
+#if CONFIG_LWIP_TCPIP_CORE_LOCKING
+#include <lwip/tcpip.h>
+#endif
+#include "Debug.h"
+#include "TcpConnect.h"
+
+// Pad in het antwoord van open-meteo: {"current_weather": {"temperature": 8.4, ...}, ...}
+static const char* const FILTER_PATH[] = {"current_weather", "temperature"};
+static const int FILTER_DEPTH = sizeof(FILTER_PATH) / sizeof(FILTER_PATH[0]);
+static const int PARSER_MAX_DEPTH = 8;          // Dieper genest wordt overgeslagen zonder het pad te volgen
+static const int WEATHER_BYTES_PER_TICK = 512;  // Maximaal aantal bytes per aanroep van loopWeather()
+
+// Zoekt één getal op een vast pad in een JSON-stroom. Houdt alleen per niveau bij of de sleutel tot
+// nu toe op het pad ligt; sleutels en waarden naast het pad worden teken voor teken overgeslagen.
+class WeatherParser {
+public:
+    void begin() {
+        depth = 0;
+        inString = false;
+        escaped = false;
+        expectKey = false;
+        numberLength = 0;
+        found = false;
+    }
+
+    void feed(char c) {
+        if (inString) {
+            feedString(c);
+            return;
+        }
+        if (numberLength > 0) {
+            if (isNumberChar(c)) {
+                if (numberLength < (int)sizeof(number) - 1) number[numberLength] = c;
+                numberLength++;
+                return;
+            }
+            finishNumber();
+        }
+
+        switch (c) {
+            case '{':
+            case '[':
+                if (depth < PARSER_MAX_DEPTH) {
+                    isObject[depth] = (c == '{');
+                    onPath[depth] = false;
+                }
+                depth++;
+                expectKey = (c == '{');
+                break;
+            case '}':
+            case ']':
+                if (depth > 0) depth--;
+                expectKey = false;
+                break;
+            case ',':
+                expectKey = depth > 0 && depth <= PARSER_MAX_DEPTH && isObject[depth - 1];
+                break;
+            case ':':
+                expectKey = false;
+                break;
+            case '"':
+                inString = true;
+                keyString = expectKey;
+                keyLength = 0;
+                keyMatches = keyString && depth > 0 && depth <= FILTER_DEPTH && (depth == 1 || onPath[depth - 2]);
+                break;
+            default:
+                if (c == '-' || (c >= '0' && c <= '9')) {
+                    number[0] = c;
+                    numberLength = 1;
+                }
+                break; // true, false, null en witruimte vallen hier weg
+        }
+    }
+
+    // Een getal aan het einde van de stroom afsluiten
+    void end() {
+        if (numberLength > 0) finishNumber();
+    }
+
+    bool hasValue() const { return found; }
+    float getValue() const { return value; }
+
+private:
+    void feedString(char c) {
+        if (escaped) {
+            escaped = false;
+            keyMatches = false; // Het pad bevat geen escapes
+            return;
+        }
+        if (c == '\\') {
+            escaped = true;
+            return;
+        }
+        if (c != '"') {
+            if (keyMatches) {
+                const char* expected = FILTER_PATH[depth - 1];
+                keyMatches = expected[keyLength] == c;
+                keyLength++;
+            }
+            return;
+        }
+
+        inString = false;
+        if (keyString && depth > 0 && depth <= PARSER_MAX_DEPTH) {
+            onPath[depth - 1] = keyMatches && FILTER_PATH[depth - 1][keyLength] == '\0';
+        }
+    }
+
+    static bool isNumberChar(char c) {
+        return (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E';
+    }
+
+    void finishNumber() {
+        if (!found && depth == FILTER_DEPTH && onPath[depth - 1] && numberLength < (int)sizeof(number)) {
+            number[numberLength] = '\0';
+            value = atof(number);
+            found = true;
+        }
+        numberLength = 0;
+    }
+
+    int depth;
+    bool isObject[PARSER_MAX_DEPTH];
+    bool onPath[PARSER_MAX_DEPTH];   // Huidige sleutel op dit niveau ligt op het pad, net als alle niveaus erboven
+    bool inString;
+    bool escaped;
+    bool expectKey;
+    bool keyString;
+    bool keyMatches;
+    int keyLength;
+    char number[16];
+    int numberLength;
+    bool found;
+    float value;
+};
+
+enum WeatherState : uint8_t {
+    WEATHER_IDLE,       // Wachten op de volgende ophaalactie
+    WEATHER_RESOLVING,  // Wachten op de resolver van lwIP
+    WEATHER_CONNECTING, // Socket zonder blokkeren aan het verbinden
+    WEATHER_STATUS,     // Statusregel lezen
+    WEATHER_HEADERS,   // Headers overslaan tot de lege regel
+    WEATHER_BODY       // Body door de parser halen
+};
+
+static WiFiClient weatherClient;
+static WeatherParser parser;
+static WeatherConfig weatherConfig = {15UL * 60UL * 1000UL, 60UL * 1000UL, 60UL * 60UL * 1000UL, 10000};
+static WeatherStats weatherStats = {0, 0, 0, 0, 0};
+static WeatherState weatherState = WEATHER_IDLE;
+
+static char weatherHost[64] = "";
+static char weatherPath[192] = "";
+static uint16_t weatherPort = 80;
+static bool weatherConfigured = false;
+
+static unsigned long nextFetchTime = 0;
+static unsigned long fetchStartTime = 0;
+static uint8_t failureStreak = 0;   // Mislukte pogingen op rij, voor het uitstellen
+static int connectFd = -1;          // Socket tot hij verbonden is; daarna van weatherClient
+
+// Antwoord van de resolver; geschreven vanuit de lwIP-taak
+static volatile uint32_t dnsGeneration = 0; // Oude antwoorden na een time-out negeren
+static volatile bool dnsDone = false;
+static volatile bool dnsResolved = false;
+static volatile uint32_t dnsAddress = 0;
+static char statusLine[32];
+static int lineLength = 0;
+
+// Cache; geschreven door de netwerktaak, gelezen door de regeltaak
+static volatile float cachedTemperature = 0.0;
+static volatile unsigned long cachedTime = 0;
+static volatile bool cacheValid = false;
+
+bool setupWeather(const char* url, const WeatherConfig& config) {
+    weatherConfig = config;
+    weatherConfigured = false;
+
+    const char* prefix = "http://";
+    if (strncmp(url, prefix, strlen(prefix)) != 0) {
+        logPrintf(LOG_ERROR, LOG_SYSTEM, "Weer: alleen http:// wordt ondersteund (%s)", url);
+        return false;
+    }
+
+    const char* host = url + strlen(prefix);
+    const char* slash = strchr(host, '/');
+    const char* path = slash != nullptr ? slash : "/";
+    size_t hostLength = slash != nullptr ? (size_t)(slash - host) : strlen(host);
+    const char* colon = (const char*)memchr(host, ':', hostLength);
+
+    weatherPort = 80;
+    if (colon != nullptr) {
+        weatherPort = (uint16_t)atoi(colon + 1);
+        hostLength = colon - host;
+    }
+    if (hostLength == 0 || hostLength >= sizeof(weatherHost) || strlen(path) >= sizeof(weatherPath)) {
+        logPrintf(LOG_ERROR, LOG_SYSTEM, "Weer: ongeldig adres %s", url);
+        return false;
+    }
+
+    memcpy(weatherHost, host, hostLength);
+    weatherHost[hostLength] = '\0';
+    strcpy(weatherPath, path);
+    weatherConfigured = true;
+    weatherState = WEATHER_IDLE;
+    nextFetchTime = millis();
+    return true;
+}
+
+static void finishFetch(bool success) {
+    weatherClient.stop();
+    if (connectFd >= 0) {
+        close(connectFd);
+        connectFd = -1;
+    }
+    dnsGeneration++;
+    weatherState = WEATHER_IDLE;
+
+    unsigned long now = millis();
+    weatherStats.lastDurationMs = now - fetchStartTime;
+
+    if (success) {
+        cachedTemperature = parser.getValue();
+        __sync_synchronize(); // Waarde zichtbaar voor de regeltaak voordat het tijdstip dat is
+        cachedTime = now;
+        cacheValid = true;
+        weatherStats.fetches++;
+        nextFetchTime = now + weatherConfig.intervalMs;
+        failureStreak = 0;
+        logPrintf(LOG_DEBUG, LOG_SYSTEM, "Weer: %.1f °C opgehaald in %lu ms", parser.getValue(), (unsigned long)weatherStats.lastDurationMs);
+    } else {
+        // Steeds twee keer zo lang wachten, tot hooguit het gewone interval; alleen de eerste keer waarschuwen
+        unsigned long retry = weatherConfig.retryMs;
+        for (uint8_t i = 0; i < failureStreak && retry < weatherConfig.intervalMs; i++) retry *= 2;
+        if (retry > weatherConfig.intervalMs) retry = max(weatherConfig.intervalMs, weatherConfig.retryMs);
+        weatherStats.failures++;
+        nextFetchTime = now + retry;
+        logPrintf(failureStreak == 0 ? LOG_WARN : LOG_DEBUG, LOG_SYSTEM, "Weer ophalen mislukt (status %d), over %lu s opnieuw",
+                  weatherStats.lastStatus, retry / 1000UL);
+        if (failureStreak < 255) failureStreak++;
+    }
+}
+
+// HTTP/1.0: geen chunked encoding, de server sluit na de body. Zonder printf, dat op de ESP32 de heap gebruikt.
+static void sendRequest() {
+    weatherClient.write("GET ");
+    weatherClient.write(weatherPath);
+    weatherClient.write(" HTTP/1.0\r\nHost: ");
+    weatherClient.write(weatherHost);
+    weatherClient.write("\r\nAccept: application/json\r\nConnection: close\r\n\r\n");
+    weatherState = WEATHER_STATUS;
+}
+
+// Socket zonder blokkeren laten verbinden; loopWeather() kijkt elke tick of het gelukt is
+static void startConnect(uint32_t address) {
+    connectFd = tcpConnectStart(address, weatherPort);
+    if (connectFd < 0) {
+        finishFetch(false);
+        return;
+    }
+    weatherState = WEATHER_CONNECTING;
+}
+
+static void dnsFound(const char* name, const ip_addr_t* address, void* argument) {
+    (void)name;
+    if ((uint32_t)(uintptr_t)argument != dnsGeneration) return; // Poging al opgegeven
+    dnsResolved = address != nullptr;
+    if (address != nullptr) dnsAddress = ip_addr_get_ip4_u32(address);
+    __sync_synchronize();
+    dnsDone = true;
+}
+
+static void startFetch() {
+    fetchStartTime = millis();
+    weatherStats.lastStatus = 0;
+    weatherStats.lastBodyBytes = 0;
+    parser.begin();
+    lineLength = 0;
+
+    // Opzoeken via de resolver van lwIP; het antwoord komt direct uit de cache of later via dnsFound()
+    dnsDone = false;
+    ip_addr_t address;
+#if CONFIG_LWIP_TCPIP_CORE_LOCKING
+    LOCK_TCPIP_CORE();
+#endif
+    err_t result = dns_gethostbyname(weatherHost, &address, dnsFound, (void*)(uintptr_t)dnsGeneration);
+#if CONFIG_LWIP_TCPIP_CORE_LOCKING
+    UNLOCK_TCPIP_CORE();
+#endif
+    if (result == ERR_OK) {
+        startConnect(ip_addr_get_ip4_u32(&address));
+    } else if (result == ERR_INPROGRESS) {
+        weatherState = WEATHER_RESOLVING;
+    } else {
+        finishFetch(false);
+    }
+}
+
+// Verbinden afronden zodra de socket verbonden is; geeft false zolang hij nog bezig is
+static bool pollConnect() {
+    TcpConnectStatus status = tcpConnectPoll(connectFd);
+    if (status == TCP_CONNECT_PENDING) return false;
+    if (status == TCP_CONNECT_FAILED) {
+        finishFetch(false);
+        return true;
+    }
+    weatherClient = WiFiClient(connectFd);
+    connectFd = -1;
+    sendRequest();
+    return true;
+}
+
+// Eén teken van de statusregel of een header; geeft true aan het einde van de regel
+static bool readLine(char c) {
+    if (c == '\n') return true;
+    if (c != '\r' && weatherState == WEATHER_STATUS && lineLength < (int)sizeof(statusLine) - 1) {
+        statusLine[lineLength] = c;
+    }
+    if (c != '\r') lineLength++;
+    return false;
+}
+
+static void feedResponse(char c) {
+    switch (weatherState) {
+        case WEATHER_STATUS:
+            if (readLine(c)) {
+                statusLine[min(lineLength, (int)sizeof(statusLine) - 1)] = '\0';
+                const char* space = strchr(statusLine, ' ');
+                weatherStats.lastStatus = space != nullptr ? atoi(space + 1) : 0;
+                lineLength = 0;
+                weatherState = WEATHER_HEADERS;
+            }
+            break;
+        case WEATHER_HEADERS:
+            if (readLine(c)) {
+                if (lineLength == 0) weatherState = WEATHER_BODY; // Lege regel: einde van de headers
+                lineLength = 0;
+            }
+            break;
+        case WEATHER_BODY:
+            weatherStats.lastBodyBytes++;
+            parser.feed(c);
+            break;
+        default:
+            break;
+    }
+}
+
+void loopWeather() {
+    if (!weatherConfigured) return;
+
+    unsigned long now = millis();
+    if (weatherState == WEATHER_IDLE) {
+        if (WiFi.status() == WL_CONNECTED && (long)(now - nextFetchTime) >= 0) {
+            startFetch();
+        }
+        return;
+    }
+
+    if (now - fetchStartTime >= weatherConfig.timeoutMs) {
+        finishFetch(false);
+        return;
+    }
+
+    if (weatherState == WEATHER_RESOLVING) {
+        if (!dnsDone) return;
+        __sync_synchronize();
+        if (dnsResolved) startConnect(dnsAddress);
+        else finishFetch(false);
+        return;
+    }
+    if (weatherState == WEATHER_CONNECTING && !pollConnect()) return;
+
+    uint8_t buffer[64];
+    int budget = WEATHER_BYTES_PER_TICK;
+    while (budget > 0 && weatherState != WEATHER_IDLE) {
+        int available = weatherClient.available();
+        if (available <= 0) break;
+        int length = weatherClient.read(buffer, min(available, min(budget, (int)sizeof(buffer))));
+        if (length <= 0) break;
+        budget -= length;
+        for (int i = 0; i < length; i++) feedResponse((char)buffer[i]);
+
+        // Rest van het antwoord is niet nodig
+        if (parser.hasValue()) {
+            finishFetch(weatherStats.lastStatus == 200);
+            return;
+        }
+    }
+
+    if (weatherState != WEATHER_IDLE && !weatherClient.connected() && weatherClient.available() <= 0) {
+        parser.end();
+        finishFetch(weatherStats.lastStatus == 200 && parser.hasValue());
+    }
+}
+
+bool getWeatherTemperature(float& temperature) {
+    if (!cacheValid) return false;
+    unsigned long fetched = cachedTime;
+    __sync_synchronize();
+    if (millis() - fetched >= weatherConfig.cacheTtlMs) return false;
+    temperature = cachedTemperature;
+    return true;
+}
+
+OutdoorSource selectOutdoorTemperature(const SensorSnapshot& probe, float& temperature) {
+    if (getWeatherTemperature(temperature)) return OUTDOOR_WEATHER;
+    if (probe.outdoorValid) {
+        temperature = probe.outdoorTemperature;
+        return OUTDOOR_PROBE;
+    }
+    return OUTDOOR_NONE;
+}
+
+WeatherStats getWeatherStats() {
+    return weatherStats;
+}
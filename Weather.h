@@ -0,0 +1,48 @@
+#ifndef WEATHER_H
+#define WEATHER_H
+
+#include <Arduino.h>
+#include "Sensors.h"
+
+// Buitentemperatuur van een weerdienst (open-meteo), opgehaald zonder de netwerktaak op te houden.
+// Het antwoord wordt byte voor byte doorzocht op current_weather.temperature; de JSON wordt nooit
+// in zijn geheel bewaard. Alleen http://, zodat er geen TLS-handshake nodig is.
+
+struct WeatherConfig {
+    unsigned long intervalMs;   // Tussen twee geslaagde ophaalacties
+    unsigned long retryMs;      // Na een mislukte ophaalactie; verdubbelt bij elke volgende, tot intervalMs
+    unsigned long cacheTtlMs;   // Zolang blijft een opgehaalde waarde bruikbaar
+    unsigned long timeoutMs;    // Maximale duur van één ophaalactie, inclusief verbinden
+};
+
+// Waar de buitentemperatuur voor de regeling vandaan komt
+enum OutdoorSource : uint8_t {
+    OUTDOOR_NONE,      // Geen bruikbare waarde
+    OUTDOOR_WEATHER,   // Weerdienst, uit de cache
+    OUTDOOR_PROBE      // Buitenvoeler op de 1-Wire-bus
+};
+
+struct WeatherStats {
+    uint32_t fetches;          // Geslaagde ophaalacties
+    uint32_t failures;         // Mislukte ophaalacties (verbinding, status, time-out, geen waarde)
+    int lastStatus;            // HTTP-status van de laatste poging, 0 = geen antwoord
+    uint32_t lastDurationMs;   // Duur van de laatste poging
+    uint32_t lastBodyBytes;    // Gelezen bytes van de laatste body
+};
+
+// Adres en instellingen vastleggen; het ophalen gebeurt in loopWeather(). Geeft false bij een onbruikbaar adres.
+bool setupWeather(const char* url, const WeatherConfig& config);
+
+// Ophaalactie starten of voortzetten. Alleen vanuit de netwerktaak; opzoeken, verbinden en lezen
+// blokkeren niet, elke stap kijkt alleen wat er al klaar is.
+void loopWeather();
+
+// Laatst opgehaalde temperatuur, zolang die niet verlopen is. Veilig vanuit de regeltaak.
+bool getWeatherTemperature(float& temperature);
+
+// Weerdienst als die een geldige waarde heeft, anders de buitenvoeler
+OutdoorSource selectOutdoorTemperature(const SensorSnapshot& probe, float& temperature);
+
+WeatherStats getWeatherStats();
+
+#endif // WEATHER_H
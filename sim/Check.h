@@ -0,0 +1,29 @@
+#ifndef SIM_CHECK_H
+#define SIM_CHECK_H
+
+#include <stdio.h>
+
+// Controles voor de hosttests: een mislukte controle meldt zich en telt mee, de test loopt door.
+// Eén testprogramma per bestand, dus de teller mag static in de header.
+
+static int failures = 0;
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            fprintf(stderr, "%s:%d: controle mislukt: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                           \
+        }                                                                         \
+    } while (0)
+
+// Slotregel en exitcode voor main()
+static inline int checkResult(const char* subject) {
+    if (failures > 0) {
+        fprintf(stderr, "%d controles mislukt\n", failures);
+        return 1;
+    }
+    printf("%s: alle controles geslaagd\n", subject);
+    return 0;
+}
+
+#endif // SIM_CHECK_H
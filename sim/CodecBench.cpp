@@ -0,0 +1,235 @@
+// Vergelijking van de payloadvormen van MQTT.cpp: bytes op de lijn per bericht, voor JSON en
+// MessagePack, met losse topics en met warmtepomp/state. Alle berichten gaan door
+// de echte publicatiecode naar de nagebootste broker. Elke MessagePack-payload moet dezelfde
+// waarden bevatten als zijn JSON-tegenhanger, en in totaal kleiner zijn; anders faalt de test.
+//
+// Er wordt bewust geen rekentijd gemeten: op de host serialiseert de shim van ArduinoJson, niet de
+// bibliotheek die op de ESP32 draait, dus een tijd zou niets over het apparaat zeggen. De bytes op de
+// lijn liggen vast door het formaat en gelden wel voor het apparaat.
+//
+//   codecbench [--iterations N]
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "SimHooks.h"
+#include "MQTT.h"
+#include "Spool.h"
+
+#include <map>
+#include <string>
+
+struct TopicTally {
+    uint32_t messages = 0;
+    uint64_t bytes = 0;
+};
+
+// Gevuld door de observer van de broker
+static bool capturing = false;
+static std::map<std::string, TopicTally> tallies;      // Per topic, met indexen samengevoegd
+static std::map<std::string, std::string> firstPayload; // Eerste payload per topic, voor de vergelijking
+
+static std::string topicKind(const char* topic) {
+    std::string kind;
+    for (const char* c = topic; *c; c++) {
+        if (*c >= '0' && *c <= '9') {
+            if (kind.empty() || kind.back() != '#') kind += '#';
+        } else {
+            kind += *c;
+        }
+    }
+    return kind;
+}
+
+static void observePublish(const char* topic, const uint8_t* payload, unsigned int length, bool retained) {
+    (void)retained;
+    if (!capturing) return;
+    TopicTally& tally = tallies[topicKind(topic)];
+    tally.messages++;
+    tally.bytes += length;
+    firstPayload.emplace(topic, std::string(reinterpret_cast<const char*>(payload), length));
+}
+
+static ControllerState makeState() {
+    ControllerState state;
+    memset(&state, 0, sizeof(state));
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        state.relayStatus[i] = i % 2 == 0;
+        state.lastOnTimes[i] = 86400000UL + i * 3600000UL;
+        state.lastOffTimes[i] = 86000000UL + i * 3500000UL;
+    }
+    for (int i = 0; i < PUMP_COUNT; i++) state.runtimeSeconds[i] = 1200000UL + i * 54321UL;
+    state.bufferTemperature = 41.37;
+    state.bufferValid = true;
+    state.outdoorTemperature = 6.5;
+    state.outdoorValid = true;
+    state.staging.demandPumps = 2;
+    state.staging.bufferSlope = -0.042;
+    state.staging.startsPerHour = 1.5;
+    state.staging.totalStarts = 1834;
+    state.staging.recoveries = 17;
+    state.staging.lastRecoveryMs = 2460000UL;
+    state.staging.maxRecoveryMs = 5400000UL;
+    state.wifiConnected = true;
+    state.mqttConnected = true;
+    return state;
+}
+
+struct RunResult {
+    uint32_t messages;
+    uint64_t bytes;
+    std::map<std::string, TopicTally> tallies;
+    std::map<std::string, std::string> payloads;
+};
+
+// Een volledige ronde per iteratie: alle toestandstopics, de heartbeat-telemetrie, draaitijden en een waarschuwing
+static RunResult run(PayloadCodec codec, bool snapshotMode, int iterations) {
+    PublishConfig config = {5UL * 60UL * 1000UL, 0.2, snapshotMode, {codec, codec, codec}, 0};
+    ControllerState state = makeState();
+
+    tallies.clear();
+    firstPayload.clear();
+    SimBrokerStats before = simGetBrokerStats();
+    capturing = true;
+
+    for (int n = 0; n < iterations; n++) {
+        configurePublishing(config); // Dwingt een volledige publicatie af
+        publishChanges(state);
+        for (int i = 0; i < PUMP_COUNT; i++) sendRuntimeToMQTT(i, state.runtimeSeconds[i]);
+        publishWarning(WARNING_BUFFER_TEMPERATURE);
+
+        state.bufferTemperature += 0.01;
+        for (int i = 0; i < PUMP_COUNT; i++) state.runtimeSeconds[i] += 10;
+    }
+
+    capturing = false;
+    SimBrokerStats after = simGetBrokerStats();
+
+    RunResult result;
+    result.messages = after.publishes - before.publishes;
+    result.bytes = after.bytes - before.bytes;
+    result.tallies = tallies;
+    result.payloads = firstPayload;
+    return result;
+}
+
+// Zelfde waarden in beide vormen; getallen met de afronding van float32
+static bool sameValue(const JsonNode* a, const JsonNode* b) {
+    auto numeric = [](const JsonNode* n) {
+        return n->type == JsonNode::Signed || n->type == JsonNode::Unsigned || n->type == JsonNode::Real;
+    };
+    auto number = [](const JsonNode* n) {
+        if (n->type == JsonNode::Signed) return (double)n->sint;
+        if (n->type == JsonNode::Unsigned) return (double)n->uint;
+        return n->real;
+    };
+
+    if (numeric(a) && numeric(b)) {
+        double x = number(a);
+        double y = number(b);
+        return fabs(x - y) <= 1e-6 * std::max(1.0, fabs(x));
+    }
+    if (a->type != b->type) return false;
+    switch (a->type) {
+        case JsonNode::Boolean:
+            return a->boolean == b->boolean;
+        case JsonNode::Text:
+            return a->text == b->text;
+        case JsonNode::Array:
+        case JsonNode::Object:
+            if (a->items.size() != b->items.size() || a->keys != b->keys) return false;
+            for (size_t i = 0; i < a->items.size(); i++) {
+                if (!sameValue(a->items[i], b->items[i])) return false;
+            }
+            return true;
+        default:
+            return true;
+    }
+}
+
+static int comparePayloads(const RunResult& json, const RunResult& packed) {
+    int mismatches = 0;
+    for (const auto& entry : json.payloads) {
+        auto other = packed.payloads.find(entry.first);
+        if (other == packed.payloads.end()) {
+            fprintf(stderr, "%s: geen MessagePack-bericht\n", entry.first.c_str());
+            mismatches++;
+            continue;
+        }
+
+        DynamicJsonDocument fromJson(1024);
+        DynamicJsonDocument fromPacked(1024);
+        DeserializationError jsonError = deserializeJson(fromJson, entry.second.data(), entry.second.size());
+        DeserializationError packedError = deserializeMsgPack(fromPacked, other->second.data(), other->second.size());
+        if (jsonError || packedError || !sameValue(fromJson.root().getNode(), fromPacked.root().getNode())) {
+            fprintf(stderr, "%s: MessagePack wijkt af van JSON (%s / %s)\n", entry.first.c_str(), jsonError.c_str(), packedError.c_str());
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static void printComparison(const char* title, const RunResult& json, const RunResult& packed) {
+    printf("\n%s\n", title);
+    printf("  %-40s %12s %12s\n", "topic", "JSON B/msg", "MsgPack B/msg");
+    for (const auto& entry : json.tallies) {
+        const TopicTally& j = entry.second;
+        auto other = packed.tallies.find(entry.first);
+        double packedBytes = other != packed.tallies.end() && other->second.messages > 0
+                                 ? (double)other->second.bytes / other->second.messages : 0;
+        printf("  %-40s %12.1f %12.1f\n", entry.first.c_str(), (double)j.bytes / j.messages, packedBytes);
+    }
+    printf("  %-40s %12llu %12llu\n", "totaal bytes", (unsigned long long)json.bytes, (unsigned long long)packed.bytes);
+    printf("  %-40s %12u %12u\n", "berichten", json.messages, packed.messages);
+    if (json.bytes > 0) {
+        printf("  MessagePack: %.0f%% van de JSON-bytes\n", 100.0 * packed.bytes / json.bytes);
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = 2000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Onbekende optie: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (iterations < 1) iterations = 1;
+
+    setupSpool();
+    setupMQTT();
+    for (int i = 0; i < 10 && getMqttConnectionState() != MQTT_SUBSCRIBED; i++) {
+        loopMQTT();
+        simAdvanceMs(100);
+    }
+    if (getMqttConnectionState() != MQTT_SUBSCRIBED) {
+        fprintf(stderr, "Geen verbinding met de nagebootste broker\n");
+        return 1;
+    }
+    simSetPublishObserver(observePublish);
+
+    int failures = 0;
+    const bool shapes[] = {false, true};
+    for (bool snapshotMode : shapes) {
+        RunResult json = run(CODEC_JSON, snapshotMode, iterations);
+        RunResult packed = run(CODEC_MSGPACK, snapshotMode, iterations);
+        printComparison(snapshotMode ? "warmtepomp/state" : "Losse topics", json, packed);
+
+        failures += comparePayloads(json, packed);
+        if (packed.messages != json.messages) {
+            fprintf(stderr, "Aantal berichten verschilt: %u JSON, %u MessagePack\n", json.messages, packed.messages);
+            failures++;
+        }
+        if (packed.bytes >= json.bytes) {
+            fprintf(stderr, "MessagePack is niet kleiner dan JSON\n");
+            failures++;
+        }
+    }
+
+    if (failures > 0) {
+        fprintf(stderr, "%d controles mislukt\n", failures);
+        return 1;
+    }
+    return 0;
+}
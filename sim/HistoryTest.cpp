@@ -0,0 +1,116 @@
+// Test van History.cpp: gemiddelden en relaismaskers per laag, perioden zonder meting (HISTORY_GAP),
+// het doorschuiven van base als een ring vol is en het teruglezen na maanden draaien, in alle drie
+// de lagen. De waarden volgen het monsternummer, zodat elk teruggelezen monster te controleren is.
+//
+//   historytest
+
+#include <Arduino.h>
+#include "SimHooks.h"
+#include "Check.h"
+#include "History.h"
+#include "Scheduler.h"
+
+const uint16_t RAW_CAPACITY = 360;
+const uint16_t MINUTE_CAPACITY = 1440;
+const uint16_t QUARTER_CAPACITY = 2880;
+const uint32_t SAMPLES_PER_QUARTER = 90;
+
+static uint32_t recorded = 0; // Monsters sinds de start
+
+// Eén monster van 10 s; buffer in 0,01 °C
+static void record(int16_t buffer, bool valid, uint8_t relays = 0) {
+    simAdvanceMs(HISTORY_SAMPLE_INTERVAL);
+    ControllerState state{};
+    state.bufferTemperature = buffer / 100.0f;
+    state.bufferValid = valid;
+    state.outdoorTemperature = 5.0f;
+    state.outdoorValid = true;
+    for (int i = 0; i < RELAY_COUNT; i++) state.relayStatus[i] = relays & (1 << i);
+    recordHistory(state);
+    recorded++;
+}
+
+static uint64_t nowSeconds() {
+    return millis64() / 1000ULL;
+}
+
+// Hele bereik van één reeks teruglezen; geeft het aantal monsters
+static int readAll(HistorySeries series, uint64_t fromSeconds, int16_t* values, int maxCount, HistoryCursor& cursor) {
+    if (!findHistory(series, fromSeconds, nowSeconds(), cursor)) return 0;
+    int count = 0;
+    int16_t value;
+    while (count < maxCount && nextHistory(cursor, value)) values[count++] = value;
+    return count;
+}
+
+static int16_t values[QUARTER_CAPACITY];
+
+int main() {
+    HistoryCursor cursor;
+    CHECK(!findHistory(HISTORY_BUFFER, 0, 0, cursor)); // Nog niets
+
+    // Minuut 1: oplopend, relais 0 en 1 om en om; minuut 2: geen meting; minuut 3: half geldig
+    for (int i = 0; i < 6; i++) record(1000 + i, true, i % 2 ? 0x02 : 0x01);
+    for (int i = 0; i < 6; i++) record(0, false);
+    for (int i = 0; i < 3; i++) record(0, false);
+    for (int i = 0; i < 3; i++) record(2000 + 10 * i, true);
+
+    int count = readAll(HISTORY_BUFFER, 0, values, RAW_CAPACITY, cursor);
+    CHECK(count == 18 && cursor.tier == 0 && cursor.intervalSeconds == 10);
+    CHECK(values[0] == 1000 && values[5] == 1005);
+    CHECK(values[6] == HISTORY_GAP && values[14] == HISTORY_GAP);
+    CHECK(values[15] == 2000 && values[17] == 2020); // Verschil loopt door over de gaten heen
+
+    // Tot de ruwe laag rond is; het totaal komt uit op een heel kwartier
+    for (int i = 0; i < 432; i++) record(3000 + i, true);
+    CHECK(recorded % SAMPLES_PER_QUARTER == 0);
+    count = readAll(HISTORY_BUFFER, nowSeconds() - 3590, values, RAW_CAPACITY + 1, cursor);
+    CHECK(count == RAW_CAPACITY && cursor.tier == 0);
+    bool rawMatches = true;
+    for (int i = 0; i < count; i++) rawMatches &= values[i] == 3000 + 72 + i; // base is meegeschoven
+    CHECK(rawMatches);
+
+    // Minutenlaag: gemiddelde, gat en relaismasker van de eerste drie minuten
+    count = readAll(HISTORY_BUFFER, 0, values, MINUTE_CAPACITY, cursor);
+    CHECK(cursor.tier == 1 && cursor.intervalSeconds == 60);
+    CHECK(count == (int)(recorded / 6));
+    CHECK(values[0] == 1003);          // (1000 + ... + 1005) / 6, afgerond
+    CHECK(values[1] == HISTORY_GAP);   // Hele minuut zonder meting
+    CHECK(values[2] == 2010);          // Alleen de geldige monsters
+    CHECK(values[3] == 3003);
+    HistoryCursor relays;
+    CHECK(readAll(HISTORY_RELAYS, 0, values, MINUTE_CAPACITY, relays) == count && relays.tier == 1);
+    CHECK(values[0] == 0x03 && values[1] == 0);
+
+    // Ruim een maand met een waarde per kwartier: minuten- en kwartierlaag lopen allebei rond
+    uint64_t phaseStart = nowSeconds();
+    const uint32_t days = 31;
+    for (uint32_t n = 0; n < days * 8640; n++) record(4000 + (n / SAMPLES_PER_QUARTER) % 1000, true);
+    auto expected = [&](uint64_t seconds) {
+        uint32_t n = (uint32_t)((seconds - phaseStart) / 10) - 1; // Laatste ruwe monster in de periode
+        return (int16_t)(4000 + (n / SAMPLES_PER_QUARTER) % 1000);
+    };
+
+    count = readAll(HISTORY_BUFFER, nowSeconds() - 23 * 3600, values, MINUTE_CAPACITY, cursor);
+    CHECK(cursor.tier == 1 && count == 23 * 60 + 1);
+    bool minutesMatch = true;
+    for (int i = 0; i < count; i++) minutesMatch &= values[i] == expected(cursor.firstSeconds + (uint64_t)i * 60);
+    CHECK(minutesMatch);
+
+    count = readAll(HISTORY_BUFFER, 0, values, QUARTER_CAPACITY, cursor);
+    CHECK(cursor.tier == 2 && count == QUARTER_CAPACITY);
+    CHECK(cursor.firstSeconds == nowSeconds() - (uint64_t)(QUARTER_CAPACITY - 1) * 900);
+    bool quartersMatch = true;
+    for (int i = 0; i < count; i++) quartersMatch &= values[i] == expected(cursor.firstSeconds + (uint64_t)i * 900);
+    CHECK(quartersMatch);
+
+    // Bereik binnen de kwartierlaag; een monster precies op begin of einde hoort erbij
+    uint64_t from = nowSeconds() - 10 * 86400;
+    int16_t value;
+    CHECK(findHistory(HISTORY_BUFFER, from, from + 3600, cursor));
+    CHECK(cursor.tier == 2 && historyRemaining(cursor) == 5);
+    CHECK(cursor.firstSeconds >= from && cursor.firstSeconds < from + 900);
+    CHECK(nextHistory(cursor, value) && value == expected(cursor.firstSeconds));
+
+    return checkResult("Historie");
+}
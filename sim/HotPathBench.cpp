@@ -0,0 +1,359 @@
+// Benchmarks van de hete paden van de firmware: loggen, de hoofdpagina van de portal, de
+// JSON-opbouw voor relais en buffertemperatuur, het inlezen van de draaitijd uit een pompbericht
+// en de pompregeling. Per pad de tijd en het aantal heapallocaties per aanroep.
+//
+// Hosttijden zeggen niets over de ESP32 en verschillen per machine; daarom wordt de tijd gedeeld
+// door die van een vaste referentie (snprintf van een logregel) uit dezelfde run. Die verhouding
+// en de allocaties per aanroep staan in bench_baseline.txt. De test faalt als een pad meer dan
+// --tolerance keer zo traag wordt, of vaker alloceert dan de basislijn.
+//
+// Allocaties worden geteld op malloc, calloc en realloc van glibc, dus ook die van String en
+// strdup en niet alleen die via operator new. Voor de paden zonder ArduinoJson draait hier dezelfde
+// code als op de ESP32 en is het aantal ook dat van het apparaat. De JSON-paden lopen door de shim
+// van ArduinoJson, die zelf alloceert; de echte bibliotheek met StaticJsonDocument doet dat niet.
+// Voor die paden (shim in de tabel) staan de allocaties alleen ter informatie en worden ze niet met
+// de basislijn vergeleken; ze hangen ook af van PUMP_COUNT. render loopt door de nagebootste
+// WebServer, die voor GET / zelf niets alloceert.
+//
+//   hotpathbench [--iterations N] [--baseline bestand] [--update-baseline] [--tolerance F]
+
+#include <Arduino.h>
+#include <WebServer.h>
+#include "SimHooks.h"
+#include "Debug.h"
+#include "MQTT.h"
+#include "Portal.h"
+#include "PumpMaster.h"
+#include "ControllerState.h"
+#include "Spool.h"
+
+#include <chrono>
+#include <map>
+#include <string>
+
+// Wat de sketch anders definieert
+WebServer server(80);
+
+// Allocaties tellen zolang counting aan staat; operator new van libstdc++ komt ook hier langs
+static bool counting = false;
+static uint64_t allocations = 0;
+static uint64_t allocatedBytes = 0;
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(size_t size) {
+    if (counting) {
+        allocations++;
+        allocatedBytes += size;
+    }
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    if (counting) {
+        allocations++;
+        allocatedBytes += count * size;
+    }
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+    if (counting) {
+        allocations++;
+        allocatedBytes += size;
+    }
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) {
+    __libc_free(pointer);
+}
+}
+
+static uint64_t responseBytes = 0;
+
+static void observeResponse(const char* data, size_t length) {
+    (void)data;
+    responseBytes += length;
+}
+
+static PumpMaster pumpMaster;
+
+// Referentie: één logregel opmaken, zonder de ringbuffer
+static void runReference(int i) {
+    static char line[LOG_MESSAGE_LENGTH];
+    static volatile char sink;
+    snprintf(line, sizeof(line), "Pomp %d aan, buffer %.2f C, draaitijd %lu s", i % PUMP_COUNT, 40.0 + (i % 100) * 0.01,
+             (unsigned long)i * 7);
+    sink = line[i % 16];
+}
+
+// Aanhoudend loggen: de ringbuffer loopt steeds rond
+static void runLog(int i) {
+    logPrintf(LOG_INFO, LOG_PUMPS, "Pomp %d aan, buffer %.2f C, draaitijd %lu s", i % PUMP_COUNT, 40.0 + (i % 100) * 0.01,
+              (unsigned long)i * 7);
+}
+
+// Hoofdpagina met een volle logbuffer en verbonden MQTT
+static void runRender(int i) {
+    (void)i;
+    simHttpRequest("GET", "/");
+}
+
+static void runRelayStatus(int i) {
+    static bool status[RELAY_COUNT];
+    static unsigned long lastOn[RELAY_COUNT];
+    static unsigned long lastOff[RELAY_COUNT];
+    for (int r = 0; r < RELAY_COUNT; r++) {
+        status[r] = (i + r) % 2 == 0;
+        lastOn[r] = 86400000UL + i + r * 3600000UL;
+        lastOff[r] = 86000000UL + i + r * 3500000UL;
+    }
+    publishRelaisStatus(status, lastOn, lastOff, RELAY_COUNT);
+}
+
+static void runBufferTemperature(int i) {
+    publishBufferTemperature(40.0 + (i % 100) * 0.01);
+}
+
+// Zoals de pompen hun status melden; alleen run_time wordt gebruikt
+static void runRuntimeParse(int i) {
+    char topic[32];
+    char payload[128];
+    int pump = i % PUMP_COUNT;
+    snprintf(topic, sizeof(topic), "warmtepomp/pump/%d/status", pump);
+    int length = snprintf(payload, sizeof(payload), "{\"state\":\"on\",\"run_time\":%lu,\"power\":%.1f,\"flow\":%.2f}",
+                          1200000UL + (unsigned long)i, 2.4 + pump * 0.1, 0.85);
+    mqttCallback(topic, reinterpret_cast<byte*>(payload), length);
+}
+
+// Eén regelstap per virtuele seconde, met een buffertemperatuur die door de band heen zakt en stijgt
+static void runPumps(int i) {
+    simAdvanceMs(1000);
+    float temperature = 45.0 + 6.0 * sinf(i * 0.01);
+    pumpMaster.update(temperature, 45.0, true, 5.0);
+}
+
+struct BenchCase {
+    const char* name;
+    void (*run)(int i);
+    int weight;   // Iteraties in verhouding tot --iterations; dure paden minder vaak
+    bool shim;    // Loopt door de shim van ArduinoJson; allocaties niet vergelijken
+};
+
+static const BenchCase cases[] = {
+    {"referentie", runReference, 10, false},
+    {"log", runLog, 10, false},
+    {"render", runRender, 1, false},
+    {"relay_status", runRelayStatus, 2, true},
+    {"buffer_temperature", runBufferTemperature, 10, true},
+    {"runtime_parse", runRuntimeParse, 10, true},
+    {"pumps", runPumps, 100, false},
+};
+static const int caseCount = sizeof(cases) / sizeof(cases[0]);
+const int ROUNDS = 5; // Snelste ronde telt; de rest is ruis van de host
+
+struct BenchResult {
+    double nsPerCall;
+    double relative;
+    double allocationsPerCall;
+    double bytesPerCall;
+};
+
+static BenchResult measure(const BenchCase& bench, int iterations) {
+    int calls = iterations * bench.weight;
+    double best = 0;
+    allocations = 0;
+    allocatedBytes = 0;
+
+    for (int round = 0; round < ROUNDS; round++) {
+        counting = true;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; i++) bench.run(round * calls + i);
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        counting = false;
+        if (round == 0 || elapsed < best) best = elapsed;
+    }
+
+    BenchResult result;
+    result.nsPerCall = best / calls;
+    result.relative = 0;
+    result.allocationsPerCall = (double)allocations / ((double)calls * ROUNDS);
+    result.bytesPerCall = (double)allocatedBytes / ((double)calls * ROUNDS);
+    return result;
+}
+
+struct Baseline {
+    double relative;
+    double allocationsPerCall;
+};
+
+// Regels "naam verhouding allocaties"; # begint commentaar
+static bool readBaseline(const char* path, std::map<std::string, Baseline>& baseline) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) return false;
+    char line[160];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        if (line[0] == '#') continue;
+        char name[64];
+        Baseline entry;
+        if (sscanf(line, "%63s %lf %lf", name, &entry.relative, &entry.allocationsPerCall) == 3) {
+            baseline[name] = entry;
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static bool writeBaseline(const char* path, const std::map<std::string, BenchResult>& results) {
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) return false;
+    fprintf(file, "# Basislijn van hotpathbench: tijd per aanroep gedeeld door die van de referentie,\n");
+    fprintf(file, "# en heapallocaties per aanroep. Bijwerken met hotpathbench --update-baseline.\n");
+    fprintf(file, "# Allocaties van de JSON-paden komen van de shim en worden niet vergeleken; op de ESP32 zijn ze 0.\n");
+    fprintf(file, "# naam verhouding allocaties\n");
+    for (int c = 0; c < caseCount; c++) {
+        auto found = results.find(cases[c].name);
+        if (found == results.end() || c == 0) continue;
+        fprintf(file, "%s %.3f %.2f\n", cases[c].name, found->second.relative, found->second.allocationsPerCall);
+    }
+    fclose(file);
+    return true;
+}
+
+static bool connectBroker() {
+    setupSpool();
+    setupMQTT();
+    for (int i = 0; i < 10 && getMqttConnectionState() != MQTT_SUBSCRIBED; i++) {
+        loopMQTT();
+        simAdvanceMs(100);
+    }
+    return getMqttConnectionState() == MQTT_SUBSCRIBED;
+}
+
+static void fillState() {
+    ControllerState state;
+    memset(&state, 0, sizeof(state));
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        state.relayStatus[i] = i % 2 == 0;
+        state.lastOnTimes[i] = 1704100000UL + i * 3600UL;
+        state.lastOffTimes[i] = 1704090000UL + i * 3500UL;
+    }
+    for (int i = 0; i < PUMP_COUNT; i++) state.runtimeSeconds[i] = 1200000UL + i * 54321UL;
+    state.bufferTemperature = 41.37;
+    state.bufferValid = true;
+    state.outdoorTemperature = 6.5;
+    state.outdoorValid = true;
+    state.wifiConnected = true;
+    state.mqttConnected = true;
+    setControllerState(state);
+}
+
+int main(int argc, char** argv) {
+    int iterations = 1000;
+    const char* baselinePath = nullptr;
+    bool updateBaseline = false;
+    double tolerance = 2.0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--update-baseline") == 0) {
+            updateBaseline = true;
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Onbekende optie: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (iterations < 1) iterations = 1;
+
+    if (!connectBroker()) {
+        fprintf(stderr, "Geen verbinding met de nagebootste broker\n");
+        return 1;
+    }
+    pumpMaster.begin();
+    rebootReason = "Power-on Reset";
+    // Vaste tijdzone, zoals configTime() die op het apparaat zet; zonder TZ kopieert glibc bij elke
+    // localtime() de naam van de zone en telt dat als allocatie van de portal
+    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    tzset();
+    setupPortal("verwarming");
+    simSetHttpObserver(observeResponse);
+    fillState();
+    for (int i = 0; i < LOG_RECORD_COUNT; i++) runLog(i); // Volle logbuffer voor de pagina
+
+    responseBytes = 0;
+    if (simHttpRequest("GET", "/") != 200 || responseBytes == 0) {
+        fprintf(stderr, "Hoofdpagina niet weergegeven\n");
+        return 1;
+    }
+    printf("Hoofdpagina: %llu bytes\n\n", (unsigned long long)responseBytes);
+
+    // De referentie aan het begin en aan het eind meten; de eerste meting loopt vaak nog koud
+    std::map<std::string, BenchResult> results;
+    for (int c = 0; c < caseCount; c++) {
+        results[cases[c].name] = measure(cases[c], iterations);
+    }
+    BenchResult& reference = results[cases[0].name];
+    reference.nsPerCall = std::min(reference.nsPerCall, measure(cases[0], iterations).nsPerCall);
+
+    printf("%-20s %12s %10s %12s %12s\n", "pad", "ns/aanroep", "verhouding", "allocaties", "bytes");
+    for (int c = 0; c < caseCount; c++) {
+        BenchResult& result = results[cases[c].name];
+        result.relative = result.nsPerCall / reference.nsPerCall;
+        printf("%-20s %12.0f %10.2f %12.2f %12.1f%s\n", cases[c].name, result.nsPerCall, result.relative,
+               result.allocationsPerCall, result.bytesPerCall, cases[c].shim ? "  shim" : "");
+    }
+
+    if (baselinePath == nullptr) return 0;
+    if (updateBaseline) {
+        if (!writeBaseline(baselinePath, results)) {
+            fprintf(stderr, "Kan %s niet schrijven\n", baselinePath);
+            return 1;
+        }
+        printf("\nBasislijn bijgewerkt: %s\n", baselinePath);
+        return 0;
+    }
+
+    std::map<std::string, Baseline> baseline;
+    if (!readBaseline(baselinePath, baseline)) {
+        fprintf(stderr, "Kan %s niet lezen\n", baselinePath);
+        return 1;
+    }
+
+    int regressions = 0;
+    printf("\n");
+    for (int c = 1; c < caseCount; c++) {
+        const char* name = cases[c].name;
+        auto found = baseline.find(name);
+        if (found == baseline.end()) {
+            printf("%s: geen basislijn\n", name);
+            continue;
+        }
+        const BenchResult& result = results[name];
+        if (result.relative > found->second.relative * tolerance) {
+            fprintf(stderr, "%s: %.2f keer de referentie, basislijn %.2f (grens %.2f)\n", name, result.relative,
+                    found->second.relative, found->second.relative * tolerance);
+            regressions++;
+        }
+        if (!cases[c].shim && result.allocationsPerCall > found->second.allocationsPerCall + 0.01) {
+            fprintf(stderr, "%s: %.2f allocaties per aanroep, basislijn %.2f\n", name, result.allocationsPerCall,
+                    found->second.allocationsPerCall);
+            regressions++;
+        }
+    }
+
+    if (regressions > 0) {
+        fprintf(stderr, "%d regressies ten opzichte van %s\n", regressions, baselinePath);
+        return 1;
+    }
+    printf("Binnen de basislijn (tolerantie %.1f keer)\n", tolerance);
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Test van Metrics.cpp: indeling in emmers, som en maximum, kwantielen en de heapgegevens.
+// De cyclusteller van de shim volgt de virtuele klok, dus een stap duurt precies zo lang
+// als de test de klok laat lopen.
+//
+//   metricstest
+
+#include <Arduino.h>
+#include "SimHooks.h"
+#include "Check.h"
+#include "Metrics.h"
+
+// Stap die us microseconden duurt
+static void runStage(MetricStage stage, uint32_t us) {
+    StageTimer timer(stage);
+    simAdvanceUs(us);
+}
+
+int main() {
+    setupMetrics();
+
+    // Grenzen van de emmers
+    CHECK(metricBucketBoundUs(0) == 1);
+    CHECK(metricBucketBoundUs(10) == 1024);
+    CHECK(metricBucketBoundUs(METRIC_BUCKETS - 1) == UINT32_MAX);
+
+    // Precies op een grens valt in die emmer, één erboven in de volgende
+    runStage(STAGE_SENSORS, 0);
+    runStage(STAGE_SENSORS, 1);
+    runStage(STAGE_SENSORS, 1024);
+    runStage(STAGE_SENSORS, 1025);
+    StageHistogram sensors = getStageHistogram(STAGE_SENSORS);
+    CHECK(sensors.count == 4);
+    CHECK(sensors.buckets[0] == 2);
+    CHECK(sensors.buckets[10] == 1);
+    CHECK(sensors.buckets[11] == 1);
+    CHECK(sensors.sumUs == 2050);
+    CHECK(sensors.maxUs == 1025);
+
+    // Erg lange stappen in de laatste emmer
+    runStage(STAGE_MQTT, 2000000);
+    StageHistogram mqtt = getStageHistogram(STAGE_MQTT);
+    CHECK(mqtt.buckets[METRIC_BUCKETS - 1] == 1);
+    CHECK(stageQuantileUs(mqtt, 0.95) == 2000000);
+
+    // Kwantielen: 95 korte stappen en 5 lange
+    for (int i = 0; i < 95; i++) runStage(STAGE_PUMPS, 100);
+    for (int i = 0; i < 5; i++) runStage(STAGE_PUMPS, 5000);
+    StageHistogram pumps = getStageHistogram(STAGE_PUMPS);
+    CHECK(stageQuantileUs(pumps, 0.5) == 128);
+    CHECK(stageQuantileUs(pumps, 0.95) == 128);
+    CHECK(stageQuantileUs(pumps, 0.96) == 5000); // Emmer tot 8192 µs, afgekapt op het maximum
+    CHECK(pumps.sumUs == 95 * 100 + 5 * 5000);
+
+    // Stappen zonder metingen blijven leeg; andere stappen lopen niet door elkaar
+    CHECK(getStageHistogram(STAGE_RENDER).count == 0);
+    CHECK(stageQuantileUs(getStageHistogram(STAGE_RENDER), 0.95) == 0);
+    CHECK(getStageHistogram(STAGE_MODE).count == 0);
+    CHECK(getStageHistogram(STAGE_COUNT).count == 0);
+    CHECK(strcmp(metricStageName(STAGE_PORTAL), "portal") == 0);
+
+    // Cyclusteller rondgewikkeld tijdens een stap: het verschil klopt nog
+    const uint64_t WRAP_US = (1ULL << 32) / 240;
+    CHECK(simNowUs() < WRAP_US - 10);
+    simAdvanceUs(WRAP_US - 10 - simNowUs());
+    runStage(STAGE_MODE, 50);
+    CHECK(getStageHistogram(STAGE_MODE).maxUs == 50);
+
+    // De portal meet in µs: een upload van een minuut past niet in de cyclusteller
+    runStage(STAGE_PORTAL, 60000000);
+    CHECK(getStageHistogram(STAGE_PORTAL).maxUs == 60000000);
+
+    // Heap: laagste punt blijft staan als de heap weer groeit
+    simSetHeap(150000, 90000);
+    simSetHeap(180000, 100000);
+    SystemMetrics system = getSystemMetrics();
+    CHECK(system.freeHeap == 180000);
+    CHECK(system.minFreeHeap == 150000);
+    CHECK(system.largestFreeBlock == 100000);
+
+    return checkResult("Metrics");
+}
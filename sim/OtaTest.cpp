@@ -0,0 +1,155 @@
+// Test van Ota.cpp tegen een nagebootste Update-backend: digest tijdens het schrijven, weigeren bij
+// een verkeerde of ontbrekende digest, schrijffouten, afgebroken uploads, doorvoer en vastzittijd,
+// en de bevestiging of terugval van nieuwe firmware na de gezondheidscontrole.
+//
+//   otatest
+
+#include <Arduino.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include "SimHooks.h"
+#include "Check.h"
+#include "Ota.h"
+
+#include <string>
+#include <vector>
+
+const size_t UPLOAD_CHUNK = 1436;   // HTTP_UPLOAD_BUFLEN van de WebServer
+const uint32_t WRITE_US_PER_KB = 2000;
+
+static std::string digestHex(const std::vector<uint8_t>& data) {
+    unsigned char digest[32];
+    mbedtls_sha256(data.data(), data.size(), digest, 0);
+    std::string hex;
+    char pair[3];
+    for (unsigned char byte : digest) {
+        snprintf(pair, sizeof(pair), "%02x", byte);
+        hex += pair;
+    }
+    return hex;
+}
+
+static std::vector<uint8_t> makeImage(size_t size) {
+    std::vector<uint8_t> image(size);
+    uint32_t seed = 12345;
+    for (uint8_t& byte : image) {
+        seed = seed * 1103515245 + 12345;
+        byte = seed >> 16;
+    }
+    return image;
+}
+
+// Upload zoals de WebServer hem aanlevert, in stukken van UPLOAD_CHUNK met wat netwerktijd ertussen
+static bool upload(const std::vector<uint8_t>& image, const std::string& digest) {
+    if (!otaBegin(digest.c_str())) return false;
+    for (size_t offset = 0; offset < image.size(); offset += UPLOAD_CHUNK) {
+        size_t length = std::min(UPLOAD_CHUNK, image.size() - offset);
+        otaWrite(image.data() + offset, length);
+        simAdvanceUs(1000);
+    }
+    return otaEnd();
+}
+
+int main() {
+    simSetUpdateWriteTimeUs(WRITE_US_PER_KB);
+
+    // Hash van de shim tegen de testvector uit FIPS 180-2
+    std::vector<uint8_t> abc = {'a', 'b', 'c'};
+    CHECK(digestHex(abc) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    std::vector<uint8_t> image = makeImage(300 * 1024 + 77);
+    std::string digest = digestHex(image);
+
+    // Goed image
+    CHECK(upload(image, digest));
+    OtaStats stats = getOtaStats();
+    CHECK(stats.state == OTA_SUCCEEDED);
+    CHECK(stats.bytesWritten == image.size());
+    CHECK(simUpdateActivated());
+    CHECK(stats.chunks == (image.size() + UPLOAD_CHUNK - 1) / UPLOAD_CHUNK);
+    CHECK(stats.stalledMs + 1 >= image.size() * WRITE_US_PER_KB / 1024 / 1000);
+    CHECK(stats.maxStallMs == UPLOAD_CHUNK * WRITE_US_PER_KB / 1024 / 1000);
+    CHECK(stats.bytesPerSecond > 0 && stats.bytesPerSecond < 1024 * 1024);
+    CHECK(strlen(getOtaError()) == 0);
+    printf("Upload van %u bytes: %u ms, %u B/s, %u ms vast in schrijven (langste %u ms)\n", (unsigned)stats.bytesWritten,
+           (unsigned)stats.durationMs, (unsigned)stats.bytesPerSecond, (unsigned)stats.stalledMs, (unsigned)stats.maxStallMs);
+
+    // Eén bit anders: niet activeren
+    uint32_t abortsBefore = simGetUpdateAborts();
+    std::vector<uint8_t> corrupt = image;
+    corrupt[12345] ^= 0x10;
+    CHECK(!upload(corrupt, digest));
+    CHECK(getOtaStats().state == OTA_FAILED);
+    CHECK(!simUpdateActivated());
+    CHECK(simGetUpdateAborts() == abortsBefore + 1);
+    CHECK(strstr(getOtaError(), "sha256") != nullptr);
+
+    // Geen of een onleesbare digest: er wordt niets geschreven
+    CHECK(!otaBegin(nullptr));
+    CHECK(!otaBegin(digest.substr(1).c_str()));
+    std::string bad = digest;
+    bad[10] = 'x';
+    CHECK(!otaBegin(bad.c_str()));
+    CHECK(!otaWrite(image.data(), UPLOAD_CHUNK));
+    CHECK(getOtaStats().state == OTA_FAILED);
+    CHECK(getOtaStats().bytesWritten == 0);
+
+    // Hoofdletters zijn ook goed
+    std::string upper = digest;
+    for (char& c : upper) c = toupper(c);
+    CHECK(upload(image, upper));
+
+    // Schrijffout halverwege: melding van de backend, rest genegeerd
+    simSetUpdateFailure(100 * 1024);
+    CHECK(!upload(image, digest));
+    stats = getOtaStats();
+    CHECK(stats.state == OTA_FAILED);
+    CHECK(stats.bytesWritten < 100 * 1024);
+    CHECK(strstr(getOtaError(), "Flash Write Failed") != nullptr);
+    CHECK(!simUpdateActivated());
+    simSetUpdateFailure(SIZE_MAX);
+
+    // Client haakt af
+    abortsBefore = simGetUpdateAborts();
+    CHECK(otaBegin(digest.c_str()));
+    CHECK(otaWrite(image.data(), UPLOAD_CHUNK));
+    otaAbort();
+    CHECK(getOtaStats().state == OTA_FAILED);
+    CHECK(simGetUpdateAborts() == abortsBefore + 1);
+    CHECK(!otaEnd());
+
+    // Firmware zonder update: geen bevestiging nodig, ook niet na lange tijd
+    simSetOtaImageState(ESP_OTA_IMG_VALID);
+    setupOta();
+    CHECK(!otaPendingVerify());
+    simAdvanceMs(OTA_HEALTH_TIMEOUT * 2);
+    loopOta(false);
+    CHECK(simGetRollbacks() == 0);
+
+    // Nieuwe firmware die gezond wordt: bevestigd
+    simSetOtaImageState(ESP_OTA_IMG_PENDING_VERIFY);
+    setupOta();
+    CHECK(otaPendingVerify());
+    simAdvanceMs(OTA_HEALTH_TIMEOUT / 2);
+    loopOta(false);
+    CHECK(otaPendingVerify());
+    loopOta(true);
+    CHECK(!otaPendingVerify());
+    CHECK(simGetOtaImageState() == ESP_OTA_IMG_VALID);
+    CHECK(simGetRollbacks() == 0);
+
+    // Nieuwe firmware die niet gezond wordt: terug naar de vorige
+    simSetOtaImageState(ESP_OTA_IMG_PENDING_VERIFY);
+    setupOta();
+    simAdvanceMs(OTA_HEALTH_TIMEOUT - 1);
+    loopOta(false);
+    CHECK(simGetRollbacks() == 0);
+    simAdvanceMs(1);
+    loopOta(false);
+    CHECK(simGetRollbacks() == 1);
+    CHECK(simGetOtaImageState() == ESP_OTA_IMG_INVALID);
+    loopOta(true); // Te laat; verandert niets meer
+    CHECK(simGetOtaImageState() == ESP_OTA_IMG_INVALID);
+
+    return checkResult("OTA");
+}
@@ -0,0 +1,112 @@
+// Test van Outputs.cpp tegen een nagebootst schuifregister: één latch per gewijzigd frame,
+// geen latch zonder verschil, schakelingen per kanaal en de vergrendeling tussen het koelrelais
+// en de pompen (eerst breken, dan maken, met de dode tijd aan beide kanten). De regeling zet de pompen
+// zelf uit zolang de omschakeling bezig is; de vergrendeling grijpt alleen in als vangnet.
+//
+//   outputstest
+
+#include <Arduino.h>
+#include "SimHooks.h"
+#include "Check.h"
+#include "Outputs.h"
+
+const uint8_t PUMP_MASK = 0x07;       // Kanalen 0-2
+const uint8_t COOLING_CHANNEL = 3;
+const uint8_t LED_CHANNEL = 6;
+const unsigned long DEAD_TIME = 30000;
+
+int main() {
+    simAdvanceMs(1000);
+    setupOutputs(7, 5, 6);
+    setOutputInterlock(COOLING_CHANNEL, PUMP_MASK, DEAD_TIME);
+
+    // Eerste commit schrijft altijd, ook een leeg frame, maar telt geen schakelingen
+    outputSet(LED_CHANNEL, true);
+    CHECK(simGetShiftRegisterLatches() == 0); // Zetten alleen schrijft nog niets
+    CHECK(outputCommit());
+    CHECK(simGetShiftRegisterLatches() == 1);
+    CHECK(simGetShiftRegisterOutputs() == (1 << LED_CHANNEL));
+    CHECK(getOutputStats().actuations[LED_CHANNEL] == 0);
+
+    // Meerdere kanalen tegelijk: één latch
+    outputSet(0, true);
+    outputSet(1, true);
+    outputSet(LED_CHANNEL, false);
+    CHECK(outputCommit());
+    CHECK(simGetShiftRegisterLatches() == 2);
+    CHECK(simGetShiftRegisterOutputs() == 0x03);
+
+    // Dezelfde bits opnieuw: geen latch
+    outputSet(0, true);
+    outputSet(1, true);
+    CHECK(!outputCommit());
+    CHECK(simGetShiftRegisterLatches() == 2);
+
+    OutputStats stats = getOutputStats();
+    CHECK(stats.actuations[0] == 1);
+    CHECK(stats.actuations[1] == 1);
+    CHECK(stats.actuations[2] == 0);
+    CHECK(stats.actuations[LED_CHANNEL] == 1);
+    CHECK(stats.latches == 2);
+    CHECK(stats.unchanged == 1);
+
+    // Koelen gevraagd met draaiende pompen: omschakeling bezig, de regeling zet de pompen zelf uit
+    // en het koelrelais blijft nog staan
+    simAdvanceMs(60000);
+    outputSet(COOLING_CHANNEL, true);
+    CHECK(outputChangeoverPending());
+    outputSet(0, false);
+    outputSet(1, false);
+    CHECK(outputCommit());
+    CHECK(simGetShiftRegisterOutputs() == 0x00);
+    CHECK(getOutputStats().interlockTrips == 0);
+
+    // Binnen de dode tijd gebeurt er niets
+    simAdvanceMs(DEAD_TIME - 1000);
+    CHECK(!outputCommit());
+    CHECK(simGetShiftRegisterOutputs() == 0x00);
+
+    // Daarna schakelt het koelrelais om; de pompen blijven nog uit
+    simAdvanceMs(2000);
+    CHECK(outputCommit());
+    CHECK(simGetShiftRegisterOutputs() == (1 << COOLING_CHANNEL));
+    CHECK(outputChangeoverPending());
+
+    // Vangnet: een pomp die binnen de dode tijd aan moet, houdt de vergrendeling tegen; één ingreep
+    outputSet(0, true);
+    CHECK(!outputCommit());
+    CHECK(!outputCommit());
+    CHECK(simGetShiftRegisterOutputs() == (1 << COOLING_CHANNEL));
+    CHECK(getOutputStats().interlockTrips == 1);
+    simAdvanceMs(DEAD_TIME - 1000);
+    CHECK(outputChangeoverPending());
+
+    // Na de dode tijd mogen de pompen weer
+    simAdvanceMs(2000);
+    CHECK(!outputChangeoverPending());
+    outputSet(1, true);
+    CHECK(outputCommit());
+    CHECK(simGetShiftRegisterOutputs() == ((1 << COOLING_CHANNEL) | 0x03));
+
+    stats = getOutputStats();
+    CHECK(stats.actuations[0] == 3); // Aan, uit door de regeling, weer aan
+    CHECK(stats.actuations[COOLING_CHANNEL] == 1);
+    CHECK(stats.interlockTrips == 1);
+
+    // Terug naar verwarmen met de pompen al uit en lang genoeg stil: direct omschakelen
+    outputSet(0, false);
+    outputSet(1, false);
+    CHECK(outputCommit());
+    simAdvanceMs(DEAD_TIME);
+    outputSet(COOLING_CHANNEL, false);
+    CHECK(outputCommit());
+    CHECK(simGetShiftRegisterOutputs() == 0x00);
+    CHECK(outputChangeoverPending()); // Dode tijd na het omschakelen
+    CHECK(getOutputStats().interlockTrips == 1);
+
+    // Kanalen buiten het frame worden genegeerd
+    outputSet(OUTPUT_CHANNELS, true);
+    CHECK(!outputCommit());
+
+    return checkResult("Uitgangen");
+}
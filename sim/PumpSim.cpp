@@ -0,0 +1,481 @@
+// Simulatie van de regelaar op de host: PumpMaster, Sensors en MQTT draaien ongewijzigd tegen de shims,
+// met een buffervat-model als installatie. Een jaar duurt zo enkele seconden in plaats van een jaar.
+//
+//   pumpsim [--days N] [--tank L] [--capacity kW] [--ua kW/K] [--outdoor-mean C] [--outdoor-profile bestand]
+//           [--tank-start C] [--sensor-noise LSB] [--trace bestand] [--verbose]
+//           [--max-starts-per-day N] [--max-recovery-min M] [--max-heating-outside-hours U]
+//
+// Met de --max-opties faalt de run als een pomp vaker start, een inhaalslag langer duurt of het vat
+// tijdens verwarmen langer buiten de band is. Met --sensor-noise ruisen de sensoren, zoals een echte
+// DS18B20 (±1 stap van 1/16 °C bij --sensor-noise 1); standaard is het model glad.
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "SimHooks.h"
+#include "ThermalModel.h"
+#include "PumpMaster.h"
+#include "Sensors.h"
+#include "MQTT.h"
+#include "Spool.h"
+#include "Scheduler.h"
+#include "Boot.h"
+#include "Weather.h"
+#include "History.h"
+#include "Trace.h"
+#include "Outputs.h"
+#include <LittleFS.h>
+
+// Zelfde grenzen als taskPumps() in de sketch
+const uint32_t MAX_SENSOR_AGE = 10000;
+const float HEATING_HYSTERESIS = 5.0;
+const float COOLING_TARGET = 14.0;
+const float COOLING_HYSTERESIS = 1.0;
+const unsigned long RUNTIME_PUBLISH_INTERVAL = 10UL * 60UL * 1000UL;
+const unsigned long CHANGEOVER_DEAD_TIME = 30000;
+
+// Modus volgt het gemiddelde van de laatste twee dagen, zoals de thuisautomatisering dat doet
+const float HEATING_BELOW = 14.0;
+const float COOLING_ABOVE = 18.0;
+const double MODE_AVERAGE_SECONDS = 2.0 * 86400.0;
+
+const int MONTHS = 12;
+
+// Alle taken lopen in stappen van 10 s in plaats van 1 s; het vat reageert in uren en PumpMaster
+// schakelt hooguit eens per half uur, dus dat scheelt een factor tien aan rekentijd zonder verschil
+const uint32_t STEP_MS = 10000;
+const uint32_t SENSOR_STEP_MS = 2500; // Conversie en uitlezen om en om: een meting per 5 s
+
+PumpMaster pumpMaster;
+Scheduler scheduler;
+ThermalModel* plant = nullptr;
+
+static bool heating = true;
+static float currentTarget = HEATING_TARGET_FALLBACK; // Laatste doel van taskPumps(), voor de band
+static bool requestedCooling = false;
+static bool changeoverPending = false;
+static double outdoorAverage = 10.0;
+
+// Resultaten
+struct MonthStats {
+    double outdoorSum;
+    uint32_t samples;
+    uint32_t starts;
+    double belowBandSeconds;
+    double aboveBandSeconds;
+};
+
+static uint32_t pumpStarts[PUMP_COUNT] = {0};
+static bool lastPumpStatus[PUMP_COUNT] = {false};
+static MonthStats months[MONTHS];
+static double belowBandSeconds = 0;
+static double aboveBandSeconds = 0;
+static double controlledSeconds = 0;
+static double heatingOutsideSeconds = 0; // Buiten de band tijdens verwarmen
+static float tankMin = 1000.0;
+static float tankMax = -1000.0;
+static float heatingOvershoot = 0.0; // Hoogste stand boven het doel tijdens verwarmen
+static float coolingOvershoot = 0.0; // Laagste stand onder het doel tijdens koelen
+static uint32_t modeChanges = 0;
+static ControllerState lastRecorded; // Laatst aan History gegeven toestand, voor de controle achteraf
+
+static double simSeconds() {
+    return simNowUs() / 1000000.0;
+}
+
+static int monthOf(double seconds) {
+    static const int monthStartDay[MONTHS] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+    int day = (int)(seconds / 86400.0) % 365;
+    int month = 0;
+    while (month + 1 < MONTHS && day >= monthStartDay[month + 1]) month++;
+    return month;
+}
+
+// Installatie: vat bijwerken en de sensoren op de nagebootste bus laten meten. Het vat ziet de relais, niet PumpMaster.
+void taskPlant() {
+    uint8_t frame = getOutputFrame();
+    bool pumpsOn[PUMP_COUNT];
+    for (int i = 0; i < PUMP_COUNT; i++) pumpsOn[i] = frame & (1 << pumpRelay(i));
+
+    double now = simSeconds();
+    double step = STEP_MS / 1000.0;
+    plant->step(step, now, pumpsOn, frame & (1 << COOLING_RELAY));
+
+    float outdoor = plant->outdoorTemperature(now);
+    float tank = plant->tankTemperature();
+    simSetSensorTemperature(0, tank);
+    simSetSensorTemperature(1, outdoor);
+    outdoorAverage += (outdoor - outdoorAverage) * step / MODE_AVERAGE_SECONDS;
+
+    // Tijd buiten de band van de hysterese
+    float target = currentTarget;
+    float hysteresis = heating ? HEATING_HYSTERESIS : COOLING_HYSTERESIS;
+    MonthStats& month = months[monthOf(now)];
+    month.outdoorSum += outdoor;
+    month.samples++;
+    controlledSeconds += step;
+    if (tank < target - hysteresis) {
+        belowBandSeconds += step;
+        month.belowBandSeconds += step;
+        if (heating) heatingOutsideSeconds += step;
+    } else if (tank > target + hysteresis) {
+        aboveBandSeconds += step;
+        month.aboveBandSeconds += step;
+        if (heating) heatingOutsideSeconds += step;
+    }
+    tankMin = min(tankMin, tank);
+    tankMax = max(tankMax, tank);
+    if (heating) heatingOvershoot = max(heatingOvershoot, tank - target);
+    else coolingOvershoot = max(coolingOvershoot, target - tank);
+}
+
+// Thuisautomatisering: modus via MQTT doorgeven als het gemiddelde de grens passeert
+void taskHomeAutomation() {
+    bool cooling = requestedCooling;
+    if (outdoorAverage > COOLING_ABOVE) cooling = true;
+    if (outdoorAverage < HEATING_BELOW) cooling = false;
+
+    static bool published = false;
+    if (!published || cooling != requestedCooling) {
+        simInjectMessage("warmtepomp/mode", cooling ? "Koelen" : "Verwarmen");
+        requestedCooling = cooling;
+        published = true;
+    }
+}
+
+void taskSensors() {
+    loopSensors();
+}
+
+static void setPumpRelays() {
+    for (int i = 0; i < PUMP_COUNT; i++) outputSet(pumpRelay(i), pumpMaster.getPumpStatus(i));
+}
+
+// Zoals taskMode() in de sketch
+void taskMode() {
+    HeatPumpMode mode = GetMode();
+    traceInputs(mode, getMqttConnectionState());
+    if (mode != MODE_NONE && heating != (mode == MODE_HEATING)) {
+        heating = (mode == MODE_HEATING);
+        modeChanges++;
+    }
+
+    outputSet(COOLING_RELAY, !heating);
+    changeoverPending = outputChangeoverPending();
+    if (changeoverPending) {
+        bool stopped = false;
+        for (int i = 0; i < PUMP_COUNT; i++) {
+            if (!pumpMaster.getPumpStatus(i)) continue;
+            traceForceOff(i);
+            pumpMaster.forcePumpOff(i);
+            stopped = true;
+        }
+        if (stopped) {
+            traceDecision();
+            setPumpRelays();
+        }
+    }
+}
+
+// Zoals taskPumps() in de sketch
+void taskPumps() {
+    const SensorSnapshot& snapshot = getSensorSnapshot();
+    if (!changeoverPending && bufferTemperatureFresh(MAX_SENSOR_AGE) && snapshot.bufferTemperature > 0.0) {
+        // Geen weerdienst in de simulatie: de buitenvoeler is de bron
+        float outdoor;
+        bool outdoorKnown = selectOutdoorTemperature(snapshot, outdoor) != OUTDOOR_NONE;
+        float target = COOLING_TARGET;
+        if (heating) target = outdoorKnown ? heatingCurveTarget(outdoor) : HEATING_TARGET_FALLBACK;
+        float hysteresis = heating ? HEATING_HYSTERESIS : COOLING_HYSTERESIS;
+        float load = heating && outdoorKnown ? expectedLoadPumps(outdoor) : 0.0;
+        traceLoad(load);
+        pumpMaster.setExpectedLoad(load);
+        traceStep(snapshot.bufferTemperature, target, heating, hysteresis);
+        pumpMaster.update(snapshot.bufferTemperature, target, heating, hysteresis);
+        traceDecision();
+        currentTarget = target;
+    }
+
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        bool on = pumpMaster.getPumpStatus(i);
+        if (on && !lastPumpStatus[i]) {
+            pumpStarts[i]++;
+            months[monthOf(simSeconds())].starts++;
+        }
+        lastPumpStatus[i] = on;
+    }
+    setPumpRelays();
+}
+
+void taskOutputs() {
+    outputCommit();
+}
+
+void taskMqtt() {
+    loopMQTT();
+}
+
+// Zoals taskPublish() in de sketch
+void taskPublish() {
+    static unsigned long lastRuntimePublish = 0;
+
+    ControllerState state;
+    memset(&state, 0, sizeof(state));
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        state.relayStatus[pumpRelay(i)] = pumpMaster.getPumpStatus(i);
+        state.runtimeSeconds[i] = (unsigned long)(pumpMaster.getRuntime(i) / 1000ULL);
+    }
+    state.relayStatus[COOLING_RELAY] = !heating;
+    const SensorSnapshot& snapshot = getSensorSnapshot();
+    state.bufferTemperature = snapshot.bufferTemperature;
+    state.bufferValid = bufferTemperatureFresh(MAX_SENSOR_AGE);
+    state.outdoorTemperature = snapshot.outdoorTemperature;
+    state.outdoorValid = snapshot.outdoorValid;
+    state.cooling = !heating;
+    state.staging = pumpMaster.getStagingMetrics();
+    state.wifiConnected = true;
+    state.mqttConnected = getMqttConnectionState() == MQTT_SUBSCRIBED;
+    publishChanges(state);
+
+    // Eén monster per STEP_MS, gelijk aan HISTORY_SAMPLE_INTERVAL
+    recordHistory(state);
+    lastRecorded = state;
+
+    if (millis() - lastRuntimePublish >= RUNTIME_PUBLISH_INTERVAL) {
+        for (int i = 0; i < PUMP_COUNT; i++) {
+            sendRuntimeToMQTT(i, state.runtimeSeconds[i]);
+        }
+        lastRuntimePublish = millis();
+    }
+
+    publishLog();
+    replaySpool();
+}
+
+void taskTrace() {
+    flushTrace();
+}
+
+// Segmenten op volgorde in één bestand, zoals /api/trace ze levert
+static bool exportTrace(const char* path, double days) {
+    syncTrace();
+    FILE* out = fopen(path, "wb");
+    if (out == nullptr) return false;
+
+    uint32_t sequences[TRACE_SEGMENTS];
+    uint8_t count = listTraceSegments(sequences, TRACE_SEGMENTS);
+    size_t bytes = 0;
+    char segmentPath[24];
+    uint8_t buffer[512];
+    for (uint8_t i = 0; i < count; i++) {
+        traceSegmentPath(sequences[i], segmentPath, sizeof(segmentPath));
+        File file = LittleFS.open(segmentPath, "r");
+        size_t length;
+        while ((length = file.read(buffer, sizeof(buffer))) > 0) {
+            fwrite(buffer, 1, length, out);
+            bytes += length;
+        }
+        file.close();
+    }
+    fclose(out);
+
+    TraceStats stats = getTraceStats();
+    printf("Trace: %u segmenten, %u bytes (%.0f bytes per dag), %u stappen, %u records verloren, %u keer naar flash\n",
+           (unsigned)count, (unsigned)bytes, bytes / days, (unsigned)stats.steps, (unsigned)stats.dropped,
+           (unsigned)stats.pageWrites);
+    return stats.dropped == 0 && stats.writeErrors == 0;
+}
+
+// Laatste 24 uur uit History; geeft false als de nieuwste waarde niet terugkomt zoals vastgelegd
+static bool reportHistory() {
+    uint64_t now = millis64() / 1000ULL;
+    HistoryCursor cursor;
+    if (!findHistory(HISTORY_BUFFER, now > 86400 ? now - 86400 : 0, now, cursor)) return false;
+
+    int16_t value;
+    int16_t low = INT16_MAX;
+    int16_t high = INT16_MIN + 1;
+    uint32_t count = 0;
+    uint32_t gaps = 0;
+    while (nextHistory(cursor, value)) {
+        count++;
+        if (value == HISTORY_GAP) {
+            gaps++;
+            continue;
+        }
+        low = min(low, value);
+        high = max(high, value);
+    }
+    printf("Historie: laatste 24 uur %u monsters van %u s (%u zonder meting), buffer %.2f tot %.2f °C\n",
+           (unsigned)count, (unsigned)cursor.intervalSeconds, (unsigned)gaps, low / 100.0, high / 100.0);
+
+    // De ruwe laag geeft de laatst vastgelegde waarde exact terug
+    if (!findHistory(HISTORY_BUFFER, now - 60, now, cursor) || cursor.intervalSeconds != 10) return false;
+    int16_t newest = HISTORY_GAP;
+    while (nextHistory(cursor, value)) newest = value;
+    int16_t expected = lastRecorded.bufferValid ? (int16_t)lroundf(lastRecorded.bufferTemperature * 100.0) : HISTORY_GAP;
+    return newest == expected;
+}
+
+static void printReport(double days, double wallSeconds) {
+    printf("\nGesimuleerd: %.0f dagen in %.2f s\n\n", days, wallSeconds);
+
+    uint64_t totalRuntime = 0;
+    uint64_t minRuntime = UINT64_MAX;
+    uint64_t maxRuntime = 0;
+    printf("Pomp  Starts  Draaiuren  Starts/dag\n");
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        uint64_t runtime = pumpMaster.getRuntime(i);
+        totalRuntime += runtime;
+        minRuntime = min(minRuntime, runtime);
+        maxRuntime = max(maxRuntime, runtime);
+        printf("%4d  %6u  %9.1f  %10.2f\n", i + 1, (unsigned)pumpStarts[i], runtime / 3600000.0, pumpStarts[i] / days);
+    }
+
+    double meanRuntime = totalRuntime / (double)PUMP_COUNT;
+    double imbalance = meanRuntime > 0 ? (maxRuntime - minRuntime) / meanRuntime * 100.0 : 0.0;
+    printf("\nDraaitijdbalans: verschil max-min %.1f uur (%.1f%% van het gemiddelde)\n",
+           (maxRuntime - minRuntime) / 3600000.0, imbalance);
+    printf("Buiten de band: %.1f uur onder, %.1f uur boven (%.2f%% van de tijd)\n",
+           belowBandSeconds / 3600.0, aboveBandSeconds / 3600.0,
+           controlledSeconds > 0 ? (belowBandSeconds + aboveBandSeconds) / controlledSeconds * 100.0 : 0.0);
+    printf("Buiten de band tijdens verwarmen: %.1f uur\n", heatingOutsideSeconds / 3600.0);
+    printf("Buffervat: min %.1f °C, max %.1f °C\n", tankMin, tankMax);
+    printf("Doorschieten: verwarmen %.1f °C boven het doel, koelen %.1f °C onder het doel\n", heatingOvershoot, coolingOvershoot);
+    printf("Energie: pompen %.0f kWh, huis %.0f kWh\n", plant->pumpEnergyKwh(), plant->loadEnergyKwh());
+    printf("Moduswisselingen: %u; vergrendeling %u keer ingegrepen\n", (unsigned)modeChanges,
+           (unsigned)getOutputStats().interlockTrips);
+    StagingMetrics staging = pumpMaster.getStagingMetrics();
+    printf("Cascade: %.1f starts/uur in het laatste venster; %u inhaalslagen, laatste %lu min, langste %lu min\n",
+           staging.startsPerHour, (unsigned)staging.recoveries, staging.lastRecoveryMs / 60000UL, staging.maxRecoveryMs / 60000UL);
+
+    SimBrokerStats broker = simGetBrokerStats();
+    SpoolStats spool = getSpoolStats();
+    printf("MQTT: %u berichten, %llu bytes payload, %u verbindingen; spool %u geschreven\n",
+           (unsigned)broker.publishes, (unsigned long long)broker.bytes, (unsigned)broker.connects, (unsigned)spool.written);
+    printf("Draaitijden opgeslagen in flash: %u keer\n", (unsigned)EEPROM.commitCount());
+
+    printf("\nMaand  Buiten  Starts  Onder band (u)  Boven band (u)\n");
+    for (int m = 0; m < MONTHS; m++) {
+        if (months[m].samples == 0) continue;
+        printf("%5d  %6.1f  %6u  %14.1f  %14.1f\n", m + 1, months[m].outdoorSum / months[m].samples, (unsigned)months[m].starts,
+               months[m].belowBandSeconds / 3600.0, months[m].aboveBandSeconds / 3600.0);
+    }
+}
+
+int main(int argc, char** argv) {
+    ThermalConfig config;
+    double days = 365.0;
+    const char* profile = nullptr;
+    const char* tracePath = nullptr;
+    float tankStart = NAN;
+    int sensorNoise = 0;
+    // Grenzen voor de cascade; negatief = niet controleren
+    double maxStartsPerDay = -1.0;
+    double maxRecoveryMinutes = -1.0;
+    double maxHeatingOutsideHours = -1.0;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--days") == 0 && hasValue) days = atof(argv[++i]);
+        else if (strcmp(argv[i], "--tank") == 0 && hasValue) config.tankLiters = atof(argv[++i]);
+        else if (strcmp(argv[i], "--capacity") == 0 && hasValue) config.pumpCapacityKw = atof(argv[++i]);
+        else if (strcmp(argv[i], "--ua") == 0 && hasValue) config.houseLossKwPerK = atof(argv[++i]);
+        else if (strcmp(argv[i], "--outdoor-mean") == 0 && hasValue) config.outdoorMean = atof(argv[++i]);
+        else if (strcmp(argv[i], "--outdoor-profile") == 0 && hasValue) profile = argv[++i];
+        else if (strcmp(argv[i], "--tank-start") == 0 && hasValue) tankStart = atof(argv[++i]);
+        else if (strcmp(argv[i], "--sensor-noise") == 0 && hasValue) sensorNoise = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--trace") == 0 && hasValue) tracePath = argv[++i];
+        else if (strcmp(argv[i], "--max-starts-per-day") == 0 && hasValue) maxStartsPerDay = atof(argv[++i]);
+        else if (strcmp(argv[i], "--max-recovery-min") == 0 && hasValue) maxRecoveryMinutes = atof(argv[++i]);
+        else if (strcmp(argv[i], "--max-heating-outside-hours") == 0 && hasValue) maxHeatingOutsideHours = atof(argv[++i]);
+        else if (strcmp(argv[i], "--verbose") == 0) simSetSerialOutput(true);
+        else {
+            fprintf(stderr, "Onbekende optie: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    config.pumpCount = PUMP_COUNT;
+
+    ThermalModel model(config);
+    if (profile != nullptr && !model.loadOutdoorProfile(profile)) {
+        fprintf(stderr, "Buitenprofiel %s niet te lezen\n", profile);
+        return 2;
+    }
+    if (!isnan(tankStart)) model.setTankTemperature(tankStart); // Bijvoorbeeld een vat dat na een storing is afgekoeld
+    plant = &model;
+    simSetSensorNoise(0, sensorNoise > 0 ? sensorNoise : 0);
+    simSetSensorNoise(1, sensorNoise > 0 ? sensorNoise : 0);
+    simSetSensorTemperature(0, model.tankTemperature());
+    simSetSensorTemperature(1, model.outdoorTemperature(0));
+    outdoorAverage = model.outdoorTemperature(0);
+
+    // Zelfde volgorde als setup() in de sketch
+    bootStart();
+    setupOutputs(7, 5, 6);
+    uint8_t pumpMask = 0;
+    for (int i = 0; i < PUMP_COUNT; i++) pumpMask |= 1 << pumpRelay(i);
+    setOutputInterlock(COOLING_RELAY, pumpMask, CHANGEOVER_DEAD_TIME);
+    outputCommit();
+    setupSpool();
+    setupSensors(9, 0, 1);
+    pumpMaster.begin();
+    if (tracePath != nullptr) setupTrace(pumpMaster);
+    setupMQTT();
+
+    scheduler.addTask("plant", STEP_MS, taskPlant);
+    scheduler.addTask("automation", 60000, taskHomeAutomation);
+    scheduler.addTask("sensors", SENSOR_STEP_MS, taskSensors);
+    scheduler.addTask("mode", STEP_MS, taskMode, 100);
+    scheduler.addTask("pumps", STEP_MS, taskPumps, 200);
+    scheduler.addTask("outputs", STEP_MS, taskOutputs, 250);
+    scheduler.addTask("mqtt", STEP_MS, taskMqtt);
+    scheduler.addTask("publish", STEP_MS, taskPublish, 300);
+    scheduler.addTask("trace", STEP_MS, taskTrace, 400);
+
+    clock_t wallStart = clock();
+    uint64_t endMs = (uint64_t)(days * 86400000.0);
+    while (millis64() < endMs) {
+        scheduler.run();
+    }
+    double wallSeconds = (double)(clock() - wallStart) / CLOCKS_PER_SEC;
+
+    printReport(days, wallSeconds);
+    if (tracePath != nullptr && !exportTrace(tracePath, days)) {
+        fprintf(stderr, "Trace %s onvolledig\n", tracePath);
+        return 1;
+    }
+    if (!reportHistory()) {
+        fprintf(stderr, "History geeft de laatste buffertemperatuur niet terug\n");
+        return 1;
+    }
+
+    uint32_t totalStarts = 0;
+    for (int i = 0; i < PUMP_COUNT; i++) totalStarts += pumpStarts[i];
+    if (totalStarts == 0) {
+        fprintf(stderr, "Geen enkele pomp is gestart; regeling werkt niet\n");
+        return 1;
+    }
+
+    bool withinLimits = true;
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        if (maxStartsPerDay >= 0.0 && pumpStarts[i] / days > maxStartsPerDay) {
+            fprintf(stderr, "Pomp %d start %.2f keer per dag, meer dan %.2f\n", i + 1, pumpStarts[i] / days, maxStartsPerDay);
+            withinLimits = false;
+        }
+    }
+    if (getOutputStats().interlockTrips > 0) {
+        fprintf(stderr, "De vergrendeling moest pompen uithouden; het omschakelen ging buiten PumpMaster om\n");
+        withinLimits = false;
+    }
+    StagingMetrics staging = pumpMaster.getStagingMetrics();
+    if (maxRecoveryMinutes >= 0.0 && staging.maxRecoveryMs / 60000.0 > maxRecoveryMinutes) {
+        fprintf(stderr, "Langste inhaalslag %.0f min, meer dan %.0f min\n", staging.maxRecoveryMs / 60000.0, maxRecoveryMinutes);
+        withinLimits = false;
+    }
+    if (maxHeatingOutsideHours >= 0.0 && heatingOutsideSeconds / 3600.0 > maxHeatingOutsideHours) {
+        fprintf(stderr, "%.1f uur buiten de band tijdens verwarmen, meer dan %.1f uur\n", heatingOutsideSeconds / 3600.0,
+                maxHeatingOutsideHours);
+        withinLimits = false;
+    }
+    return withinLimits ? 0 : 1;
+}
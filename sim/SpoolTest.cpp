@@ -0,0 +1,55 @@
+// Test van Spool.cpp: records bewaren, blokken afspelen en na een nagebootste herstart verdergaan
+// vanaf de laatst opgeslagen leespositie, zodat alleen het onderbroken blok opnieuw verstuurd wordt.
+//
+//   spooltest
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "SimHooks.h"
+#include "Check.h"
+#include "Spool.h"
+
+const int RECORDS = 12;
+
+// Eén blok afspelen zoals replaySpool(); geeft de index van het eerste record
+static int replayBatch(int count, bool save) {
+    int first = -1;
+    SpoolRecord record;
+    for (int n = 0; n < count && spoolPeek(record); n++) {
+        if (first < 0) first = record.index;
+        spoolAdvance();
+    }
+    if (save) spoolSaveReadOffset();
+    return first;
+}
+
+int main() {
+    setupSpool();
+    for (int i = 0; i < RECORDS; i++) {
+        spoolAppend(SPOOL_RELAY, i, i % 2);
+    }
+    CHECK(getSpoolStats().depth == RECORDS);
+
+    // Eerste blok verstuurd en opgeslagen, tweede blok onderbroken door een herstart
+    CHECK(replayBatch(5, true) == 0);
+    CHECK(replayBatch(2, false) == 5);
+    CHECK(getSpoolStats().depth == RECORDS - 7);
+
+    setupSpool();
+    CHECK(getSpoolStats().depth == RECORDS - 5);
+    SpoolRecord record;
+    CHECK(spoolPeek(record) && record.index == 5); // Alleen het onderbroken blok opnieuw
+
+    // Leegmaken verwijdert ook de leespositie; een nieuwe spool begint vooraan
+    CHECK(replayBatch(RECORDS, true) == 5);
+    CHECK(getSpoolStats().depth == 0);
+    CHECK(!LittleFS.exists("/spool.bin"));
+    CHECK(!LittleFS.exists("/spool.pos"));
+
+    spoolAppend(SPOOL_RELAY, 42, 1);
+    setupSpool();
+    CHECK(getSpoolStats().depth == 1);
+    CHECK(spoolPeek(record) && record.index == 42);
+
+    return checkResult("Spool");
+}
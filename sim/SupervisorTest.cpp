@@ -0,0 +1,209 @@
+// Test van Supervisor.cpp met twee schedulers op elk een eigen core: voeden als alle stappen op tijd
+// zijn, één keer overslaan na een te late stap, blijven voeden bij een lange stap die voortgang meldt,
+// niet meer voeden bij een stap die blijft hangen, en na een nagebootste herstart het rapport uit
+// RTC-geheugen op warmtepomp/reboot, als JSON en als MessagePack.
+//
+//   supervisortest
+
+#include <Arduino.h>
+#include "SimHooks.h"
+#include "Check.h"
+#include "Supervisor.h"
+#include "Scheduler.h"
+#include "MQTT.h"
+#include "Spool.h"
+#include "Debug.h"
+#include <ArduinoJson.h>
+
+#include <string>
+
+const uint32_t WATCHDOG_TIMEOUT = 30000;
+const int CONTROL = 1;
+const int NETWORK = 0;
+
+static uint32_t controlWorkMs = 10;
+static std::string rebootPayload;
+
+static void taskControl() {
+    simAdvanceMs(controlWorkMs);
+}
+
+static void taskNetwork() {
+    simAdvanceMs(20);
+}
+
+static void observePublish(const char* topic, const uint8_t* payload, unsigned int length, bool retained) {
+    if (strcmp(topic, "warmtepomp/reboot") == 0 && retained) {
+        rebootPayload.assign(reinterpret_cast<const char*>(payload), length);
+    }
+}
+
+static int findStage(const SupervisorReport& report, const char* name) {
+    for (int i = 0; i < report.stageCount; i++) {
+        if (strcmp(report.names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+// Beide schedulers een ronde laten draaien, elk op zijn eigen core
+static void runRound(Scheduler& control, Scheduler& network) {
+    simSetCoreId(CONTROL);
+    control.run();
+    simSetCoreId(NETWORK);
+    network.run();
+}
+
+int main() {
+    simAdvanceMs(1000);
+    setupSupervisor(WATCHDOG_TIMEOUT);
+    CHECK(getPreviousBoot() == nullptr); // Na inschakelen staat er niets geldigs in RTC-geheugen
+    CHECK(simGetWatchdogTimeoutMs() == WATCHDOG_TIMEOUT);
+
+    Scheduler control;
+    Scheduler network;
+    control.addTask("regel", 100, taskControl);        // Budget = periode
+    network.addTask("netwerk", 100, taskNetwork, 0, 500);
+    int regel = findStage(getCurrentBoot(), "regel");
+    int netwerk = findStage(getCurrentBoot(), "netwerk");
+    CHECK(regel >= 0 && netwerk >= 0);
+
+    // Alles op tijd: elke controle voedt
+    for (int i = 0; i < 20; i++) {
+        runRound(control, network);
+        superviseStages();
+    }
+    SupervisorStats stats = getSupervisorStats();
+    CHECK(stats.feeds == 20);
+    CHECK(stats.withheld == 0);
+    CHECK(simGetWatchdogFeeds() == 20);
+    CHECK(getCurrentBoot().misses[regel] == 0);
+    CHECK(getCurrentBoot().hungStage == -1);
+
+    // Eén keer te laat klaar: één controle zonder voeden, daarna weer gewoon
+    controlWorkMs = 150;
+    runRound(control, network);
+    controlWorkMs = 10;
+    superviseStages();
+    CHECK(getCurrentBoot().misses[regel] == 1);
+    CHECK(getCurrentBoot().misses[netwerk] == 0);
+    CHECK(getSupervisorStats().withheld == 1);
+    runRound(control, network);
+    superviseStages();
+    CHECK(getSupervisorStats().feeds == 21);
+    CHECK(getSupervisorStats().withheld == 1);
+
+    // Stap in setup() binnen zijn budget
+    {
+        SupervisedStage stage("setup_mqtt", 2000);
+        simAdvanceMs(500);
+    }
+    superviseStages();
+    CHECK(getSupervisorStats().feeds == 22);
+
+    // Lange stap op de netwerkcore die voortgang meldt, zoals een upload naar /update: ook na langer
+    // dan de watchdog wordt er gevoed, tot de voortgang stopt
+    simSetCoreId(NETWORK);
+    int8_t upload = superviseStage("upload", 2000);
+    uint32_t feedsBeforeUpload = simGetWatchdogFeeds();
+    stageEnter(upload);
+    for (uint32_t elapsed = 0; elapsed < WATCHDOG_TIMEOUT + 10000; elapsed += 1000) {
+        simAdvanceMs(500);
+        stageProgress();
+        simAdvanceMs(500);
+        superviseStages();
+    }
+    CHECK(getCurrentBoot().hungStage == -1);
+    CHECK(simGetWatchdogFeeds() == feedsBeforeUpload + 40);
+    simAdvanceMs(2000);
+    superviseStages();
+    CHECK(getCurrentBoot().hungStage == upload);
+    CHECK(getCurrentBoot().hungMs == 2500);
+    CHECK(simGetWatchdogFeeds() == feedsBeforeUpload + 40);
+    stageExit(upload);
+    CHECK(getCurrentBoot().misses[upload] == 1); // Te laat klaar blijft een overschrijding
+    superviseStages();
+    stageProgress(); // Buiten een stap: niets te doen
+    superviseStages();
+    CHECK(simGetWatchdogFeeds() == feedsBeforeUpload + 41);
+
+    // Stap op de netwerkcore die blijft hangen: geen voeden meer tot de watchdog ingrijpt
+    int8_t hangt = superviseStage("hangt", 2000);
+    stageEnter(hangt);
+    simAdvanceMs(1500);
+    superviseStages();
+    CHECK(getCurrentBoot().hungStage == -1); // Nog binnen het budget
+    uint32_t feedsBeforeHang = simGetWatchdogFeeds();
+    for (int i = 0; i < 5; i++) {
+        simAdvanceMs(1000);
+        superviseStages();
+    }
+    CHECK(getCurrentBoot().hungStage == hangt);
+    CHECK(getCurrentBoot().hungMs == 6500);
+    CHECK(simGetWatchdogFeeds() == feedsBeforeHang);
+    CHECK(getSupervisorStats().withheld == 8); // Eén te late stap, de upload twee keer en de hangende stap vijf keer
+    uint32_t hungUptime = getCurrentBoot().uptimeMs;
+
+    // Herstart door de watchdog: RTC-geheugen blijft staan, de rest begint opnieuw
+    simSetCoreId(CONTROL);
+    simAdvanceMs(WATCHDOG_TIMEOUT);
+    setupSupervisor(WATCHDOG_TIMEOUT);
+    const SupervisorReport* previous = getPreviousBoot();
+    CHECK(previous != nullptr);
+    if (previous != nullptr) {
+        CHECK(previous->hungStage == hangt);
+        CHECK(strcmp(previous->names[hangt], "hangt") == 0);
+        CHECK(previous->uptimeMs == hungUptime);
+        CHECK(previous->misses[regel] == 1);
+        CHECK(previous->misses[findStage(*previous, "setup_mqtt")] == 0);
+
+        // Beide ringen zijn rondgegaan; samen op tijdvolgorde, met als laatste het begin van de hangende stap
+        CHECK(previous->crumbCount[CONTROL] > SUPERVISOR_CRUMBS && previous->crumbCount[NETWORK] > SUPERVISOR_CRUMBS);
+        SupervisorCrumb trail[2 * SUPERVISOR_CRUMBS];
+        uint8_t count = supervisorTrail(*previous, trail, 2 * SUPERVISOR_CRUMBS);
+        CHECK(count == 2 * SUPERVISOR_CRUMBS);
+        bool ordered = true;
+        for (uint8_t i = 1; i < count; i++) ordered &= trail[i - 1].timeMs <= trail[i].timeMs;
+        CHECK(ordered);
+        CHECK(trail[count - 1].stage == hangt && trail[count - 1].event == CRUMB_ENTER);
+
+        // Minder plaats: alleen de nieuwste
+        SupervisorCrumb last[4];
+        CHECK(supervisorTrail(*previous, last, 4) == 4);
+        CHECK(memcmp(last, &trail[count - 4], sizeof(last)) == 0);
+    }
+    CHECK(getCurrentBoot().stageCount == 0);
+    CHECK(getSupervisorStats().feeds == 0);
+
+    // Rapport op warmtepomp/reboot, met de reden van de herstart
+    rebootReason = "Task Watchdog";
+    setupSpool();
+    setupMQTT();
+    for (int i = 0; i < 10 && getMqttConnectionState() != MQTT_SUBSCRIBED; i++) {
+        loopMQTT();
+        simAdvanceMs(100);
+    }
+    CHECK(getMqttConnectionState() == MQTT_SUBSCRIBED);
+    simSetPublishObserver(observePublish);
+    publishRebootReport();
+    CHECK(rebootPayload.find("\"reason\":\"Task Watchdog\"") != std::string::npos);
+    CHECK(rebootPayload.find("\"hung_stage\":\"hangt\"") != std::string::npos);
+    CHECK(rebootPayload.find("\"hung_ms\":6500") != std::string::npos);
+    CHECK(rebootPayload.find("\"misses\":{\"regel\":1,\"upload\":1}") != std::string::npos);
+    CHECK(rebootPayload.find("\"trail\":[[") != std::string::npos);
+    CHECK(rebootPayload.find(",\"hangt\"]]") != std::string::npos); // Laatste binnenkomst, zonder duur
+
+    // Zelfde rapport als MessagePack: het spoor volgt per gebeurtenis achter de kop, met een arraykop van 64
+    std::string json = rebootPayload;
+    PublishConfig config = {5UL * 60UL * 1000UL, 0.2, false, {CODEC_JSON, CODEC_JSON, CODEC_JSON}, 0};
+    config.codecs[PAYLOAD_TELEMETRY] = CODEC_MSGPACK;
+    configurePublishing(config);
+    publishRebootReport();
+    DynamicJsonDocument decoded(8192);
+    CHECK(!deserializeMsgPack(decoded, rebootPayload.data(), rebootPayload.size()));
+    String again;
+    serializeJson(decoded, again);
+    CHECK(json == again.c_str());
+
+    printf("Supervisor: rapport %u bytes, als MessagePack %u\n", (unsigned)json.size(), (unsigned)rebootPayload.size());
+    return checkResult("Supervisor");
+}
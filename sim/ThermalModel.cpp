@@ -0,0 +1,74 @@
+#include "ThermalModel.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const double WATER_HEAT_CAPACITY = 4.186; // kJ per liter per kelvin
+static const double SECONDS_PER_DAY = 86400.0;
+static const double DAYS_PER_YEAR = 365.0;
+
+ThermalModel::ThermalModel(const ThermalConfig& config)
+    : config(config), tankTemperatureC(config.heatingSetpoint + 10.0), pumpEnergy(0), loadEnergy(0) {
+}
+
+bool ThermalModel::loadOutdoorProfile(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) return false;
+
+    outdoorProfile.clear();
+    char line[64];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        char* end = nullptr;
+        float value = strtof(line, &end);
+        if (end != line) outdoorProfile.push_back(value);
+    }
+    fclose(file);
+    return !outdoorProfile.empty();
+}
+
+float ThermalModel::outdoorTemperature(double seconds) const {
+    if (!outdoorProfile.empty()) {
+        // Lineair tussen de uurwaarden
+        double hours = seconds / 3600.0;
+        size_t hour = (size_t)hours % outdoorProfile.size();
+        size_t next = (hour + 1) % outdoorProfile.size();
+        double fraction = hours - floor(hours);
+        return outdoorProfile[hour] + (outdoorProfile[next] - outdoorProfile[hour]) * fraction;
+    }
+
+    double day = seconds / SECONDS_PER_DAY;
+    double year = cos(2.0 * M_PI * (day - config.coldestDayOfYear) / DAYS_PER_YEAR);
+    double hourOfDay = fmod(seconds, SECONDS_PER_DAY) / 3600.0;
+    double daily = cos(2.0 * M_PI * (hourOfDay - 15.0) / 24.0); // Warmste moment rond 15:00
+    // Weer over een paar dagen: twee sinussen met periodes die niet in het jaar opgaan
+    double weather = 0.6 * sin(2.0 * M_PI * day / 6.3) + 0.4 * sin(2.0 * M_PI * day / 17.9 + 1.0);
+    return config.outdoorMean - config.outdoorYearAmplitude * year + config.outdoorDayAmplitude * daily +
+           config.weatherAmplitude * weather;
+}
+
+void ThermalModel::step(double seconds, double timeSeconds, const bool* pumpsOn, bool cooling) {
+    float outdoor = outdoorTemperature(timeSeconds);
+
+    // Vermogen per pomp neemt af bij kou (verwarmen) en bij hitte (koelen)
+    double factor = 1.0 + config.capacityPerKelvin * (cooling ? 35.0 - outdoor : outdoor - 7.0);
+    factor = fmin(1.3, fmax(0.5, factor));
+    double pumpPower = 0;
+    for (int i = 0; i < config.pumpCount; i++) {
+        if (pumpsOn[i]) pumpPower += config.pumpCapacityKw * factor;
+    }
+
+    // Het huis onttrekt warmte zolang het vat warmer is dan binnen, of levert warmte bij koelen
+    double load = 0;
+    if (!cooling && outdoor < config.heatingSetpoint && tankTemperatureC > config.heatingSetpoint) {
+        load = config.houseLossKwPerK * (config.heatingSetpoint - outdoor);
+    } else if (cooling && outdoor > config.coolingSetpoint && tankTemperatureC < config.coolingSetpoint) {
+        load = -config.houseLossKwPerK * (outdoor - config.coolingSetpoint);
+    }
+
+    double loss = config.tankLossKwPerK * (tankTemperatureC - config.roomTemperature);
+    double net = (cooling ? -pumpPower : pumpPower) - load - loss; // kW, positief = vat warmt op
+
+    tankTemperatureC += net * seconds / (config.tankLiters * WATER_HEAT_CAPACITY);
+    pumpEnergy += pumpPower * seconds / 3600.0;
+    loadEnergy += fabs(load) * seconds / 3600.0;
+}
@@ -0,0 +1,57 @@
+#ifndef SIM_THERMALMODEL_H
+#define SIM_THERMALMODEL_H
+
+#include <vector>
+
+// Instelbare gegevens van het buffervat, de warmtepompen en het huis
+struct ThermalConfig {
+    float tankLiters = 500.0;          // Inhoud buffervat
+    float tankLossKwPerK = 0.004;      // Stilstandsverlies naar de stookruimte
+    float roomTemperature = 15.0;      // Temperatuur van de stookruimte
+
+    int pumpCount = 3;
+    float pumpCapacityKw = 6.0;        // Vermogen per pomp bij 7 °C buiten
+    float capacityPerKelvin = 0.025;   // Vermogensverandering per graad buitentemperatuur
+
+    float houseLossKwPerK = 0.25;      // Warmteverlies van het huis (UA)
+    float heatingSetpoint = 20.0;      // Binnentemperatuur bij verwarmen
+    float coolingSetpoint = 24.0;      // Binnentemperatuur waarboven gekoeld wordt
+
+    // Buitentemperatuur als sinus over het jaar en de dag, tenzij er een uurprofiel is geladen
+    float outdoorMean = 10.5;
+    float outdoorYearAmplitude = 8.0;
+    float outdoorDayAmplitude = 4.0;
+    float weatherAmplitude = 3.0;      // Afwijking over meerdere dagen: koude- en hittegolven
+    float coldestDayOfYear = 20.0;     // 20 januari
+};
+
+// Eén goed gemengd buffervat met de warmtepompen als bron en het huis als last
+class ThermalModel {
+public:
+    explicit ThermalModel(const ThermalConfig& config);
+
+    // Uurwaarden (°C, één per regel) uit een bestand; het profiel herhaalt zich na het laatste uur
+    bool loadOutdoorProfile(const char* path);
+
+    // Buitentemperatuur op een tijdstip in seconden vanaf 1 januari 00:00
+    float outdoorTemperature(double seconds) const;
+
+    // Model seconds vooruitzetten met de gegeven pompstatus
+    void step(double seconds, double timeSeconds, const bool* pumpsOn, bool cooling);
+
+    float tankTemperature() const { return tankTemperatureC; }
+    void setTankTemperature(float celsius) { tankTemperatureC = celsius; }
+
+    // Totalen sinds de start in kWh
+    double pumpEnergyKwh() const { return pumpEnergy; }
+    double loadEnergyKwh() const { return loadEnergy; }
+
+private:
+    ThermalConfig config;
+    std::vector<float> outdoorProfile;
+    float tankTemperatureC;
+    double pumpEnergy;
+    double loadEnergy;
+};
+
+#endif // SIM_THERMALMODEL_H
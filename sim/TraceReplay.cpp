@@ -0,0 +1,255 @@
+// Speelt een trace van /api/trace (of van pumpsim --trace) na door PumpMaster en MQTT.cpp, zo snel als
+// de host kan. Elke stap krijgt de opgenomen klok en invoer; na elke stap moeten de pompen gelijk staan
+// aan wat de regelaar toen besloot. Elk segment begint bij zijn keyframe, dus een ring waarvan het
+// begin al overschreven is speelt ook af.
+//
+//   tracereplay bestand [--max-seconds S] [--verbose]
+
+#include <Arduino.h>
+#include "SimHooks.h"
+#include "PumpMaster.h"
+#include "MQTT.h"
+#include "Trace.h"
+
+#include <time.h>
+#include <vector>
+
+const int MAX_REPORTED = 10; // Eerste verschillen uitgebreid melden
+
+static PumpMaster master;
+static uint64_t nowMs = 0;
+static uint16_t recordedPumps = 0;
+static bool compareDue = false;
+static uint32_t steps = 0;
+static uint32_t differences = 0;
+static uint32_t modeDifferences = 0;
+
+// Invoer zoals laatst opgenomen
+static float target = 0.0;
+static float hysteresis = 0.0;
+static bool heating = true;
+static HeatPumpMode mode = MODE_HEATING; // Zoals laatsteMode in de sketch na het opstarten
+static float lastTemp = 0.0;             // Buffertemperatuur van de laatste stap, voor herhalingen
+static uint32_t loadBits = 0;            // Laatst aan PumpMaster gegeven verwachte last
+static TraceInputSlots inputSlots;       // Zoals in Trace.cpp, voor de compacte stappen
+
+// Startwaarden die in dit segment nog via MQTT moeten binnenkomen
+static uint16_t pendingSeeds = 0;
+
+static uint16_t replayedPumps() {
+    uint16_t mask = 0;
+    for (int i = 0; i < PUMP_COUNT; i++) {
+        if (master.getPumpStatus(i)) mask |= 1 << i;
+    }
+    return mask;
+}
+
+static void compare() {
+    compareDue = false;
+    uint16_t replayed = replayedPumps();
+    if (replayed == recordedPumps) return;
+    if (differences < MAX_REPORTED) {
+        printf("Verschil op %llu ms (stap %u): opgenomen %#x, nagespeeld %#x\n", (unsigned long long)nowMs, (unsigned)steps,
+               recordedPumps, replayed);
+    }
+    differences++;
+    recordedPumps = replayed; // Verder vergelijken vanaf de nagespeelde toestand
+}
+
+static void step(float currentTemp) {
+    if (compareDue) compare();
+    if (heating != (mode == MODE_HEATING)) modeDifferences++;
+    simSetClockMs(nowMs);
+    master.update(currentTemp, target, heating, hysteresis);
+    lastTemp = currentTemp;
+    steps++;
+    compareDue = true; // Een beslissing volgt in het volgende record
+}
+
+static void deliver(const char* topic, const char* payload) {
+    mqttCallback(const_cast<char*>(topic), (byte*)payload, strlen(payload));
+}
+
+static void restoreKeyframe(const TraceRecord* raw) {
+    PumpMasterState state;
+    memcpy(&state, raw, sizeof(state));
+
+    // Startwaarden komen alleen uit de trace. MQTT.cpp onthoudt ze over segmenten heen, dus tot hun
+    // record er is tellen ze als al overgenomen.
+    pendingSeeds = ~state.runtimeSeeded & ((1 << PUMP_COUNT) - 1);
+    state.runtimeSeeded = (1 << PUMP_COUNT) - 1;
+    master.restoreState(state);
+    recordedPumps = state.pumpStatus;
+    loadBits = traceFloatBits(state.expectedLoad);
+    memset(&inputSlots, 0, sizeof(inputSlots));
+}
+
+static void seed(uint8_t pump, uint32_t seconds) {
+    if (pump >= PUMP_COUNT) return;
+    char topic[40];
+    char payload[40];
+    snprintf(topic, sizeof(topic), "warmtepomp/pump/%u/status", pump);
+    snprintf(payload, sizeof(payload), "{\"run_time\":%lu}", (unsigned long)seconds);
+    deliver(topic, payload);
+
+    if (pendingSeeds & (1 << pump)) {
+        PumpMasterState state = master.saveState();
+        state.runtimeSeeded &= ~(1 << pump);
+        master.restoreState(state);
+        pendingSeeds &= ~(1 << pump);
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    double maxSeconds = 0.0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-seconds") == 0 && i + 1 < argc) maxSeconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--verbose") == 0) simSetSerialOutput(true);
+        else if (argv[i][0] != '-' && path == nullptr) path = argv[i];
+        else {
+            fprintf(stderr, "Onbekende optie: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (path == nullptr) {
+        fprintf(stderr, "Gebruik: tracereplay bestand [--max-seconds S] [--verbose]\n");
+        return 2;
+    }
+
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        fprintf(stderr, "Trace %s niet te lezen\n", path);
+        return 2;
+    }
+    std::vector<TraceRecord> records;
+    TraceRecord record;
+    while (fread(&record, sizeof(record), 1, file) == 1) records.push_back(record);
+    fclose(file);
+
+    master.begin();
+
+    clock_t wallStart = clock();
+    uint32_t segments = 0;
+    uint32_t boots = 0;
+    uint64_t firstMs = 0;    // Eerste tijd sinds de laatste herstart
+    uint64_t replayedMs = 0; // Tijd van eerdere opstarts
+    bool timeKnown = false;
+    bool bootStart = false;
+    bool keyframe = false;   // Pas vanaf een keyframe is de toestand bekend
+    for (size_t i = 0; i < records.size(); i++) {
+        const TraceRecord& r = records[i];
+        if (r.type != TRACE_REPEAT && r.type != TRACE_SAMPLES) nowMs += r.deltaMs;
+        if (compareDue && r.type != TRACE_DECISION && r.type != TRACE_FORCE_OFF) compare(); // Uitschakelen komt per pomp
+
+        switch (r.type) {
+            case TRACE_SEGMENT:
+                segments++;
+                keyframe = false;
+                if (r.arg & TRACE_BOOT) {
+                    boots++;
+                    bootStart = true;
+                    mode = MODE_HEATING;
+                }
+                break;
+            case TRACE_TIME:
+                // Na een herstart begint millis() opnieuw; de tijd van de vorige opstart telt mee
+                if (!timeKnown || bootStart) {
+                    if (timeKnown) replayedMs += nowMs - firstMs;
+                    firstMs = r.value;
+                    timeKnown = true;
+                    bootStart = false;
+                }
+                nowMs = r.value;
+                break;
+            case TRACE_KEYFRAME:
+                if (r.value != sizeof(PumpMasterState) || r.arg * sizeof(TraceRecord) < sizeof(PumpMasterState)) {
+                    fprintf(stderr, "Keyframe van %u bytes past niet bij deze build (PUMP_COUNT=%d)\n", (unsigned)r.value, PUMP_COUNT);
+                    return 2;
+                }
+                if (i + r.arg >= records.size()) break; // Afgekapt
+                restoreKeyframe(&records[i + 1]);
+                i += r.arg;
+                keyframe = true;
+                break;
+            default:
+                if (!keyframe) break; // Staart van een segment zonder begin
+                switch (r.type) {
+                    case TRACE_TARGET: target = traceFloat(r.value); break;
+                    case TRACE_BAND:
+                        hysteresis = traceFloat(r.value);
+                        heating = r.arg != 0;
+                        break;
+                    case TRACE_LOAD:
+                        simSetClockMs(nowMs);
+                        master.setExpectedLoad(traceFloat(r.value));
+                        loadBits = r.value;
+                        break;
+                    case TRACE_STEP:
+                        step(traceFloat(r.value));
+                        traceRememberInputs(inputSlots, traceFloatBits(target), loadBits);
+                        break;
+                    case TRACE_REPEAT:
+                        for (uint32_t n = 0; n < r.value; n++) {
+                            nowMs += r.deltaMs;
+                            step(lastTemp);
+                        }
+                        break;
+                    case TRACE_SAMPLES:
+                        for (uint32_t n = 0; n < r.arg; n++) {
+                            uint32_t sample = r.value >> (n * TRACE_SAMPLE_BITS);
+                            uint8_t slot = (sample >> 3) % TRACE_INPUT_SLOTS;
+                            if (slot >= inputSlots.used) {
+                                fprintf(stderr, "Compacte stap verwijst naar leeg vak op positie %u\n", (unsigned)i);
+                                return 2;
+                            }
+                            nowMs += r.deltaMs;
+                            target = traceFloat(inputSlots.target[slot]);
+                            loadBits = inputSlots.load[slot];
+                            master.setExpectedLoad(traceFloat(loadBits));
+                            step(traceSampleTemperature(lastTemp, sample));
+                        }
+                        break;
+                    case TRACE_MODE:
+                        if (r.arg == MODE_HEATING || r.arg == MODE_COOLING) {
+                            deliver("warmtepomp/mode", r.arg == MODE_HEATING ? "Verwarmen" : "Koelen");
+                            mode = GetMode();
+                        }
+                        break;
+                    case TRACE_MQTT: break; // Alleen ter informatie; de regeling kijkt er niet naar
+                    case TRACE_SEED: seed(r.arg, r.value); break;
+                    case TRACE_FORCE_OFF:
+                        simSetClockMs(nowMs);
+                        master.forcePumpOff(r.arg);
+                        compareDue = true;
+                        break;
+                    case TRACE_DECISION:
+                        recordedPumps = r.value;
+                        compare();
+                        break;
+                    default:
+                        fprintf(stderr, "Onbekend record %u op positie %u\n", r.type, (unsigned)i);
+                        return 2;
+                }
+        }
+    }
+    if (compareDue) compare();
+    replayedMs += nowMs - firstMs;
+    double wallSeconds = (double)(clock() - wallStart) / CLOCKS_PER_SEC;
+
+    printf("Trace: %u records (%u bytes), %u segmenten, %u keer opgestart\n", (unsigned)records.size(),
+           (unsigned)(records.size() * sizeof(TraceRecord)), (unsigned)segments, (unsigned)boots);
+    printf("Nagespeeld: %u stappen over %.2f dagen in %.3f s\n", (unsigned)steps, replayedMs / 86400000.0, wallSeconds);
+    printf("Verschillen: %u in de pompen, %u tussen modus en regeling\n", (unsigned)differences, (unsigned)modeDifferences);
+
+    if (steps == 0) {
+        fprintf(stderr, "Geen stappen in de trace\n");
+        return 1;
+    }
+    if (differences > 0 || modeDifferences > 0) return 1;
+    if (maxSeconds > 0.0 && wallSeconds > maxSeconds) {
+        fprintf(stderr, "Naspelen duurde %.3f s, meer dan %.3f s\n", wallSeconds, maxSeconds);
+        return 1;
+    }
+    return 0;
+}
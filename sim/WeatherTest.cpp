@@ -0,0 +1,324 @@
+// Test van Weather.cpp tegen een lokale HTTP-server die antwoorden van open-meteo nabootst:
+// in kleine stukjes, met lokaas naast het gezochte pad, met foutstatus, haperend of helemaal niet.
+// De firmware loopt op de virtuele klok, de server in een eigen thread op echte sockets.
+//
+//   weathertest
+
+#include <Arduino.h>
+#include "SimHooks.h"
+#include "Check.h"
+#include "Weather.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+static const WeatherConfig TEST_CONFIG = {
+    60000,    // intervalMs
+    5000,     // retryMs
+    120000,   // cacheTtlMs
+    1000      // timeoutMs
+};
+
+// Eén antwoord van de nagebootste server
+struct StandInResponse {
+    int status = 200;
+    std::string body;
+    size_t chunkSize = 0;     // 0 = alles in één keer
+    int chunkDelayUs = 0;     // Pauze tussen twee stukjes
+    int stallMs = 0;          // Na de headers zo lang niets sturen
+};
+
+class HttpStandIn {
+public:
+    bool start() {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0; // Vrije poort laten kiezen
+        if (bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, 4) != 0) return false;
+        socklen_t length = sizeof(address);
+        getsockname(listenFd, (sockaddr*)&address, &length);
+        listenPort = ntohs(address.sin_port);
+        running = true;
+        worker = std::thread(&HttpStandIn::serve, this);
+        return true;
+    }
+
+    void stop() {
+        if (!running) return;
+        running = false;
+        worker.join();
+        close(listenFd);
+    }
+
+    uint16_t port() const { return listenPort; }
+    int requests() const { return requestCount; }
+
+    void respond(const StandInResponse& next) {
+        std::lock_guard<std::mutex> lock(mutex);
+        response = next;
+    }
+
+    std::string lastRequest() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return request;
+    }
+
+private:
+    void serve() {
+        while (running) {
+            pollfd p = {listenFd, POLLIN, 0};
+            if (poll(&p, 1, 20) <= 0) continue;
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) continue;
+            handle(fd);
+            close(fd);
+        }
+    }
+
+    void handle(int fd) {
+        std::string received;
+        char buffer[256];
+        while (received.find("\r\n\r\n") == std::string::npos) {
+            ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+            if (length <= 0) return;
+            received.append(buffer, length);
+        }
+
+        StandInResponse current;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            request = received;
+            current = response;
+        }
+        requestCount++;
+
+        std::string headers = "HTTP/1.0 " + std::to_string(current.status) + (current.status == 200 ? " OK" : " Error") +
+                              "\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string(current.body.size()) +
+                              "\r\nCache-Control: max-age=900\r\n\r\n";
+        send(fd, headers.data(), headers.size(), MSG_NOSIGNAL);
+        if (current.stallMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(current.stallMs));
+
+        size_t chunk = current.chunkSize > 0 ? current.chunkSize : current.body.size();
+        for (size_t offset = 0; offset < current.body.size(); offset += chunk) {
+            size_t length = std::min(chunk, current.body.size() - offset);
+            if (send(fd, current.body.data() + offset, length, MSG_NOSIGNAL) <= 0) return; // Client sloot al af
+            if (current.chunkDelayUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(current.chunkDelayUs));
+        }
+    }
+
+    int listenFd = -1;
+    uint16_t listenPort = 0;
+    std::atomic<bool> running{false};
+    std::atomic<int> requestCount{0};
+    std::thread worker;
+    std::mutex mutex;
+    StandInResponse response;
+    std::string request;
+};
+
+// Antwoord zoals open-meteo het stuurt, met een lange reeks uurwaarden ervoor of erna
+static std::string forecastBody(const char* temperature, bool hourlyFirst, int hours = 2000) {
+    std::string hourly = "\"hourly\":{\"time\":[";
+    for (int i = 0; i < hours; i++) hourly += (i ? ",\"2026-10-17T" : "\"2026-10-17T") + std::to_string(i % 24) + ":00\"";
+    hourly += "],\"temperature_2m\":[";
+    for (int i = 0; i < hours; i++) hourly += (i ? "," : "") + std::to_string(5 + i % 7) + ".5";
+    hourly += "]}";
+
+    std::string current = "\"current_weather_units\":{\"time\":\"iso8601\",\"temperature\":\"\\u00b0C\"},"
+                          "\"current_weather\":{\"time\":\"2026-10-17T12:00\",\"interval\":900,\"temperature\":" +
+                          std::string(temperature) + ",\"windspeed\":14.2,\"is_day\":1}";
+
+    std::string body = "{\"latitude\":51.9125,\"longitude\":4.3417,\"timezone\":\"Europe\\/Amsterdam\","
+                       "\"daily\":{\"temperature\":99.0,\"list\":[{\"temperature\":98.0}]},";
+    body += hourlyFirst ? hourly + "," + current : current + "," + hourly;
+    body += "}";
+    return body;
+}
+
+// Virtuele tijd doorzetten en loopWeather() draaien tot er een ophaalactie is afgerond
+static bool fetchAfter(unsigned long waitMs) {
+    simAdvanceMs(waitMs);
+    WeatherStats before = getWeatherStats();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+        loopWeather();
+        WeatherStats now = getWeatherStats();
+        if (now.fetches + now.failures != before.fetches + before.failures) return true;
+        simAdvanceMs(1);
+        std::this_thread::sleep_for(std::chrono::microseconds(250));
+    }
+    return false;
+}
+
+// Een paar ticks zonder de klok te verzetten; verbinden gaat over meer dan één tick
+static void loopFor(int ticks) {
+    for (int i = 0; i < ticks; i++) loopWeather();
+}
+
+int main() {
+    HttpStandIn server;
+    if (!server.start()) {
+        fprintf(stderr, "Lokale server start niet\n");
+        return 1;
+    }
+
+    char url[128];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%u/v1/forecast?latitude=51.9125&longitude=4.3417&current_weather=true",
+             server.port());
+    CHECK(!setupWeather("https://api.open-meteo.com/v1/forecast", TEST_CONFIG)); // Geen TLS
+    CHECK(setupWeather(url, TEST_CONFIG));
+
+    SensorSnapshot probe = {};
+    probe.outdoorTemperature = 11.0;
+    probe.outdoorValid = true;
+    float temperature = 0;
+
+    // Nog niets opgehaald: de buitenvoeler
+    CHECK(selectOutdoorTemperature(probe, temperature) == OUTDOOR_PROBE);
+    CHECK(temperature == 11.0f);
+
+    // Body in losse stukjes van 7 bytes; de waarde staat achteraan, naast lokaas op andere paden
+    StandInResponse trickle;
+    trickle.body = forecastBody("8.4", true, 24);
+    trickle.chunkSize = 7;
+    trickle.chunkDelayUs = 100;
+    server.respond(trickle);
+    CHECK(fetchAfter(0));
+    WeatherStats stats = getWeatherStats();
+    CHECK(stats.fetches == 1);
+    CHECK(stats.lastStatus == 200);
+    CHECK(getWeatherTemperature(temperature));
+    CHECK(fabs(temperature - 8.4f) < 0.001f);
+    CHECK(selectOutdoorTemperature(probe, temperature) == OUTDOOR_WEATHER);
+    std::string request = server.lastRequest();
+    CHECK(request.rfind("GET /v1/forecast?latitude=51.9125&longitude=4.3417&current_weather=true HTTP/1.0\r\n", 0) == 0);
+    CHECK(request.find("\r\nHost: 127.0.0.1\r\n") != std::string::npos);
+
+    // Lange body (ruim 40 kB) met de waarde achteraan: past in geen enkele buffer van de firmware
+    StandInResponse large;
+    large.body = forecastBody("9.75", true);
+    server.respond(large);
+    CHECK(fetchAfter(TEST_CONFIG.intervalMs));
+    stats = getWeatherStats();
+    CHECK(stats.fetches == 2);
+    CHECK(stats.lastBodyBytes == large.body.size());
+    CHECK(getWeatherTemperature(temperature) && fabs(temperature - 9.75f) < 0.001f);
+
+    // Waarde vooraan: de rest van het antwoord wordt niet meer gelezen
+    StandInResponse early;
+    early.body = forecastBody("-3.25", false);
+    server.respond(early);
+    CHECK(fetchAfter(TEST_CONFIG.intervalMs));
+    stats = getWeatherStats();
+    CHECK(stats.fetches == 3);
+    CHECK(getWeatherTemperature(temperature) && fabs(temperature + 3.25f) < 0.001f);
+    CHECK(stats.lastBodyBytes < early.body.size() / 4);
+
+    // Trage resolver: loopWeather() wacht niet op het antwoord en gaat verder zodra het er is
+    char namedUrl[128];
+    snprintf(namedUrl, sizeof(namedUrl), "http://localhost:%u/v1/forecast?current_weather=true", server.port());
+    CHECK(setupWeather(namedUrl, TEST_CONFIG));
+    simSetDnsPending(true);
+    int requestsBefore = server.requests();
+    for (int i = 0; i < 20; i++) {
+        loopWeather();
+        simAdvanceMs(1);
+    }
+    CHECK(server.requests() == requestsBefore);
+    CHECK(getWeatherStats().fetches == 3 && getWeatherStats().failures == 0);
+    simCompleteDns();
+    CHECK(fetchAfter(0));
+    CHECK(getWeatherStats().fetches == 4);
+    simSetDnsPending(false);
+    CHECK(setupWeather(url, TEST_CONFIG));
+
+    // Foutstatus met een geldige body: telt als mislukt, de cache blijft staan
+    StandInResponse error;
+    error.status = 503;
+    error.body = forecastBody("30.0", false);
+    server.respond(error);
+    CHECK(fetchAfter(TEST_CONFIG.intervalMs));
+    stats = getWeatherStats();
+    CHECK(stats.failures == 1);
+    CHECK(stats.lastStatus == 503);
+    CHECK(selectOutdoorTemperature(probe, temperature) == OUTDOOR_WEATHER);
+    CHECK(fabs(temperature + 3.25f) < 0.001f);
+
+    // Na een mislukte poging wordt niet direct opnieuw gevraagd
+    requestsBefore = server.requests();
+    simAdvanceMs(TEST_CONFIG.retryMs / 2);
+    for (int i = 0; i < 50; i++) loopWeather();
+    CHECK(server.requests() == requestsBefore);
+
+    // Body zonder het pad
+    StandInResponse missing;
+    missing.body = "{\"error\":true,\"reason\":\"Parameter current_weather ongeldig\"}";
+    server.respond(missing);
+    CHECK(fetchAfter(TEST_CONFIG.retryMs));
+    CHECK(getWeatherStats().failures == 2);
+
+    // Server stokt na de headers: afgebroken na timeoutMs
+    StandInResponse stalled;
+    stalled.body = forecastBody("12.0", false);
+    stalled.stallMs = 2000;
+    server.respond(stalled);
+    CHECK(fetchAfter(TEST_CONFIG.retryMs));
+    stats = getWeatherStats();
+    CHECK(stats.failures == 3);
+    CHECK(stats.lastDurationMs >= TEST_CONFIG.timeoutMs);
+
+    // Server weg: verbinden mislukt direct
+    server.stop();
+    CHECK(fetchAfter(TEST_CONFIG.retryMs));
+    CHECK(getWeatherStats().failures == 4);
+
+    // Elke volgende mislukking wacht twee keer zo lang, tot hooguit intervalMs
+    unsigned long retry = TEST_CONFIG.retryMs * 8; // Na de vierde op rij
+    simAdvanceMs(retry - 1);
+    loopFor(5);
+    CHECK(getWeatherStats().failures == 4);
+    simAdvanceMs(1);
+    loopFor(5);
+    CHECK(getWeatherStats().failures == 5);
+    simAdvanceMs(TEST_CONFIG.intervalMs - 1); // Begrensd
+    loopFor(5);
+    CHECK(getWeatherStats().failures == 5);
+    simAdvanceMs(1);
+    loopFor(5);
+    CHECK(getWeatherStats().failures == 6);
+
+    // Resolver antwoordt niet binnen timeoutMs: opgegeven, een laat antwoord wordt genegeerd
+    CHECK(setupWeather(namedUrl, TEST_CONFIG));
+    simSetDnsPending(true);
+    loopWeather();
+    simAdvanceMs(TEST_CONFIG.timeoutMs);
+    loopWeather();
+    CHECK(getWeatherStats().failures == 7);
+    simCompleteDns();
+    loopWeather();
+    CHECK(getWeatherStats().failures == 7 && getWeatherStats().fetches == 4);
+    simSetDnsPending(false);
+
+    // Cache verlopen: terug naar de buitenvoeler, en zonder voeler geen waarde
+    simAdvanceMs(TEST_CONFIG.cacheTtlMs);
+    CHECK(!getWeatherTemperature(temperature));
+    CHECK(selectOutdoorTemperature(probe, temperature) == OUTDOOR_PROBE);
+    CHECK(temperature == 11.0f);
+    probe.outdoorValid = false;
+    CHECK(selectOutdoorTemperature(probe, temperature) == OUTDOOR_NONE);
+
+    return checkResult("Weer");
+}
@@ -0,0 +1,172 @@
+#include "Arduino.h"
+#include "SimHooks.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include <stdarg.h>
+#include <random>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static uint64_t simTimeUs = 0;
+static int64_t simEpochSeconds = 1704067200; // 1 januari 2024, 00:00 UTC
+static bool serialOutput = false;
+static uint32_t simFreeHeap = 200000;
+static uint32_t simMinFreeHeap = 200000;
+static uint32_t simLargestBlock = 110000;
+static uint32_t simRestarts = 0;
+static int simCoreId = 1; // setup() en de regeltaak draaien op core 1
+static std::mt19937 simRandom(12345); // Vaste start, zodat elke run hetzelfde verloopt
+
+void simAdvanceMs(uint64_t ms) {
+    simTimeUs += ms * 1000ULL;
+}
+
+void simAdvanceUs(uint64_t us) {
+    simTimeUs += us;
+}
+
+int xPortGetCoreID() {
+    return simCoreId;
+}
+
+void simSetCoreId(int core) {
+    simCoreId = core;
+}
+
+void simSetClockMs(uint64_t ms) {
+    simTimeUs = ms * 1000ULL;
+}
+
+uint64_t simNowUs() {
+    return simTimeUs;
+}
+
+void simSetEpoch(int64_t epochSeconds) {
+    simEpochSeconds = epochSeconds;
+}
+
+void simSetSerialOutput(bool enabled) {
+    serialOutput = enabled;
+}
+
+unsigned long millis() {
+    return (unsigned long)(simTimeUs / 1000ULL);
+}
+
+unsigned long micros() {
+    return (unsigned long)simTimeUs;
+}
+
+void delay(unsigned long ms) {
+    simAdvanceMs(ms);
+}
+
+void yield() {
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    (void)pin;
+    (void)value;
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)simTimeUs;
+}
+
+uint32_t esp_random() {
+    return simRandom();
+}
+
+bool getLocalTime(struct tm* info, uint32_t ms) {
+    (void)ms;
+    time_t now = (time_t)(simEpochSeconds + (int64_t)(simTimeUs / 1000000ULL));
+    return localtime_r(&now, info) != nullptr;
+}
+
+void configTime(long gmtOffset, int daylightOffset, const char* server1, const char* server2, const char* server3) {
+    (void)gmtOffset;
+    (void)daylightOffset;
+    (void)server1;
+    (void)server2;
+    (void)server3;
+}
+
+String::String(float number, unsigned int decimals) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, (double)number);
+    value = buffer;
+}
+
+String::String(double number, unsigned int decimals) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, number);
+    value = buffer;
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (written < size && write(buffer[written])) {
+        written++;
+    }
+    return written;
+}
+
+size_t Print::println(const char* text) {
+    return print(text) + print("\n");
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+    return write(reinterpret_cast<const uint8_t*>(buffer), std::min((size_t)length, sizeof(buffer) - 1));
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    if (serialOutput) fputc(c, stdout);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (serialOutput) fwrite(buffer, 1, size, stdout);
+    return size;
+}
+
+void simSetHeap(uint32_t freeBytes, uint32_t largestBlock) {
+    simFreeHeap = freeBytes;
+    simLargestBlock = largestBlock;
+    simMinFreeHeap = min(simMinFreeHeap, freeBytes);
+}
+
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)(simTimeUs * 240ULL);
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return simFreeHeap;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    return simMinFreeHeap;
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+    return simLargestBlock;
+}
+
+void EspClass::restart() {
+    simRestarts++;
+}
+
+uint32_t simGetRestarts() {
+    return simRestarts;
+}
@@ -0,0 +1,750 @@
+#include "ArduinoJson.h"
+
+static const int JSON_MAX_NESTING = 10;
+
+// ---- Documenten en varianten ----
+
+JsonNode* JsonDocument::allocate() {
+    pool.emplace_back();
+    return &pool.back();
+}
+
+void JsonDocument::clear() {
+    rootNode = JsonNode();
+    pool.clear();
+}
+
+// Grove schatting naar het model van ArduinoJson 6 op 32 bit: 16 bytes per waarde plus gekopieerde tekst
+size_t JsonDocument::memoryUsage() const {
+    size_t usage = 0;
+    for (const JsonNode& node : pool) {
+        usage += 16;
+        if (node.type == JsonNode::Text) usage += node.text.size() + 1;
+    }
+    return usage;
+}
+
+void JsonVariant::reset(JsonNode* target) {
+    target->type = JsonNode::Null;
+    target->text.clear();
+    target->keys.clear();
+    target->items.clear();
+}
+
+JsonNode* JsonVariant::resolve() {
+    if (node != nullptr) return node;
+    if (!parent || doc == nullptr) return nullptr;
+
+    JsonNode* object = parent->resolve();
+    if (object == nullptr) return nullptr;
+    if (object->type == JsonNode::Null) object->type = JsonNode::Object;
+    if (object->type != JsonNode::Object) return nullptr;
+
+    node = doc->allocate();
+    object->keys.push_back(key);
+    object->items.push_back(node);
+    parent.reset();
+    return node;
+}
+
+JsonVariant JsonVariant::operator[](const char* name) const {
+    if (node != nullptr && node->type == JsonNode::Object) {
+        for (size_t i = 0; i < node->keys.size(); i++) {
+            if (node->keys[i] == name) return JsonVariant(node->items[i], doc);
+        }
+    }
+
+    // Nog niet aanwezig: pas aanmaken als er iets naar geschreven wordt
+    JsonVariant pending(nullptr, doc);
+    if (node == nullptr || node->type == JsonNode::Null || node->type == JsonNode::Object) {
+        pending.parent = std::make_shared<JsonVariant>(*this);
+        pending.key = name;
+    }
+    return pending;
+}
+
+bool JsonVariant::containsKey(const char* name) const {
+    if (node == nullptr || node->type != JsonNode::Object) return false;
+    for (const std::string& existing : node->keys) {
+        if (existing == name) return true;
+    }
+    return false;
+}
+
+JsonVariant JsonVariant::operator[](int index) const {
+    if (node != nullptr && node->type == JsonNode::Array && index >= 0 && (size_t)index < node->items.size()) {
+        return JsonVariant(node->items[index], doc);
+    }
+    return JsonVariant(nullptr, doc);
+}
+
+JsonVariant JsonVariant::add() {
+    JsonNode* array = resolve();
+    if (array == nullptr) return JsonVariant();
+    if (array->type == JsonNode::Null) array->type = JsonNode::Array;
+    if (array->type != JsonNode::Array) return JsonVariant();
+
+    JsonNode* element = doc->allocate();
+    array->items.push_back(element);
+    return JsonVariant(element, doc);
+}
+
+JsonArray JsonVariant::createNestedArray() {
+    JsonVariant element = add();
+    JsonNode* target = element.resolve();
+    if (target == nullptr) return JsonArray();
+    target->type = JsonNode::Array;
+    return JsonArray(element);
+}
+
+JsonArray JsonVariant::createNestedArray(const char* name) {
+    JsonVariant member = (*this)[name];
+    JsonNode* target = member.resolve();
+    if (target == nullptr) return JsonArray();
+    reset(target);
+    target->type = JsonNode::Array;
+    return JsonArray(member);
+}
+
+JsonObject JsonVariant::createNestedObject() {
+    JsonVariant element = add();
+    JsonNode* target = element.resolve();
+    if (target == nullptr) return JsonObject();
+    target->type = JsonNode::Object;
+    return JsonObject(element);
+}
+
+JsonObject JsonVariant::createNestedObject(const char* name) {
+    JsonVariant member = (*this)[name];
+    JsonNode* target = member.resolve();
+    if (target == nullptr) return JsonObject();
+    reset(target);
+    target->type = JsonNode::Object;
+    return JsonObject(member);
+}
+
+JsonObject JsonVariant::createNestedObject(const String& name) {
+    return createNestedObject(name.c_str());
+}
+
+// ---- Serialiseren ----
+
+static void writeText(const std::string& text, std::string& out) {
+    out += '"';
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += (char)c;
+                }
+        }
+    }
+    out += '"';
+}
+
+static void writeNode(const JsonNode* node, std::string& out) {
+    char number[32];
+    if (node == nullptr) {
+        out += "null";
+        return;
+    }
+    switch (node->type) {
+        case JsonNode::Null:
+            out += "null";
+            break;
+        case JsonNode::Boolean:
+            out += node->boolean ? "true" : "false";
+            break;
+        case JsonNode::Signed:
+            snprintf(number, sizeof(number), "%lld", (long long)node->sint);
+            out += number;
+            break;
+        case JsonNode::Unsigned:
+            snprintf(number, sizeof(number), "%llu", (unsigned long long)node->uint);
+            out += number;
+            break;
+        case JsonNode::Real:
+            if (isnan(node->real) || isinf(node->real)) {
+                out += "null";
+            } else {
+                snprintf(number, sizeof(number), "%.9g", node->real);
+                out += number;
+            }
+            break;
+        case JsonNode::Text:
+            writeText(node->text, out);
+            break;
+        case JsonNode::Array:
+            out += '[';
+            for (size_t i = 0; i < node->items.size(); i++) {
+                if (i > 0) out += ',';
+                writeNode(node->items[i], out);
+            }
+            out += ']';
+            break;
+        case JsonNode::Object:
+            out += '{';
+            for (size_t i = 0; i < node->items.size(); i++) {
+                if (i > 0) out += ',';
+                writeText(node->keys[i], out);
+                out += ':';
+                writeNode(node->items[i], out);
+            }
+            out += '}';
+            break;
+    }
+}
+
+size_t measureJson(const JsonVariant& variant) {
+    std::string out;
+    writeNode(variant.getNode(), out);
+    return out.size();
+}
+
+size_t serializeJson(const JsonVariant& variant, char* buffer, size_t size) {
+    if (size == 0) return 0;
+    std::string out;
+    writeNode(variant.getNode(), out);
+    size_t length = std::min(out.size(), size - 1);
+    memcpy(buffer, out.data(), length);
+    buffer[length] = '\0';
+    return length;
+}
+
+size_t serializeJson(const JsonVariant& variant, String& output) {
+    std::string out;
+    writeNode(variant.getNode(), out);
+    output = String(out);
+    return out.size();
+}
+
+size_t serializeJson(const JsonVariant& variant, Print& output) {
+    std::string out;
+    writeNode(variant.getNode(), out);
+    return output.write(reinterpret_cast<const uint8_t*>(out.data()), out.size());
+}
+
+// ---- MessagePack ----
+
+static void writeBigEndian(uint64_t value, int bytes, std::string& out) {
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        out += (char)((value >> shift) & 0xFF);
+    }
+}
+
+static void writePackedUnsigned(uint64_t value, std::string& out) {
+    if (value <= 0x7F) {
+        out += (char)value;
+    } else if (value <= 0xFF) {
+        out += (char)0xCC;
+        writeBigEndian(value, 1, out);
+    } else if (value <= 0xFFFF) {
+        out += (char)0xCD;
+        writeBigEndian(value, 2, out);
+    } else if (value <= 0xFFFFFFFFULL) {
+        out += (char)0xCE;
+        writeBigEndian(value, 4, out);
+    } else {
+        out += (char)0xCF;
+        writeBigEndian(value, 8, out);
+    }
+}
+
+static void writePackedSigned(int64_t value, std::string& out) {
+    if (value >= 0) {
+        writePackedUnsigned((uint64_t)value, out); // Zoals ArduinoJson: positief gaat als unsigned
+    } else if (value >= -32) {
+        out += (char)(uint8_t)value;
+    } else if (value >= INT8_MIN) {
+        out += (char)0xD0;
+        writeBigEndian((uint64_t)value, 1, out);
+    } else if (value >= INT16_MIN) {
+        out += (char)0xD1;
+        writeBigEndian((uint64_t)value, 2, out);
+    } else if (value >= INT32_MIN) {
+        out += (char)0xD2;
+        writeBigEndian((uint64_t)value, 4, out);
+    } else {
+        out += (char)0xD3;
+        writeBigEndian((uint64_t)value, 8, out);
+    }
+}
+
+// Lengte van een string, array of map: korte vorm, anders 8 (alleen strings), 16 of 32 bit
+static void writePackedHeader(size_t length, uint8_t fixBase, size_t fixLimit, int code8, uint8_t code16, uint8_t code32, std::string& out) {
+    if (length < fixLimit) {
+        out += (char)(fixBase | length);
+    } else if (code8 >= 0 && length <= 0xFF) {
+        out += (char)code8;
+        writeBigEndian(length, 1, out);
+    } else if (length <= 0xFFFF) {
+        out += (char)code16;
+        writeBigEndian(length, 2, out);
+    } else {
+        out += (char)code32;
+        writeBigEndian(length, 4, out);
+    }
+}
+
+static void writePackedText(const std::string& text, std::string& out) {
+    writePackedHeader(text.size(), 0xA0, 32, 0xD9, 0xDA, 0xDB, out);
+    out += text;
+}
+
+static void writePackedNode(const JsonNode* node, std::string& out) {
+    if (node == nullptr) {
+        out += (char)0xC0;
+        return;
+    }
+    switch (node->type) {
+        case JsonNode::Null:
+            out += (char)0xC0;
+            break;
+        case JsonNode::Boolean:
+            out += (char)(node->boolean ? 0xC3 : 0xC2);
+            break;
+        case JsonNode::Signed:
+            writePackedSigned(node->sint, out);
+            break;
+        case JsonNode::Unsigned:
+            writePackedUnsigned(node->uint, out);
+            break;
+        case JsonNode::Real:
+            // Zoals ArduinoJson 6: float32 zodra de waarde binnen het bereik valt, ook als dat precisie kost
+            if (fabs(node->real) <= 3.402823466e38 || isnan(node->real)) {
+                float value = (float)node->real;
+                uint32_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                out += (char)0xCA;
+                writeBigEndian(bits, 4, out);
+            } else {
+                uint64_t bits;
+                memcpy(&bits, &node->real, sizeof(bits));
+                out += (char)0xCB;
+                writeBigEndian(bits, 8, out);
+            }
+            break;
+        case JsonNode::Text:
+            writePackedText(node->text, out);
+            break;
+        case JsonNode::Array:
+            writePackedHeader(node->items.size(), 0x90, 16, -1, 0xDC, 0xDD, out);
+            for (const JsonNode* item : node->items) writePackedNode(item, out);
+            break;
+        case JsonNode::Object:
+            writePackedHeader(node->items.size(), 0x80, 16, -1, 0xDE, 0xDF, out);
+            for (size_t i = 0; i < node->items.size(); i++) {
+                writePackedText(node->keys[i], out);
+                writePackedNode(node->items[i], out);
+            }
+            break;
+    }
+}
+
+size_t measureMsgPack(const JsonVariant& variant) {
+    std::string out;
+    writePackedNode(variant.getNode(), out);
+    return out.size();
+}
+
+size_t serializeMsgPack(const JsonVariant& variant, char* buffer, size_t size) {
+    std::string out;
+    writePackedNode(variant.getNode(), out);
+    if (out.size() > size) return 0; // Zoals ArduinoJson: past het niet, dan niets
+    memcpy(buffer, out.data(), out.size());
+    return out.size();
+}
+
+size_t serializeMsgPack(const JsonVariant& variant, Print& output) {
+    std::string out;
+    writePackedNode(variant.getNode(), out);
+    return output.write(reinterpret_cast<const uint8_t*>(out.data()), out.size());
+}
+
+// ---- Inlezen ----
+
+namespace {
+
+struct JsonReader {
+    const char* p;
+    const char* end;
+    JsonDocument& doc;
+
+    void skipSpace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    }
+
+    DeserializationError expect(const char* word) {
+        for (; *word; word++, p++) {
+            if (p >= end) return DeserializationError::IncompleteInput;
+            if (*p != *word) return DeserializationError::InvalidInput;
+        }
+        return DeserializationError::Ok;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t codepoint) {
+        if (codepoint < 0x80) {
+            out += (char)codepoint;
+        } else if (codepoint < 0x800) {
+            out += (char)(0xC0 | (codepoint >> 6));
+            out += (char)(0x80 | (codepoint & 0x3F));
+        } else if (codepoint < 0x10000) {
+            out += (char)(0xE0 | (codepoint >> 12));
+            out += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            out += (char)(0x80 | (codepoint & 0x3F));
+        } else {
+            out += (char)(0xF0 | (codepoint >> 18));
+            out += (char)(0x80 | ((codepoint >> 12) & 0x3F));
+            out += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            out += (char)(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    DeserializationError readHex(uint32_t& value) {
+        value = 0;
+        for (int i = 0; i < 4; i++, p++) {
+            if (p >= end) return DeserializationError::IncompleteInput;
+            char c = *p;
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else return DeserializationError::InvalidInput;
+        }
+        return DeserializationError::Ok;
+    }
+
+    DeserializationError readString(std::string& out) {
+        p++; // Openingsteken
+        while (true) {
+            if (p >= end) return DeserializationError::IncompleteInput;
+            char c = *p++;
+            if (c == '"') return DeserializationError::Ok;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (p >= end) return DeserializationError::IncompleteInput;
+            char escaped = *p++;
+            switch (escaped) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t codepoint;
+                    DeserializationError error = readHex(codepoint);
+                    if (error) return error;
+                    // Surrogaatpaar samenvoegen
+                    if (codepoint >= 0xD800 && codepoint < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                        p += 2;
+                        uint32_t low;
+                        error = readHex(low);
+                        if (error) return error;
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, codepoint);
+                    break;
+                }
+                default:
+                    return DeserializationError::InvalidInput;
+            }
+        }
+    }
+
+    DeserializationError readNumber(JsonNode* node) {
+        const char* start = p;
+        bool real = false;
+        if (p < end && (*p == '-' || *p == '+')) p++;
+        while (p < end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '-' || *p == '+')) {
+            if (*p == '.' || *p == 'e' || *p == 'E') real = true;
+            p++;
+        }
+        std::string text(start, p);
+        if (text.empty() || text == "-" || text == "+") return DeserializationError::InvalidInput;
+
+        char* parsedEnd = nullptr;
+        if (!real) {
+            if (text[0] == '-') {
+                node->sint = strtoll(text.c_str(), &parsedEnd, 10);
+                node->type = JsonNode::Signed;
+            } else {
+                node->uint = strtoull(text.c_str(), &parsedEnd, 10);
+                node->type = JsonNode::Unsigned;
+            }
+        } else {
+            node->real = strtod(text.c_str(), &parsedEnd);
+            node->type = JsonNode::Real;
+        }
+        if (parsedEnd == nullptr || *parsedEnd != '\0') return DeserializationError::InvalidInput;
+        return DeserializationError::Ok;
+    }
+
+    DeserializationError readValue(JsonNode* node, int depth) {
+        if (depth > JSON_MAX_NESTING) return DeserializationError::TooDeep;
+        skipSpace();
+        if (p >= end) return DeserializationError::IncompleteInput;
+
+        switch (*p) {
+            case '{': {
+                node->type = JsonNode::Object;
+                p++;
+                skipSpace();
+                if (p < end && *p == '}') {
+                    p++;
+                    return DeserializationError::Ok;
+                }
+                while (true) {
+                    skipSpace();
+                    if (p >= end) return DeserializationError::IncompleteInput;
+                    if (*p != '"') return DeserializationError::InvalidInput;
+                    std::string name;
+                    DeserializationError error = readString(name);
+                    if (error) return error;
+                    skipSpace();
+                    if (p >= end) return DeserializationError::IncompleteInput;
+                    if (*p++ != ':') return DeserializationError::InvalidInput;
+
+                    JsonNode* value = doc.allocate();
+                    error = readValue(value, depth + 1);
+                    if (error) return error;
+                    node->keys.push_back(name);
+                    node->items.push_back(value);
+
+                    skipSpace();
+                    if (p >= end) return DeserializationError::IncompleteInput;
+                    char c = *p++;
+                    if (c == '}') return DeserializationError::Ok;
+                    if (c != ',') return DeserializationError::InvalidInput;
+                }
+            }
+            case '[': {
+                node->type = JsonNode::Array;
+                p++;
+                skipSpace();
+                if (p < end && *p == ']') {
+                    p++;
+                    return DeserializationError::Ok;
+                }
+                while (true) {
+                    JsonNode* value = doc.allocate();
+                    DeserializationError error = readValue(value, depth + 1);
+                    if (error) return error;
+                    node->items.push_back(value);
+
+                    skipSpace();
+                    if (p >= end) return DeserializationError::IncompleteInput;
+                    char c = *p++;
+                    if (c == ']') return DeserializationError::Ok;
+                    if (c != ',') return DeserializationError::InvalidInput;
+                }
+            }
+            case '"':
+                node->type = JsonNode::Text;
+                return readString(node->text);
+            case 't':
+                node->type = JsonNode::Boolean;
+                node->boolean = true;
+                return expect("true");
+            case 'f':
+                node->type = JsonNode::Boolean;
+                node->boolean = false;
+                return expect("false");
+            case 'n':
+                node->type = JsonNode::Null;
+                return expect("null");
+            default:
+                return readNumber(node);
+        }
+    }
+};
+
+} // namespace
+
+DeserializationError deserializeJson(JsonDocument& doc, const char* input, size_t length) {
+    doc.clear();
+    if (input == nullptr) return DeserializationError::EmptyInput;
+
+    JsonReader reader = {input, input + length, doc};
+    reader.skipSpace();
+    if (reader.p >= reader.end || *reader.p == '\0') return DeserializationError::EmptyInput;
+
+    JsonVariant root = doc.root();
+    DeserializationError error = reader.readValue(root.getNode(), 0);
+    if (error) doc.clear();
+    return error;
+}
+
+namespace {
+
+struct MsgPackReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    JsonDocument& doc;
+
+    DeserializationError readBigEndian(int bytes, uint64_t& value) {
+        if (end - p < bytes) return DeserializationError::IncompleteInput;
+        value = 0;
+        for (int i = 0; i < bytes; i++) value = (value << 8) | *p++;
+        return DeserializationError::Ok;
+    }
+
+    DeserializationError readText(size_t length, std::string& out) {
+        if ((size_t)(end - p) < length) return DeserializationError::IncompleteInput;
+        out.assign(reinterpret_cast<const char*>(p), length);
+        p += length;
+        return DeserializationError::Ok;
+    }
+
+    DeserializationError readSigned(int bytes, JsonNode* node) {
+        uint64_t raw;
+        DeserializationError error = readBigEndian(bytes, raw);
+        if (error) return error;
+        int shift = 64 - bytes * 8;
+        node->type = JsonNode::Signed;
+        node->sint = (int64_t)(raw << shift) >> shift; // Tekenbit uitbreiden
+        return DeserializationError::Ok;
+    }
+
+    DeserializationError readItems(JsonNode* node, size_t count, bool object, int depth) {
+        node->type = object ? JsonNode::Object : JsonNode::Array;
+        for (size_t i = 0; i < count; i++) {
+            if (object) {
+                JsonNode name;
+                DeserializationError error = readValue(&name, depth + 1);
+                if (error) return error;
+                if (name.type != JsonNode::Text) return DeserializationError::InvalidInput;
+                node->keys.push_back(name.text);
+            }
+            JsonNode* value = doc.allocate();
+            DeserializationError error = readValue(value, depth + 1);
+            if (error) return error;
+            node->items.push_back(value);
+        }
+        return DeserializationError::Ok;
+    }
+
+    DeserializationError readValue(JsonNode* node, int depth) {
+        if (depth > JSON_MAX_NESTING) return DeserializationError::TooDeep;
+        if (p >= end) return DeserializationError::IncompleteInput;
+
+        uint8_t code = *p++;
+        uint64_t value = 0;
+        DeserializationError error;
+
+        if (code <= 0x7F) {
+            node->type = JsonNode::Unsigned;
+            node->uint = code;
+            return DeserializationError::Ok;
+        }
+        if (code >= 0xE0) {
+            node->type = JsonNode::Signed;
+            node->sint = (int8_t)code;
+            return DeserializationError::Ok;
+        }
+        if ((code & 0xE0) == 0xA0) {
+            node->type = JsonNode::Text;
+            return readText(code & 0x1F, node->text);
+        }
+        if ((code & 0xF0) == 0x90) return readItems(node, code & 0x0F, false, depth);
+        if ((code & 0xF0) == 0x80) return readItems(node, code & 0x0F, true, depth);
+
+        switch (code) {
+            case 0xC0:
+                node->type = JsonNode::Null;
+                return DeserializationError::Ok;
+            case 0xC2:
+            case 0xC3:
+                node->type = JsonNode::Boolean;
+                node->boolean = code == 0xC3;
+                return DeserializationError::Ok;
+            case 0xCC:
+            case 0xCD:
+            case 0xCE:
+            case 0xCF:
+                error = readBigEndian(1 << (code - 0xCC), value);
+                node->type = JsonNode::Unsigned;
+                node->uint = value;
+                return error;
+            case 0xD0:
+            case 0xD1:
+            case 0xD2:
+            case 0xD3:
+                return readSigned(1 << (code - 0xD0), node);
+            case 0xCA: {
+                error = readBigEndian(4, value);
+                uint32_t bits = (uint32_t)value;
+                float real;
+                memcpy(&real, &bits, sizeof(real));
+                node->type = JsonNode::Real;
+                node->real = real;
+                return error;
+            }
+            case 0xCB:
+                error = readBigEndian(8, value);
+                memcpy(&node->real, &value, sizeof(node->real));
+                node->type = JsonNode::Real;
+                return error;
+            case 0xD9:
+            case 0xDA:
+            case 0xDB:
+                error = readBigEndian(1 << (code - 0xD9), value);
+                if (error) return error;
+                node->type = JsonNode::Text;
+                return readText(value, node->text);
+            case 0xDC:
+            case 0xDD:
+                error = readBigEndian(code == 0xDC ? 2 : 4, value);
+                if (error) return error;
+                return readItems(node, value, false, depth);
+            case 0xDE:
+            case 0xDF:
+                error = readBigEndian(code == 0xDE ? 2 : 4, value);
+                if (error) return error;
+                return readItems(node, value, true, depth);
+            default:
+                return DeserializationError::InvalidInput; // Binair, ext en gereserveerd: niet nodig
+        }
+    }
+};
+
+} // namespace
+
+DeserializationError deserializeMsgPack(JsonDocument& doc, const char* input, size_t length) {
+    doc.clear();
+    if (input == nullptr || length == 0) return DeserializationError::EmptyInput;
+
+    const uint8_t* start = reinterpret_cast<const uint8_t*>(input);
+    MsgPackReader reader = {start, start + length, doc};
+    JsonVariant root = doc.root();
+    DeserializationError error = reader.readValue(root.getNode(), 0);
+    if (error) doc.clear();
+    return error;
+}
+
+const char* DeserializationError::c_str() const {
+    switch (value) {
+        case Ok: return "Ok";
+        case EmptyInput: return "EmptyInput";
+        case IncompleteInput: return "IncompleteInput";
+        case InvalidInput: return "InvalidInput";
+        case NoMemory: return "NoMemory";
+        case TooDeep: return "TooDeep";
+    }
+    return "?";
+}
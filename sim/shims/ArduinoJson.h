@@ -0,0 +1,350 @@
+#ifndef SIM_ARDUINOJSON_H
+#define SIM_ARDUINOJSON_H
+
+// Deelverzameling van de ArduinoJson 6-API voor de hostsimulatie: documenten, geneste arrays en objecten,
+// serializeJson/measureJson, deserializeJson en dezelfde drie voor MessagePack. De capaciteit van een document wordt niet afgedwongen.
+
+#include <Arduino.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+struct JsonNode {
+    enum Type : uint8_t { Null, Boolean, Signed, Unsigned, Real, Text, Array, Object };
+
+    Type type = Null;
+    bool boolean = false;
+    int64_t sint = 0;
+    uint64_t uint = 0;
+    double real = 0;
+    std::string text;
+    std::vector<std::string> keys;   // Alleen bij Object, parallel aan items
+    std::vector<JsonNode*> items;    // Elementen van een Array of waarden van een Object
+};
+
+class JsonDocument;
+class JsonArray;
+class JsonObject;
+
+class JsonVariant {
+public:
+    JsonVariant() : node(nullptr), doc(nullptr) {}
+    JsonVariant(JsonNode* node, JsonDocument* doc) : node(node), doc(doc) {}
+
+    // Schrijven
+    template <typename T, typename = typename std::enable_if<!std::is_base_of<JsonVariant, T>::value>::type>
+    JsonVariant& operator=(const T& value) {
+        set(value);
+        return *this;
+    }
+
+    template <typename T>
+    bool set(const T& value) {
+        JsonNode* target = resolve();
+        if (target == nullptr) return false;
+        reset(target);
+        if constexpr (std::is_same<T, bool>::value) {
+            target->type = JsonNode::Boolean;
+            target->boolean = value;
+        } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+            target->type = JsonNode::Signed;
+            target->sint = value;
+        } else if constexpr (std::is_integral<T>::value) {
+            target->type = JsonNode::Unsigned;
+            target->uint = value;
+        } else if constexpr (std::is_enum<T>::value) {
+            target->type = JsonNode::Signed;
+            target->sint = (int64_t)value;
+        } else if constexpr (std::is_floating_point<T>::value) {
+            target->type = JsonNode::Real;
+            target->real = value;
+        } else if constexpr (std::is_same<T, std::nullptr_t>::value) {
+            target->type = JsonNode::Null;
+        } else if constexpr (std::is_same<T, String>::value) {
+            target->type = JsonNode::Text;
+            target->text = value.c_str();
+        } else {
+            const char* text = value;
+            if (text == nullptr) return true;
+            target->type = JsonNode::Text;
+            target->text = text;
+        }
+        return true;
+    }
+
+    // Lezen
+    template <typename T>
+    T as() const {
+        const JsonNode* n = node;
+        if constexpr (std::is_same<T, bool>::value) {
+            if (n == nullptr) return false;
+            if (n->type == JsonNode::Boolean) return n->boolean;
+            if (n->type == JsonNode::Signed) return n->sint != 0;
+            if (n->type == JsonNode::Unsigned) return n->uint != 0;
+            if (n->type == JsonNode::Real) return n->real != 0;
+            return false;
+        } else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+            if (n == nullptr) return T();
+            if (n->type == JsonNode::Signed) return (T)n->sint;
+            if (n->type == JsonNode::Unsigned) return (T)n->uint;
+            if (n->type == JsonNode::Real) return (T)n->real;
+            if (n->type == JsonNode::Boolean) return (T)n->boolean;
+            return T();
+        } else if constexpr (std::is_floating_point<T>::value) {
+            if (n == nullptr) return 0;
+            if (n->type == JsonNode::Real) return (T)n->real;
+            if (n->type == JsonNode::Signed) return (T)n->sint;
+            if (n->type == JsonNode::Unsigned) return (T)n->uint;
+            return 0;
+        } else if constexpr (std::is_same<T, const char*>::value) {
+            return n != nullptr && n->type == JsonNode::Text ? n->text.c_str() : nullptr;
+        } else if constexpr (std::is_same<T, String>::value) {
+            return n != nullptr && n->type == JsonNode::Text ? String(n->text.c_str()) : String("null");
+        } else {
+            return T(*this);
+        }
+    }
+
+    template <typename T>
+    bool is() const {
+        if (node == nullptr) return false;
+        if constexpr (std::is_same<T, bool>::value) {
+            return node->type == JsonNode::Boolean;
+        } else if constexpr (std::is_integral<T>::value) {
+            return node->type == JsonNode::Signed || node->type == JsonNode::Unsigned;
+        } else if constexpr (std::is_floating_point<T>::value) {
+            return node->type == JsonNode::Real || node->type == JsonNode::Signed || node->type == JsonNode::Unsigned;
+        } else if constexpr (std::is_same<T, const char*>::value || std::is_same<T, String>::value) {
+            return node->type == JsonNode::Text;
+        } else if constexpr (std::is_same<T, JsonArray>::value) {
+            return node->type == JsonNode::Array;
+        } else if constexpr (std::is_same<T, JsonObject>::value) {
+            return node->type == JsonNode::Object;
+        } else {
+            return true;
+        }
+    }
+
+    template <typename T, typename = typename std::enable_if<!std::is_base_of<JsonVariant, T>::value>::type>
+    operator T() const {
+        return as<T>();
+    }
+
+    bool isNull() const { return node == nullptr || node->type == JsonNode::Null; }
+    size_t size() const { return node != nullptr && (node->type == JsonNode::Array || node->type == JsonNode::Object) ? node->items.size() : 0; }
+
+    // Objecten
+    JsonVariant operator[](const char* key) const;
+    JsonVariant operator[](const String& key) const { return (*this)[key.c_str()]; }
+    bool containsKey(const char* key) const;
+
+    // Arrays
+    JsonVariant operator[](int index) const;
+    JsonVariant add();
+    template <typename T>
+    bool add(const T& value) {
+        return add().set(value);
+    }
+
+    JsonArray createNestedArray();
+    JsonArray createNestedArray(const char* key);
+    JsonObject createNestedObject();
+    JsonObject createNestedObject(const char* key);
+    JsonObject createNestedObject(const String& key);
+
+    JsonNode* getNode() const { return node; }
+    JsonDocument* getDocument() const { return doc; }
+
+protected:
+    // Schrijfdoel; maakt een ontbrekend lid pas aan bij het schrijven
+    JsonNode* resolve();
+    static void reset(JsonNode* target);
+
+    JsonNode* node;
+    JsonDocument* doc;
+    std::shared_ptr<JsonVariant> parent;   // Object waarin key nog aangemaakt moet worden
+    std::string key;
+};
+
+class JsonArray : public JsonVariant {
+public:
+    JsonArray() {}
+    JsonArray(const JsonVariant& variant) : JsonVariant(variant.is<JsonArray>() ? variant.getNode() : nullptr, variant.getDocument()) {}
+
+    class iterator {
+    public:
+        iterator(const JsonArray* array, size_t index) : array(array), index(index) {}
+        JsonVariant operator*() const { return JsonVariant(array->node->items[index], array->doc); }
+        iterator& operator++() { index++; return *this; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+
+    private:
+        const JsonArray* array;
+        size_t index;
+    };
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, size()); }
+};
+
+class JsonPair {
+public:
+    JsonPair(const char* key, JsonVariant value) : name(key), variant(value) {}
+    const char* key() const { return name; }
+    JsonVariant value() const { return variant; }
+
+private:
+    const char* name;
+    JsonVariant variant;
+};
+
+class JsonObject : public JsonVariant {
+public:
+    JsonObject() {}
+    JsonObject(const JsonVariant& variant) : JsonVariant(variant.is<JsonObject>() ? variant.getNode() : nullptr, variant.getDocument()) {}
+
+    class iterator {
+    public:
+        iterator(const JsonObject* object, size_t index) : object(object), index(index) {}
+        JsonPair operator*() const {
+            return JsonPair(object->node->keys[index].c_str(), JsonVariant(object->node->items[index], object->doc));
+        }
+        iterator& operator++() { index++; return *this; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+
+    private:
+        const JsonObject* object;
+        size_t index;
+    };
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, size()); }
+};
+
+typedef JsonVariant JsonVariantConst;
+typedef JsonArray JsonArrayConst;
+typedef JsonObject JsonObjectConst;
+
+class JsonDocument {
+public:
+    explicit JsonDocument(size_t capacity) : capacityBytes(capacity) {}
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+    virtual ~JsonDocument() {}
+
+    JsonVariant root() { return JsonVariant(&rootNode, this); }
+
+    JsonVariant operator[](const char* key) { return root()[key]; }
+    JsonVariant operator[](const String& key) { return root()[key.c_str()]; }
+    JsonVariant operator[](int index) { return root()[index]; }
+    bool containsKey(const char* key) { return root().containsKey(key); }
+
+    template <typename T>
+    T as() { return root().as<T>(); }
+    template <typename T>
+    bool is() { return root().is<T>(); }
+    template <typename T>
+    T to() {
+        clear();
+        if constexpr (std::is_same<T, JsonArray>::value) rootNode.type = JsonNode::Array;
+        if constexpr (std::is_same<T, JsonObject>::value) rootNode.type = JsonNode::Object;
+        return T(root());
+    }
+    template <typename T>
+    bool set(const T& value) { return root().set(value); }
+    template <typename T>
+    bool add(const T& value) { return root().add(value); }
+
+    JsonArray createNestedArray() { return root().createNestedArray(); }
+    JsonArray createNestedArray(const char* key) { return root().createNestedArray(key); }
+    JsonObject createNestedObject() { return root().createNestedObject(); }
+    JsonObject createNestedObject(const char* key) { return root().createNestedObject(key); }
+
+    bool isNull() const { return rootNode.type == JsonNode::Null; }
+    size_t size() { return root().size(); }
+    size_t capacity() const { return capacityBytes; }
+    size_t memoryUsage() const;
+    bool overflowed() const { return false; }
+    void clear();
+
+    JsonNode* allocate();
+
+private:
+    JsonNode rootNode;
+    std::deque<JsonNode> pool;   // Pointers blijven geldig bij groei
+    size_t capacityBytes;
+};
+
+template <size_t desiredCapacity>
+class StaticJsonDocument : public JsonDocument {
+public:
+    StaticJsonDocument() : JsonDocument(desiredCapacity) {}
+};
+
+class DynamicJsonDocument : public JsonDocument {
+public:
+    explicit DynamicJsonDocument(size_t capacity) : JsonDocument(capacity) {}
+};
+
+class DeserializationError {
+public:
+    enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep };
+
+    DeserializationError(Code code = Ok) : value(code) {}
+    explicit operator bool() const { return value != Ok; }
+    bool operator==(Code code) const { return value == code; }
+    bool operator!=(Code code) const { return value != code; }
+    Code code() const { return value; }
+    const char* c_str() const;
+
+private:
+    Code value;
+};
+
+// Serialiseren
+size_t measureJson(const JsonVariant& variant);
+size_t serializeJson(const JsonVariant& variant, char* buffer, size_t size);
+size_t serializeJson(const JsonVariant& variant, String& output);
+size_t serializeJson(const JsonVariant& variant, Print& output);
+
+inline size_t measureJson(JsonDocument& doc) { return measureJson(doc.root()); }
+inline size_t serializeJson(JsonDocument& doc, char* buffer, size_t size) { return serializeJson(doc.root(), buffer, size); }
+inline size_t serializeJson(JsonDocument& doc, String& output) { return serializeJson(doc.root(), output); }
+inline size_t serializeJson(JsonDocument& doc, Print& output) { return serializeJson(doc.root(), output); }
+
+template <size_t N>
+size_t serializeJson(JsonDocument& doc, char (&buffer)[N]) {
+    return serializeJson(doc.root(), buffer, N);
+}
+
+template <size_t N>
+size_t serializeJson(const JsonVariant& variant, char (&buffer)[N]) {
+    return serializeJson(variant, buffer, N);
+}
+
+// Serialiseren naar MessagePack; getallen en floats krijgen dezelfde vorm als in ArduinoJson 6
+size_t measureMsgPack(const JsonVariant& variant);
+size_t serializeMsgPack(const JsonVariant& variant, char* buffer, size_t size);
+size_t serializeMsgPack(const JsonVariant& variant, Print& output);
+
+inline size_t measureMsgPack(JsonDocument& doc) { return measureMsgPack(doc.root()); }
+inline size_t serializeMsgPack(JsonDocument& doc, char* buffer, size_t size) { return serializeMsgPack(doc.root(), buffer, size); }
+inline size_t serializeMsgPack(JsonDocument& doc, Print& output) { return serializeMsgPack(doc.root(), output); }
+
+// Inlezen
+DeserializationError deserializeJson(JsonDocument& doc, const char* input, size_t length);
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input) {
+    return deserializeJson(doc, input, input ? strlen(input) : 0);
+}
+inline DeserializationError deserializeJson(JsonDocument& doc, const String& input) {
+    return deserializeJson(doc, input.c_str(), input.length());
+}
+
+DeserializationError deserializeMsgPack(JsonDocument& doc, const char* input, size_t length);
+inline DeserializationError deserializeMsgPack(JsonDocument& doc, const uint8_t* input, size_t length) {
+    return deserializeMsgPack(doc, reinterpret_cast<const char*>(input), length);
+}
+
+#endif // SIM_ARDUINOJSON_H
@@ -0,0 +1,81 @@
+#include "DallasTemperature.h"
+#include "SimHooks.h"
+
+static const uint8_t SIM_MAX_SENSORS = 8;
+
+static uint8_t sensorCount = 2;
+static float sensorTemperature[SIM_MAX_SENSORS] = {20.0, 10.0};
+static bool sensorConnected[SIM_MAX_SENSORS] = {true, true, true, true, true, true, true, true};
+static float latchedTemperature[SIM_MAX_SENSORS];
+static bool latchedConnected[SIM_MAX_SENSORS];
+static uint8_t noiseLsb[SIM_MAX_SENSORS] = {0};
+static uint32_t noiseState = 12345; // Vaste reeks, zodat een run herhaalbaar is
+
+void simSetSensorCount(uint8_t count) {
+    sensorCount = count < SIM_MAX_SENSORS ? count : SIM_MAX_SENSORS;
+}
+
+void simSetSensorTemperature(uint8_t index, float celsius) {
+    if (index < SIM_MAX_SENSORS) sensorTemperature[index] = celsius;
+}
+
+void simSetSensorConnected(uint8_t index, bool connected) {
+    if (index < SIM_MAX_SENSORS) sensorConnected[index] = connected;
+}
+
+void simSetSensorNoise(uint8_t index, uint8_t lsb) {
+    if (index < SIM_MAX_SENSORS) noiseLsb[index] = lsb;
+}
+
+// Geheel getal van -lsb tot en met lsb
+static int noiseSteps(uint8_t lsb) {
+    if (lsb == 0) return 0;
+    noiseState = noiseState * 1664525u + 1013904223u;
+    return (int)((noiseState >> 16) % (2u * lsb + 1u)) - lsb;
+}
+
+uint8_t DallasTemperature::getDeviceCount() {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < sensorCount; i++) {
+        if (sensorConnected[i]) count++;
+    }
+    return count;
+}
+
+// Het adres bevat de index in de laatste byte, zodat getTempC() de sensor terugvindt
+bool DallasTemperature::getAddress(uint8_t* address, uint8_t index) {
+    if (index >= sensorCount || !sensorConnected[index]) return false;
+    memset(address, 0, 8);
+    address[0] = 0x28; // Familiecode DS18B20
+    address[7] = index;
+    return true;
+}
+
+uint16_t DallasTemperature::millisToWaitForConversion(uint8_t bits) {
+    switch (bits) {
+        case 9: return 94;
+        case 10: return 188;
+        case 11: return 375;
+        default: return 750;
+    }
+}
+
+void DallasTemperature::requestTemperatures() {
+    requestTime = millis();
+    for (uint8_t i = 0; i < SIM_MAX_SENSORS; i++) {
+        // Afronden op de resolutie van de sensor (1/16 °C bij 12 bit)
+        float step = 0.5f / (1 << (resolution - 9));
+        latchedTemperature[i] = (roundf(sensorTemperature[i] / step) + noiseSteps(noiseLsb[i])) * step;
+        latchedConnected[i] = i < sensorCount && sensorConnected[i];
+    }
+}
+
+bool DallasTemperature::isConversionComplete() {
+    return millis() - requestTime >= millisToWaitForConversion(resolution);
+}
+
+float DallasTemperature::getTempC(const uint8_t* address) {
+    uint8_t index = address[7];
+    if (index >= SIM_MAX_SENSORS || !latchedConnected[index]) return DEVICE_DISCONNECTED_C;
+    return latchedTemperature[index];
+}
@@ -0,0 +1,34 @@
+#ifndef SIM_DALLASTEMPERATURE_H
+#define SIM_DALLASTEMPERATURE_H
+
+#include <Arduino.h>
+#include <OneWire.h>
+
+#define DEVICE_DISCONNECTED_C -127
+
+typedef uint8_t DeviceAddress[8];
+
+// DS18B20's op de nagebootste bus. De temperatuur wordt vastgelegd bij requestTemperatures(),
+// net als bij de echte sensor, en is na de conversietijd uit te lezen.
+class DallasTemperature {
+public:
+    explicit DallasTemperature(OneWire* bus) { (void)bus; }
+
+    void begin() {}
+    uint8_t getDeviceCount();
+    bool getAddress(uint8_t* address, uint8_t index);
+
+    void setResolution(uint8_t bits) { resolution = bits; }
+    void setWaitForConversion(bool wait) { (void)wait; }
+    uint16_t millisToWaitForConversion(uint8_t bits);
+
+    void requestTemperatures();
+    bool isConversionComplete();
+    float getTempC(const uint8_t* address);
+
+private:
+    uint8_t resolution = 12;
+    unsigned long requestTime = 0;
+};
+
+#endif // SIM_DALLASTEMPERATURE_H
@@ -0,0 +1,41 @@
+#ifndef SIM_EEPROM_H
+#define SIM_EEPROM_H
+
+#include <Arduino.h>
+#include <vector>
+
+// EEPROM-emulatie in het geheugen; begint leeg (0xFF) bij elke simulatie
+class EEPROMClass {
+public:
+    bool begin(size_t size);
+    bool commit();
+    size_t length() const { return data.size(); }
+    uint32_t commitCount() const { return commits; }
+
+    uint8_t read(int address) const { return address >= 0 && (size_t)address < data.size() ? data[address] : 0xFF; }
+    void write(int address, uint8_t value) {
+        if (address >= 0 && (size_t)address < data.size()) data[address] = value;
+    }
+
+    template <typename T>
+    T& get(int address, T& value) const {
+        uint8_t* bytes = reinterpret_cast<uint8_t*>(&value);
+        for (size_t i = 0; i < sizeof(T); i++) bytes[i] = read(address + i);
+        return value;
+    }
+
+    template <typename T>
+    const T& put(int address, const T& value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        for (size_t i = 0; i < sizeof(T); i++) write(address + i, bytes[i]);
+        return value;
+    }
+
+private:
+    std::vector<uint8_t> data;
+    uint32_t commits = 0;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // SIM_EEPROM_H
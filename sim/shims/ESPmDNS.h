@@ -0,0 +1,19 @@
+#ifndef SIM_ESPMDNS_H
+#define SIM_ESPMDNS_H
+
+#include <Arduino.h>
+
+// Aankondigen van de portal; in de simulatie is er niemand die luistert
+class MDNSResponder {
+public:
+    bool begin(const char* hostname) { (void)hostname; return true; }
+    void addService(const char* service, const char* protocol, uint16_t port) {
+        (void)service;
+        (void)protocol;
+        (void)port;
+    }
+};
+
+extern MDNSResponder MDNS;
+
+#endif // SIM_ESPMDNS_H
@@ -0,0 +1,77 @@
+#include "LittleFS.h"
+#include <map>
+#include <string>
+
+LittleFSFS LittleFS;
+
+static std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> files;
+
+bool File::seek(size_t target) {
+    if (!open || target > data->size()) return false;
+    offset = target;
+    return true;
+}
+
+size_t File::read(uint8_t* buffer, size_t length) {
+    if (!open) return 0;
+    size_t count = std::min(length, data->size() - offset);
+    memcpy(buffer, data->data() + offset, count);
+    offset += count;
+    return count;
+}
+
+int File::read() {
+    uint8_t value;
+    return read(&value, 1) == 1 ? value : -1;
+}
+
+size_t File::write(const uint8_t* buffer, size_t length) {
+    if (!open) return 0;
+    if (offset + length > data->size()) data->resize(offset + length);
+    memcpy(data->data() + offset, buffer, length);
+    offset += length;
+    return length;
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)formatOnFail;
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    return true;
+}
+
+File LittleFSFS::open(const char* path, const char* mode) {
+    auto found = files.find(path);
+    if (mode[0] == 'r') {
+        return found == files.end() ? File() : File(found->second, 0);
+    }
+
+    if (found == files.end() || mode[0] == 'w') {
+        files[path] = std::make_shared<std::vector<uint8_t>>();
+        found = files.find(path);
+    }
+    return File(found->second, mode[0] == 'a' ? found->second->size() : 0);
+}
+
+bool LittleFSFS::exists(const char* path) {
+    return files.count(path) != 0;
+}
+
+bool LittleFSFS::remove(const char* path) {
+    return files.erase(path) != 0;
+}
+
+bool LittleFSFS::rename(const char* from, const char* to) {
+    auto found = files.find(from);
+    if (found == files.end()) return false;
+    files[to] = found->second;
+    files.erase(found);
+    return true;
+}
+
+size_t LittleFSFS::usedBytes() {
+    size_t used = 0;
+    for (const auto& file : files) used += file.second->size();
+    return used;
+}
@@ -0,0 +1,45 @@
+#ifndef SIM_LITTLEFS_H
+#define SIM_LITTLEFS_H
+
+#include <Arduino.h>
+#include <memory>
+#include <vector>
+
+// Bestandssysteem in het geheugen met de onderdelen van fs::FS die de firmware gebruikt
+class File {
+public:
+    File() : offset(0), open(false) {}
+    File(std::shared_ptr<std::vector<uint8_t>> data, size_t offset) : data(data), offset(offset), open(true) {}
+
+    explicit operator bool() const { return open; }
+    size_t size() const { return open ? data->size() : 0; }
+    size_t position() const { return offset; }
+    int available() const { return open ? (int)(data->size() - offset) : 0; }
+    bool seek(size_t target);
+    size_t read(uint8_t* buffer, size_t length);
+    int read();
+    size_t write(const uint8_t* buffer, size_t length);
+    size_t write(uint8_t value) { return write(&value, 1); }
+    void flush() {}
+    void close() { open = false; data.reset(); }
+
+private:
+    std::shared_ptr<std::vector<uint8_t>> data;
+    size_t offset;
+    bool open;
+};
+
+class LittleFSFS {
+public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10, const char* partitionLabel = "spiffs");
+    File open(const char* path, const char* mode = "r");
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool rename(const char* from, const char* to);
+    size_t totalBytes() { return 1024 * 1024; }
+    size_t usedBytes();
+};
+
+extern LittleFSFS LittleFS;
+
+#endif // SIM_LITTLEFS_H
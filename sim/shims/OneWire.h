@@ -0,0 +1,14 @@
+#ifndef SIM_ONEWIRE_H
+#define SIM_ONEWIRE_H
+
+#include <Arduino.h>
+
+// De bus zelf doet in de simulatie niets; DallasTemperature levert de waarden
+class OneWire {
+public:
+    OneWire() {}
+    explicit OneWire(uint8_t pin) { (void)pin; }
+    void begin(uint8_t pin) { (void)pin; }
+};
+
+#endif // SIM_ONEWIRE_H
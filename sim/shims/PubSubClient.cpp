@@ -0,0 +1,240 @@
+#include "PubSubClient.h"
+#include "SimHooks.h"
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <set>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+
+static const uint16_t BROKER_PORT = 1883; // Zoals in MQTT.cpp
+
+static bool brokerOnline = true;
+static uint32_t brokerAddress = 0;
+static int listenFd = -1; // Neemt TCP-verbindingen aan zolang de broker online is
+static int peerFd = -1;   // Kant van de broker van de huidige verbinding
+static SimBrokerStats brokerStats = {0, 0, 0};
+static std::set<std::string> subscriptions;
+static std::deque<std::pair<std::string, std::string>> pendingMessages;
+static SimPublishObserver publishObserver = nullptr;
+
+static void closeSocket(int& fd) {
+    if (fd >= 0) close(fd);
+    fd = -1;
+}
+
+// Eigen loopbackadres per proces, zodat tests naast elkaar elk een broker op dezelfde poort hebben
+static void openListener() {
+    if (listenFd >= 0) return;
+    pid_t pid = getpid();
+    for (int attempt = 0; attempt < 16; attempt++) {
+        uint32_t address = (uint32_t)IPAddress(127, 1 + ((pid >> 16) & 0x7F), (pid >> 8) & 0xFF, 1 + (pid + attempt) % 254);
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return;
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+        sockaddr_in local = {};
+        local.sin_family = AF_INET;
+        local.sin_port = htons(BROKER_PORT);
+        local.sin_addr.s_addr = address;
+        if (bind(fd, (sockaddr*)&local, sizeof(local)) == 0 && listen(fd, 8) == 0) {
+            listenFd = fd;
+            brokerAddress = address;
+            return;
+        }
+        close(fd);
+    }
+}
+
+uint32_t simGetBrokerAddress() {
+    openListener();
+    return brokerAddress;
+}
+
+// Offline: bestaande verbinding verbreken en nieuwe weigeren, zoals een gestopte broker
+void simSetBrokerOnline(bool online) {
+    brokerOnline = online;
+    if (online) {
+        openListener();
+    } else {
+        closeSocket(peerFd);
+        closeSocket(listenFd);
+    }
+}
+
+void simInjectMessage(const char* topic, const char* payload) {
+    pendingMessages.emplace_back(topic, payload);
+}
+
+SimBrokerStats simGetBrokerStats() {
+    return brokerStats;
+}
+
+void simSetPublishObserver(SimPublishObserver observer) {
+    publishObserver = observer;
+}
+
+static void deliverPublish(const char* topic, const uint8_t* payload, unsigned int length, bool retained) {
+    brokerStats.publishes++;
+    brokerStats.bytes += length;
+    if (publishObserver != nullptr) publishObserver(topic, payload, length, retained);
+}
+
+PubSubClient::PubSubClient()
+    : client(nullptr), isConnected(false), lastState(MQTT_DISCONNECTED), bufferSize(MQTT_MAX_PACKET_SIZE), streamLength(0), streamRetained(false), streaming(false) {
+}
+
+PubSubClient::PubSubClient(Client& client) : PubSubClient() {
+    this->client = &client;
+}
+
+PubSubClient& PubSubClient::setServer(IPAddress address, uint16_t port) {
+    (void)address;
+    (void)port;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setServer(const char* host, uint16_t port) {
+    (void)host;
+    (void)port;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE) {
+    this->callback = callback;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setSocketTimeout(uint16_t seconds) {
+    (void)seconds;
+    return *this;
+}
+
+bool PubSubClient::setBufferSize(uint16_t size) {
+    bufferSize = size;
+    return true;
+}
+
+uint16_t PubSubClient::getBufferSize() {
+    return bufferSize;
+}
+
+bool PubSubClient::connect(const char* id) {
+    return connect(id, nullptr, nullptr);
+}
+
+// Zoals de echte bibliotheek: een al verbonden client wordt gebruikt zonder zelf te verbinden.
+// De firmware verbindt altijd zelf, dus zonder verbonden client mislukt het hier.
+bool PubSubClient::connect(const char* id, const char* user, const char* pass) {
+    (void)id;
+    (void)user;
+    (void)pass;
+    isConnected = false;
+    if (brokerOnline && WiFi.status() == WL_CONNECTED && client != nullptr && client->connected() && listenFd >= 0) {
+        int accepted = accept(listenFd, nullptr, nullptr);
+        if (accepted >= 0) {
+            closeSocket(peerFd);
+            peerFd = accepted;
+            isConnected = true;
+        }
+    }
+    lastState = isConnected ? MQTT_CONNECTED : MQTT_CONNECT_FAILED;
+    if (isConnected) {
+        subscriptions.clear();
+        brokerStats.connects++;
+    }
+    return isConnected;
+}
+
+void PubSubClient::disconnect() {
+    isConnected = false;
+    lastState = MQTT_DISCONNECTED;
+    closeSocket(peerFd);
+    if (client != nullptr) client->stop();
+}
+
+// Alleen de broker verbreekt de verbinding; de socket zelf niet bij elke aanroep nakijken
+bool PubSubClient::connected() {
+    if (isConnected && (!brokerOnline || WiFi.status() != WL_CONNECTED)) {
+        disconnect();
+    }
+    return isConnected;
+}
+
+int PubSubClient::state() {
+    return lastState;
+}
+
+bool PubSubClient::loop() {
+    if (!connected()) return false;
+
+    while (!pendingMessages.empty()) {
+        std::pair<std::string, std::string> message = pendingMessages.front();
+        pendingMessages.pop_front();
+        if (callback && subscriptions.count(message.first) != 0) {
+            callback(&message.first[0], reinterpret_cast<uint8_t*>(&message.second[0]), message.second.size());
+        }
+    }
+    return true;
+}
+
+bool PubSubClient::subscribe(const char* topic) {
+    if (!connected()) return false;
+    subscriptions.insert(topic);
+    return true;
+}
+
+bool PubSubClient::publish(const char* topic, const char* payload) {
+    return publish(topic, payload, false);
+}
+
+bool PubSubClient::publish(const char* topic, const char* payload, bool retained) {
+    return publish(topic, reinterpret_cast<const uint8_t*>(payload), payload ? strlen(payload) : 0, retained);
+}
+
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained) {
+    if (!connected()) return false;
+    // Zelfde grens als de echte bibliotheek: header, topic en payload moeten in de buffer passen
+    if (5 + 2 + strlen(topic) + length > bufferSize) return false;
+
+    deliverPublish(topic, payload, length, retained);
+    return true;
+}
+
+// Alleen de header en het topic gaan via de buffer; de payload mag groter zijn dan de buffer
+bool PubSubClient::beginPublish(const char* topic, unsigned int length, bool retained) {
+    if (!connected()) return false;
+    if (5 + 2 + strlen(topic) > bufferSize) return false;
+
+    streamTopic = topic;
+    streamPayload.clear();
+    streamLength = length;
+    streamRetained = retained;
+    streaming = true;
+    return true;
+}
+
+size_t PubSubClient::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t PubSubClient::write(const uint8_t* buffer, size_t size) {
+    if (!streaming || !connected()) return 0;
+    streamPayload.append(reinterpret_cast<const char*>(buffer), size);
+    return size;
+}
+
+// Een bericht dat korter of langer is dan aangekondigd zou de broker als kapot pakket zien
+int PubSubClient::endPublish() {
+    if (!streaming) return 0;
+    streaming = false;
+    if (!connected() || streamPayload.size() != streamLength) return 0;
+
+    deliverPublish(streamTopic.c_str(), reinterpret_cast<const uint8_t*>(streamPayload.data()), streamLength, streamRetained);
+    return 1;
+}
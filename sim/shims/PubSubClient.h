@@ -0,0 +1,68 @@
+#ifndef SIM_PUBSUBCLIENT_H
+#define SIM_PUBSUBCLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <functional>
+#include <string>
+
+#define MQTT_CONNECTED 0
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+
+#ifndef MQTT_MAX_PACKET_SIZE
+#define MQTT_MAX_PACKET_SIZE 256
+#endif
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+
+// Nagebootste broker in hetzelfde proces. Hij neemt echte TCP-verbindingen aan op een eigen
+// loopbackadres (simGetBrokerAddress()), zodat de firmware zelf de socket kan verbinden. Berichten van de simulatie (simInjectMessage)
+// worden afgeleverd in loop() als het topic geabonneerd is.
+class PubSubClient : public Print {
+public:
+    PubSubClient();
+    explicit PubSubClient(Client& client);
+
+    PubSubClient& setServer(IPAddress address, uint16_t port);
+    PubSubClient& setServer(const char* host, uint16_t port);
+    PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE);
+    PubSubClient& setSocketTimeout(uint16_t seconds);
+    bool setBufferSize(uint16_t size);
+    uint16_t getBufferSize();
+
+    bool connect(const char* id);
+    bool connect(const char* id, const char* user, const char* pass);
+    void disconnect();
+    bool connected();
+    int state();
+    bool loop();
+
+    bool subscribe(const char* topic);
+    bool publish(const char* topic, const char* payload);
+    bool publish(const char* topic, const char* payload, bool retained);
+    bool publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained);
+
+    // Payload in delen schrijven, zoals de echte bibliotheek: de lengte staat vooraf vast
+    bool beginPublish(const char* topic, unsigned int length, bool retained);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int endPublish();
+
+private:
+    std::function<void(char*, uint8_t*, unsigned int)> callback;
+    Client* client;
+    bool isConnected;
+    int lastState;
+    uint16_t bufferSize;
+
+    // Lopende beginPublish()
+    std::string streamTopic;
+    std::string streamPayload;
+    unsigned int streamLength;
+    bool streamRetained;
+    bool streaming;
+};
+
+#endif // SIM_PUBSUBCLIENT_H
@@ -0,0 +1,51 @@
+#include "ShiftRegister74HC595_NonTemplate.h"
+#include "SimHooks.h"
+
+static uint8_t latchedOutputs = 0;
+static uint32_t latchCount = 0;
+
+uint8_t simGetShiftRegisterOutputs() {
+    return latchedOutputs;
+}
+
+uint32_t simGetShiftRegisterLatches() {
+    return latchCount;
+}
+
+ShiftRegister74HC595_NonTemplate::ShiftRegister74HC595_NonTemplate(uint8_t size, uint8_t serialDataPin, uint8_t clockPin, uint8_t latchPin)
+    : values(size, 0) {
+    (void)serialDataPin;
+    (void)clockPin;
+    (void)latchPin;
+}
+
+void ShiftRegister74HC595_NonTemplate::setAll(const uint8_t* digitalValues) {
+    for (size_t i = 0; i < values.size(); i++) values[i] = digitalValues[i];
+    updateRegisters();
+}
+
+const uint8_t* ShiftRegister74HC595_NonTemplate::getAll() {
+    return values.data();
+}
+
+void ShiftRegister74HC595_NonTemplate::set(uint8_t pin, uint8_t value) {
+    setNoUpdate(pin, value);
+    updateRegisters();
+}
+
+void ShiftRegister74HC595_NonTemplate::setNoUpdate(uint8_t pin, uint8_t value) {
+    if (pin / 8 >= values.size()) return;
+    if (value) values[pin / 8] |= 1 << (pin % 8);
+    else values[pin / 8] &= ~(1 << (pin % 8));
+}
+
+// Alleen het eerste register is zichtbaar voor de simulatie
+void ShiftRegister74HC595_NonTemplate::updateRegisters() {
+    latchedOutputs = values.empty() ? 0 : values[0];
+    latchCount++;
+}
+
+uint8_t ShiftRegister74HC595_NonTemplate::get(uint8_t pin) {
+    if (pin / 8 >= values.size()) return 0;
+    return (values[pin / 8] >> (pin % 8)) & 1;
+}
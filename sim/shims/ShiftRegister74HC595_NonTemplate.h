@@ -0,0 +1,24 @@
+#ifndef SIM_SHIFTREGISTER74HC595_NONTEMPLATE_H
+#define SIM_SHIFTREGISTER74HC595_NONTEMPLATE_H
+
+#include <Arduino.h>
+#include <vector>
+
+// Schuifregister zonder pinnen: elke update telt als één keer schuiven en één latch.
+// Uitlezen via simGetShiftRegisterOutputs() en simGetShiftRegisterLatches().
+class ShiftRegister74HC595_NonTemplate {
+public:
+    ShiftRegister74HC595_NonTemplate(uint8_t size, uint8_t serialDataPin, uint8_t clockPin, uint8_t latchPin);
+
+    void setAll(const uint8_t* digitalValues);
+    const uint8_t* getAll();
+    void set(uint8_t pin, uint8_t value);
+    void setNoUpdate(uint8_t pin, uint8_t value);
+    void updateRegisters();
+    uint8_t get(uint8_t pin);
+
+private:
+    std::vector<uint8_t> values;
+};
+
+#endif // SIM_SHIFTREGISTER74HC595_NONTEMPLATE_H
@@ -0,0 +1,87 @@
+#ifndef SIM_SIMHOOKS_H
+#define SIM_SIMHOOKS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Knoppen waarmee de simulatie de nagebootste hardware bestuurt.
+// Alleen voor de simulatie zelf; de firmware kent deze functies niet.
+
+// Virtuele klok
+void simAdvanceMs(uint64_t ms);
+void simAdvanceUs(uint64_t us);
+uint64_t simNowUs();
+void simSetClockMs(uint64_t ms); // Ook terug, zoals bij het naspelen van een herstart
+
+// Wandkloktijd die getLocalTime() en time() teruggeven bij t = 0
+void simSetEpoch(int64_t epochSeconds);
+
+// Serial naar stdout sturen (standaard uit)
+void simSetSerialOutput(bool enabled);
+
+// Core waarop de aanroepende taak draait (xPortGetCoreID()); standaard 1
+void simSetCoreId(int core);
+
+// Task watchdog: aantal keer gevoed en de ingestelde time-out
+uint32_t simGetWatchdogFeeds();
+uint32_t simGetWatchdogTimeoutMs();
+
+// Heap van ESP: vrij en grootste blok; het laagste punt wordt bijgehouden
+void simSetHeap(uint32_t freeBytes, uint32_t largestBlock);
+
+// DS18B20-sensoren op de bus, op volgorde van index
+void simSetSensorCount(uint8_t count);
+void simSetSensorTemperature(uint8_t index, float celsius);
+void simSetSensorConnected(uint8_t index, bool connected);
+// Ruis zoals een echte DS18B20: elke conversie wijkt tot lsb stappen van de resolutie af (0 = geen)
+void simSetSensorNoise(uint8_t index, uint8_t lsb);
+
+// WiFi-verbinding
+void simSetWiFiConnected(bool connected);
+
+// Resolver van lwIP: opzoekingen laten uitstaan tot simCompleteDns(), zoals bij een trage DNS-server
+void simSetDnsPending(bool pending);
+void simCompleteDns();
+
+// Schuifregister: laatst gelatchte uitgangen (eerste register) en het aantal latches
+uint8_t simGetShiftRegisterOutputs();
+uint32_t simGetShiftRegisterLatches();
+
+// Update-backend (Update.h) en de toestand van de draaiende firmware (esp_ota_ops.h)
+void simSetUpdateFailure(size_t byteOffset);    // Schrijven mislukt vanaf deze positie; SIZE_MAX = nooit
+void simSetUpdateWriteTimeUs(uint32_t usPerKb); // Virtuele tijd per geschreven KB
+bool simUpdateActivated();                      // Laatste update met end() geactiveerd
+size_t simGetUpdateWritten();
+uint32_t simGetUpdateAborts();
+void simSetOtaImageState(int state);            // esp_ota_img_states_t
+int simGetOtaImageState();
+uint32_t simGetRollbacks();
+
+// Tellers van de nagebootste broker
+struct SimBrokerStats {
+    uint32_t publishes;
+    uint64_t bytes;
+    uint32_t connects;
+};
+
+void simSetBrokerOnline(bool online);
+uint32_t simGetBrokerAddress(); // Loopbackadres waarop de broker verbindingen aanneemt; mDNS vindt hem daar
+void simInjectMessage(const char* topic, const char* payload); // Afgeleverd in de volgende mqttClient.loop()
+SimBrokerStats simGetBrokerStats();
+
+// Wordt aangeroepen voor elk bericht dat de broker aanneemt
+typedef void (*SimPublishObserver)(const char* topic, const uint8_t* payload, unsigned int length, bool retained);
+void simSetPublishObserver(SimPublishObserver observer);
+
+// WebServer: verzoek ("GET" of "POST", pad met eventuele query) direct afhandelen met de handler
+// uit server.on(). Geeft de HTTP-status, 404 zonder handler en 0 zonder server.begin().
+int simHttpRequest(const char* method, const char* uri);
+
+// Wordt aangeroepen voor elk stuk van de respons
+typedef void (*SimHttpObserver)(const char* data, size_t length);
+void simSetHttpObserver(SimHttpObserver observer);
+
+// Aantal keer ESP.restart()
+uint32_t simGetRestarts();
+
+#endif // SIM_SIMHOOKS_H
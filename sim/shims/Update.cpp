@@ -0,0 +1,91 @@
+#include "Update.h"
+#include "SimHooks.h"
+#include <stdint.h>
+
+UpdateClass Update;
+
+static size_t failAtByte = SIZE_MAX;
+static uint32_t writeUsPerKb = 0;
+static bool activated = false;
+static uint32_t aborts = 0;
+
+void simSetUpdateFailure(size_t byteOffset) {
+    failAtByte = byteOffset;
+}
+
+void simSetUpdateWriteTimeUs(uint32_t usPerKb) {
+    writeUsPerKb = usPerKb;
+}
+
+bool simUpdateActivated() {
+    return activated;
+}
+
+size_t simGetUpdateWritten() {
+    return Update.progress();
+}
+
+uint32_t simGetUpdateAborts() {
+    return aborts;
+}
+
+bool UpdateClass::begin(size_t size, int command) {
+    (void)size;
+    (void)command;
+    if (running) {
+        error = UPDATE_ERROR_BAD_ARGUMENT;
+        return false;
+    }
+    running = true;
+    error = UPDATE_ERROR_OK;
+    written = 0;
+    activated = false;
+    return true;
+}
+
+size_t UpdateClass::write(uint8_t* data, size_t length) {
+    (void)data;
+    if (!running || hasError()) return 0;
+
+    size_t accepted = length;
+    if (written + length > failAtByte) {
+        accepted = failAtByte > written ? failAtByte - written : 0;
+        error = UPDATE_ERROR_WRITE;
+    }
+    simAdvanceUs((uint64_t)accepted * writeUsPerKb / 1024);
+    written += accepted;
+    return accepted;
+}
+
+bool UpdateClass::end(bool evenIfRemaining) {
+    (void)evenIfRemaining;
+    if (!running || hasError() || written == 0) {
+        if (!hasError()) error = UPDATE_ERROR_ABORT;
+        running = false;
+        return false;
+    }
+    running = false;
+    activated = true;
+    return true;
+}
+
+void UpdateClass::abort() {
+    if (running) aborts++;
+    running = false;
+    error = UPDATE_ERROR_ABORT;
+}
+
+void UpdateClass::printError(Print& out) {
+    out.println(errorString());
+}
+
+const char* UpdateClass::errorString() {
+    switch (error) {
+        case UPDATE_ERROR_OK: return "No Error";
+        case UPDATE_ERROR_WRITE: return "Flash Write Failed";
+        case UPDATE_ERROR_ABORT: return "Update Aborted";
+        case UPDATE_ERROR_BAD_ARGUMENT: return "Bad Argument";
+        case UPDATE_ERROR_NO_PARTITION: return "Partition Could Not be Found";
+    }
+    return "UNKNOWN";
+}
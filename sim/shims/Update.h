@@ -0,0 +1,39 @@
+#ifndef SIM_UPDATE_H
+#define SIM_UPDATE_H
+
+#include <Arduino.h>
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+#define U_FLASH 0
+
+#define UPDATE_ERROR_OK 0
+#define UPDATE_ERROR_WRITE 1
+#define UPDATE_ERROR_ABORT 8
+#define UPDATE_ERROR_BAD_ARGUMENT 9
+#define UPDATE_ERROR_NO_PARTITION 10
+
+// Update-backend zonder flash: telt wat er geschreven wordt en kost virtuele tijd per KB.
+// Fouten en schrijftijd worden ingesteld via SimHooks.h.
+class UpdateClass {
+public:
+    bool begin(size_t size = UPDATE_SIZE_UNKNOWN, int command = U_FLASH);
+    size_t write(uint8_t* data, size_t length);
+    bool end(bool evenIfRemaining = false);
+    void abort();
+
+    void printError(Print& out);
+    const char* errorString();
+    bool hasError() { return error != UPDATE_ERROR_OK; }
+    uint8_t getError() { return error; }
+    bool isRunning() { return running; }
+    size_t progress() { return written; }
+
+private:
+    bool running = false;
+    uint8_t error = UPDATE_ERROR_OK;
+    size_t written = 0;
+};
+
+extern UpdateClass Update;
+
+#endif // SIM_UPDATE_H
@@ -0,0 +1,93 @@
+#include "WebServer.h"
+#include "SimHooks.h"
+
+static WebServer* activeServer = nullptr;
+static SimHttpObserver httpObserver = nullptr;
+
+void simSetHttpObserver(SimHttpObserver observer) {
+    httpObserver = observer;
+}
+
+int simHttpRequest(const char* method, const char* uri) {
+    if (activeServer == nullptr) return 0;
+    return activeServer->dispatch(strcmp(method, "POST") == 0 ? HTTP_POST : HTTP_GET, uri);
+}
+
+void WebServer::on(const char* uri, HTTPMethod method, THandlerFunction handler) {
+    routes.push_back({uri, method, handler});
+}
+
+void WebServer::on(const char* uri, HTTPMethod method, THandlerFunction handler, THandlerFunction uploadHandler) {
+    (void)uploadHandler; // Uploads worden niet nagebootst; otatest roept Ota.cpp rechtstreeks aan
+    on(uri, method, handler);
+}
+
+void WebServer::begin() {
+    activeServer = this;
+}
+
+// Pad en query splitsen; alleen de query wordt bewaard, als argumenten
+int WebServer::dispatch(HTTPMethod method, const char* uri) {
+    const char* query = strchr(uri, '?');
+    size_t pathLength = query ? (size_t)(query - uri) : strlen(uri);
+
+    args.clear();
+    while (query != nullptr) {
+        const char* start = query + 1;
+        const char* end = strchr(start, '&');
+        const char* equals = strchr(start, '=');
+        size_t length = end ? (size_t)(end - start) : strlen(start);
+        if (equals != nullptr && equals < start + length) {
+            args.emplace_back(String(std::string(start, equals - start)), String(std::string(equals + 1, start + length - equals - 1)));
+        } else if (length > 0) {
+            args.emplace_back(String(std::string(start, length)), String());
+        }
+        query = end;
+    }
+
+    status = 404;
+    for (const Route& route : routes) {
+        if (strlen(route.uri) == pathLength && strncmp(route.uri, uri, pathLength) == 0 &&
+            (route.method == HTTP_ANY || route.method == method)) {
+            status = 0;
+            route.handler();
+            return status;
+        }
+    }
+    return status;
+}
+
+bool WebServer::hasArg(const String& name) {
+    for (const auto& entry : args) {
+        if (entry.first == name) return true;
+    }
+    return false;
+}
+
+String WebServer::arg(const String& name) {
+    for (const auto& entry : args) {
+        if (entry.first == name) return entry.second;
+    }
+    return String();
+}
+
+String WebServer::header(const String& name) {
+    (void)name;
+    return String();
+}
+
+void WebServer::send(int code, const char* contentType, const String& content) {
+    (void)contentType;
+    status = code;
+    if (content.length() > 0) sendContent(content.c_str(), content.length());
+}
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+    (void)name;
+    (void)value;
+    (void)first;
+}
+
+void WebServer::sendContent(const char* content, size_t length) {
+    if (httpObserver != nullptr && length > 0) httpObserver(content, length);
+}
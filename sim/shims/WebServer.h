@@ -0,0 +1,72 @@
+#ifndef SIM_WEBSERVER_H
+#define SIM_WEBSERVER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// WebServer zonder socket: een verzoek uit simHttpRequest() gaat direct naar de geregistreerde
+// handler, en wat de handler verstuurt gaat naar de observer uit SimHooks.h.
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_POST };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define HTTP_UPLOAD_BUFLEN 1436
+
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+
+struct HTTPUpload {
+    HTTPUploadStatus status;
+    String filename;
+    String name;
+    String type;
+    size_t totalSize;
+    size_t currentSize;
+    uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+class WebServer {
+public:
+    typedef std::function<void()> THandlerFunction;
+
+    explicit WebServer(int port) { (void)port; }
+
+    void on(const char* uri, HTTPMethod method, THandlerFunction handler);
+    void on(const char* uri, HTTPMethod method, THandlerFunction handler, THandlerFunction uploadHandler);
+    void begin();
+    void handleClient() {}
+
+    bool hasArg(const String& name);
+    String arg(const String& name);
+    String header(const String& name);
+    void collectHeaders(const char* headerKeys[], const size_t count) { (void)headerKeys; (void)count; }
+
+    void send(int code, const char* contentType = nullptr, const String& content = String());
+    void send_P(int code, const char* contentType, PGM_P content) { send(code, contentType, String(content)); }
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(size_t length) { (void)length; }
+    void sendContent(const char* content, size_t length);
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+
+    WiFiClient client() { return WiFiClient(); } // Zonder verbinding; /events valt daardoor meteen af
+    HTTPUpload& upload() { return currentUpload; }
+
+    // Voor simHttpRequest()
+    int dispatch(HTTPMethod method, const char* uri);
+
+private:
+    struct Route {
+        const char* uri;
+        HTTPMethod method;
+        THandlerFunction handler;
+    };
+
+    std::vector<Route> routes;
+    std::vector<std::pair<String, String>> args;
+    HTTPUpload currentUpload;
+    int status = 0;
+};
+
+#endif // SIM_WEBSERVER_H
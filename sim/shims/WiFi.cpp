@@ -0,0 +1,192 @@
+#include "WiFi.h"
+#include "mdns.h"
+#include "ESPmDNS.h"
+#include "SimHooks.h"
+#include "lwip/dns.h"
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+WiFiClass WiFi;
+MDNSResponder MDNS;
+
+static bool wifiConnected = true;
+
+void simSetWiFiConnected(bool connected) {
+    wifiConnected = connected;
+}
+
+wl_status_t WiFiClass::status() {
+    return wifiConnected ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+// Resolver: direct, of pas bij simCompleteDns() als er een opzoeking uitstaat
+static bool dnsPending = false;
+static char pendingName[128];
+static dns_found_callback pendingCallback = nullptr;
+static void* pendingArgument = nullptr;
+
+static bool resolve(const char* hostname, ip_addr_t* addr) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(hostname, nullptr, &hints, &result) != 0 || result == nullptr) return false;
+    addr->addr = reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(result);
+    return true;
+}
+
+err_t dns_gethostbyname(const char* hostname, ip_addr_t* addr, dns_found_callback found, void* callback_arg) {
+    if (dnsPending) {
+        snprintf(pendingName, sizeof(pendingName), "%s", hostname);
+        pendingCallback = found;
+        pendingArgument = callback_arg;
+        return ERR_INPROGRESS;
+    }
+    return resolve(hostname, addr) ? ERR_OK : ERR_ARG;
+}
+
+void simSetDnsPending(bool pending) {
+    dnsPending = pending;
+}
+
+void simCompleteDns() {
+    if (pendingCallback == nullptr) return;
+    dns_found_callback callback = pendingCallback;
+    pendingCallback = nullptr;
+    ip_addr_t addr;
+    bool ok = resolve(pendingName, &addr);
+    callback(pendingName, ok ? &addr : nullptr, pendingArgument);
+}
+
+WiFiClient::WiFiClient(const WiFiClient& other) : socketFd(other.socketFd >= 0 ? dup(other.socketFd) : -1) {
+}
+
+WiFiClient& WiFiClient::operator=(const WiFiClient& other) {
+    if (this != &other) {
+        stop();
+        socketFd = other.socketFd >= 0 ? dup(other.socketFd) : -1;
+    }
+    return *this;
+}
+
+WiFiClient::WiFiClient(int fd) : socketFd(fd) {
+}
+
+int WiFiClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+    stop();
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    if (getaddrinfo(host, service, &hints, &result) != 0 || result == nullptr) return 0;
+
+    int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    bool ok = fd >= 0 && ::connect(fd, result->ai_addr, result->ai_addrlen) == 0;
+    freeaddrinfo(result);
+    (void)timeoutMs; // Lokaal is verbinden direct klaar of direct geweigerd
+    if (!ok) {
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    socketFd = fd;
+    return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    if (socketFd < 0) return 0;
+    ssize_t written = send(socketFd, buffer, size, MSG_NOSIGNAL);
+    return written > 0 ? (size_t)written : 0;
+}
+
+int WiFiClient::available() {
+    if (socketFd < 0) return 0;
+    int pending = 0;
+    if (ioctl(socketFd, FIONREAD, &pending) != 0) return 0;
+    return pending;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+    if (socketFd < 0) return -1;
+    ssize_t length = recv(socketFd, buffer, size, MSG_DONTWAIT);
+    return length > 0 ? (int)length : -1;
+}
+
+// Zoals op de ESP32: verbonden zolang er nog data klaarstaat of de andere kant niet gesloten heeft
+bool WiFiClient::connected() {
+    if (socketFd < 0) return false;
+    if (available() > 0) return true;
+    pollfd p = {socketFd, POLLIN, 0};
+    if (poll(&p, 1, 0) <= 0) return true;
+    uint8_t c;
+    return recv(socketFd, &c, 1, MSG_PEEK | MSG_DONTWAIT) > 0;
+}
+
+void WiFiClient::stop() {
+    if (socketFd >= 0) close(socketFd);
+    socketFd = -1;
+}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(buffer);
+}
+
+struct mdns_search_once_s {
+    int unused;
+};
+
+mdns_search_once_t* mdns_query_async_new(const char* name, const char* service, const char* proto, uint16_t type,
+                                         uint32_t timeout, size_t maxResults, void* notifier) {
+    (void)name;
+    (void)service;
+    (void)proto;
+    (void)type;
+    (void)timeout;
+    (void)maxResults;
+    (void)notifier;
+    return new mdns_search_once_t();
+}
+
+bool mdns_query_async_get_results(mdns_search_once_t* search, uint32_t timeout, mdns_result_t** results, uint8_t* count) {
+    (void)search;
+    (void)timeout;
+
+    mdns_ip_addr_t* address = new mdns_ip_addr_t();
+    address->addr.type = ESP_IPADDR_TYPE_V4;
+    address->addr.u_addr.ip4.addr = simGetBrokerAddress();
+    address->next = nullptr;
+
+    mdns_result_t* result = new mdns_result_t();
+    result->addr = address;
+    result->next = nullptr;
+
+    *results = result;
+    if (count != nullptr) *count = 1;
+    return true;
+}
+
+void mdns_query_async_delete(mdns_search_once_t* search) {
+    delete search;
+}
+
+void mdns_query_results_free(mdns_result_t* results) {
+    while (results != nullptr) {
+        mdns_result_t* next = results->next;
+        delete results->addr;
+        delete results;
+        results = next;
+    }
+}
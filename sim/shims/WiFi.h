@@ -0,0 +1,79 @@
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_CONNECTED = 3,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+#define WIFI_STA 1
+
+class IPAddress {
+public:
+    IPAddress() : address(0) {}
+    IPAddress(uint32_t raw) : address(raw) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : address(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+
+    // Zelfde bytevolgorde als op de ESP32: [0] is het eerste getal van het adres
+    uint8_t operator[](int index) const { return (address >> (8 * index)) & 0xFF; }
+    operator uint32_t() const { return address; }
+    String toString() const;
+
+private:
+    uint32_t address;
+};
+
+class Client : public Print {
+public:
+    size_t write(uint8_t c) override { (void)c; return 1; }
+    using Print::write;
+    virtual bool connected() { return false; }
+    virtual void stop() {}
+};
+
+// TCP over echte sockets van de host, zodat de firmware tegen een lokale server getest kan worden.
+// Voor MQTT gaat alleen de verbinding erover; de berichten gaan rechtstreeks naar PubSubClient.cpp.
+class WiFiClient : public Client {
+public:
+    WiFiClient() : socketFd(-1) {}
+    WiFiClient(int fd); // Neemt een verbonden socket over, zoals op de ESP32
+    ~WiFiClient() { stop(); }
+    // Kopieën delen de verbinding, zoals op de ESP32; elke kopie sluit alleen zijn eigen descriptor
+    WiFiClient(const WiFiClient& other);
+    WiFiClient& operator=(const WiFiClient& other);
+
+    int connect(const char* host, uint16_t port, int32_t timeoutMs);
+    int connect(const char* host, uint16_t port) { return connect(host, port, 3000); }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available();
+    int read();
+    int read(uint8_t* buffer, size_t size);
+    bool connected() override;
+    void stop() override;
+
+    void setTimeout(uint32_t seconds) { (void)seconds; }
+    void setNoDelay(bool noDelay) { (void)noDelay; }
+    int fd() const { return socketFd; }
+
+private:
+    int socketFd;
+};
+
+class WiFiClass {
+public:
+    wl_status_t status();
+    void mode(int mode) { (void)mode; }
+    bool setHostname(const char* name) { (void)name; return true; }
+    void begin() {}
+    int RSSI() { return -60; }
+    IPAddress localIP() { return IPAddress(192, 168, 1, 50); }
+};
+
+extern WiFiClass WiFi;
+
+#endif // SIM_WIFI_H
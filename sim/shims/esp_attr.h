@@ -0,0 +1,7 @@
+#ifndef SIM_ESP_ATTR_H
+#define SIM_ESP_ATTR_H
+
+// Op de host gewoon geheugen; een herstart naspelen is setupSupervisor() opnieuw aanroepen
+#define RTC_NOINIT_ATTR
+
+#endif // SIM_ESP_ATTR_H
@@ -0,0 +1,46 @@
+#include "esp_ota_ops.h"
+#include "SimHooks.h"
+
+static const esp_partition_t runningPartition = {"app0"};
+static esp_ota_img_states_t imageState = ESP_OTA_IMG_UNDEFINED;
+static uint32_t rollbacks = 0;
+
+void simSetOtaImageState(int state) {
+    imageState = (esp_ota_img_states_t)state;
+}
+
+int simGetOtaImageState() {
+    return imageState;
+}
+
+uint32_t simGetRollbacks() {
+    return rollbacks;
+}
+
+static const esp_app_desc_t appDescription = {{0x5e, 0x1d, 0xb0, 0x7a}};
+
+const esp_app_desc_t* esp_app_get_description() {
+    return &appDescription;
+}
+
+const esp_partition_t* esp_ota_get_running_partition() {
+    return &runningPartition;
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t* partition, esp_ota_img_states_t* state) {
+    if (partition == nullptr || state == nullptr) return ESP_FAIL;
+    *state = imageState;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback() {
+    imageState = ESP_OTA_IMG_VALID;
+    return ESP_OK;
+}
+
+// Op de ESP32 herstart dit naar de vorige firmware; hier wordt alleen geteld
+esp_err_t esp_ota_mark_app_invalid_rollback_and_reboot() {
+    imageState = ESP_OTA_IMG_INVALID;
+    rollbacks++;
+    return ESP_OK;
+}
@@ -0,0 +1,39 @@
+#ifndef SIM_ESP_OTA_OPS_H
+#define SIM_ESP_OTA_OPS_H
+
+#include <stdint.h>
+
+// Alleen de toestand van de draaiende partitie, voor de bevestiging na een update, en de
+// beschrijving van de firmware.
+// De toestand wordt ingesteld met simSetOtaImageState().
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef enum {
+    ESP_OTA_IMG_NEW = 0x0,
+    ESP_OTA_IMG_PENDING_VERIFY = 0x1,
+    ESP_OTA_IMG_VALID = 0x2,
+    ESP_OTA_IMG_INVALID = 0x3,
+    ESP_OTA_IMG_ABORTED = 0x4,
+    ESP_OTA_IMG_UNDEFINED = 0xFFFFFFFF
+} esp_ota_img_states_t;
+
+typedef struct {
+    const char* label;
+} esp_partition_t;
+
+// Beschrijving van de draaiende firmware; de hash is in de simulatie een vaste waarde
+typedef struct {
+    uint8_t app_elf_sha256[32];
+} esp_app_desc_t;
+
+const esp_app_desc_t* esp_app_get_description();
+
+const esp_partition_t* esp_ota_get_running_partition();
+esp_err_t esp_ota_get_state_partition(const esp_partition_t* partition, esp_ota_img_states_t* state);
+esp_err_t esp_ota_mark_app_valid_cancel_rollback();
+esp_err_t esp_ota_mark_app_invalid_rollback_and_reboot();
+
+#endif // SIM_ESP_OTA_OPS_H
@@ -0,0 +1,9 @@
+#ifndef SIM_ESP_SYSTEM_H
+#define SIM_ESP_SYSTEM_H
+
+#include <stdint.h>
+
+// Pseudo-willekeurig met een vaste start, zodat een simulatie herhaalbaar is
+uint32_t esp_random();
+
+#endif // SIM_ESP_SYSTEM_H
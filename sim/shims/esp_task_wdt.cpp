@@ -0,0 +1,38 @@
+#include "esp_task_wdt.h"
+#include "SimHooks.h"
+
+static bool watchdogStarted = false;
+static uint32_t watchdogTimeoutMs = 0;
+static uint32_t watchdogFeeds = 0;
+
+esp_err_t esp_task_wdt_init(const esp_task_wdt_config_t* config) {
+    if (watchdogStarted) return ESP_FAIL;
+    watchdogStarted = true;
+    watchdogTimeoutMs = config->timeout_ms;
+    return ESP_OK;
+}
+
+// Zoals in ESP-IDF: alleen als hij al gestart is
+esp_err_t esp_task_wdt_reconfigure(const esp_task_wdt_config_t* config) {
+    if (!watchdogStarted) return ESP_FAIL;
+    watchdogTimeoutMs = config->timeout_ms;
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_add(void* task) {
+    return watchdogStarted ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_task_wdt_reset() {
+    if (!watchdogStarted) return ESP_FAIL;
+    watchdogFeeds++;
+    return ESP_OK;
+}
+
+uint32_t simGetWatchdogFeeds() {
+    return watchdogFeeds;
+}
+
+uint32_t simGetWatchdogTimeoutMs() {
+    return watchdogTimeoutMs;
+}
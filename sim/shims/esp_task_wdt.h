@@ -0,0 +1,25 @@
+#ifndef SIM_ESP_TASK_WDT_H
+#define SIM_ESP_TASK_WDT_H
+
+#include <stdint.h>
+
+// Task watchdog zoals in ESP-IDF 5; de shim telt alleen het voeden (simGetWatchdogFeeds())
+
+#ifndef ESP_OK
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#endif
+
+typedef struct {
+    uint32_t timeout_ms;
+    uint32_t idle_core_mask;
+    bool trigger_panic;
+} esp_task_wdt_config_t;
+
+esp_err_t esp_task_wdt_init(const esp_task_wdt_config_t* config);
+esp_err_t esp_task_wdt_reconfigure(const esp_task_wdt_config_t* config);
+esp_err_t esp_task_wdt_add(void* task);
+esp_err_t esp_task_wdt_reset();
+
+#endif // SIM_ESP_TASK_WDT_H
@@ -0,0 +1,9 @@
+#ifndef SIM_ESP_TIMER_H
+#define SIM_ESP_TIMER_H
+
+#include <stdint.h>
+
+// Microseconden sinds de start van de simulatie, op de virtuele klok
+int64_t esp_timer_get_time();
+
+#endif // SIM_ESP_TIMER_H
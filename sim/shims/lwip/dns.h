@@ -0,0 +1,24 @@
+#ifndef SIM_LWIP_DNS_H
+#define SIM_LWIP_DNS_H
+
+#include <stdint.h>
+
+// Resolver van lwIP. De shim zoekt direct op met getaddrinfo() en antwoordt zoals lwIP bij een
+// treffer in de cache (ERR_OK); met simSetDnsPending() komt het antwoord later via de callback.
+
+typedef int8_t err_t;
+#define ERR_OK 0
+#define ERR_INPROGRESS -5
+#define ERR_ARG -16
+
+typedef struct {
+    uint32_t addr; // Netwerkvolgorde, zoals ip4_addr_t
+} ip_addr_t;
+
+#define ip_addr_get_ip4_u32(ipaddr) ((ipaddr)->addr)
+
+typedef void (*dns_found_callback)(const char* name, const ip_addr_t* ipaddr, void* callback_arg);
+
+err_t dns_gethostbyname(const char* hostname, ip_addr_t* addr, dns_found_callback found, void* callback_arg);
+
+#endif // SIM_LWIP_DNS_H
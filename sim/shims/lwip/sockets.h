@@ -0,0 +1,12 @@
+#ifndef SIM_LWIP_SOCKETS_H
+#define SIM_LWIP_SOCKETS_H
+
+// lwIP volgt de BSD-sockets; op de host zijn dat die van het systeem
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#endif // SIM_LWIP_SOCKETS_H
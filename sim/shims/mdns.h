@@ -0,0 +1,42 @@
+#ifndef SIM_MDNS_H
+#define SIM_MDNS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Alleen de asynchrone A-record-zoekopdracht die MQTT.cpp gebruikt.
+// Elke naam wordt in de simulatie direct gevonden op het adres van de broker (simGetBrokerAddress()).
+
+#define MDNS_TYPE_A 0x0001
+#define ESP_IPADDR_TYPE_V4 0
+
+typedef struct {
+    uint32_t addr;
+} esp_ip4_addr_t;
+
+typedef struct {
+    union {
+        esp_ip4_addr_t ip4;
+    } u_addr;
+    uint8_t type;
+} esp_ip_addr_t;
+
+typedef struct mdns_ip_addr_s {
+    esp_ip_addr_t addr;
+    struct mdns_ip_addr_s* next;
+} mdns_ip_addr_t;
+
+typedef struct mdns_result_s {
+    struct mdns_result_s* next;
+    mdns_ip_addr_t* addr;
+} mdns_result_t;
+
+typedef struct mdns_search_once_s mdns_search_once_t;
+
+mdns_search_once_t* mdns_query_async_new(const char* name, const char* service, const char* proto, uint16_t type,
+                                         uint32_t timeout, size_t maxResults, void* notifier);
+bool mdns_query_async_get_results(mdns_search_once_t* search, uint32_t timeout, mdns_result_t** results, uint8_t* count);
+void mdns_query_async_delete(mdns_search_once_t* search);
+void mdns_query_results_free(mdns_result_t* results);
+
+#endif // SIM_MDNS_H